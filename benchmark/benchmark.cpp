@@ -15,6 +15,8 @@
 #include <map>
 #include <set>
 #include <queue>
+#include <filesystem>
+#include <fstream>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -26,17 +28,51 @@
 #endif
 
 #include <unistd.h>
+#include <fcntl.h>
 
 #include "event/Event.hpp"
 #include "event/EventBusMulti.hpp"
+#include "event/Dispatcher.hpp"
+#include "event/Checksum.hpp"
+#include "event/EventFactory.hpp"
 // #include "eventprocessor/event_processor.hpp"
 #include "storage_engine/storage_engine.hpp"
+#include "storage_engine/record_format.hpp"
+#include "storage_engine/storage_reader.hpp"
+#include "ingest/tcpingest_server.hpp"
+#include "ingest/client_connection.hpp"
+#ifdef __linux__
+#include "ingest/epoll_ingest_server.hpp"
+#endif
+#ifdef EVENTSTREAM_HAVE_IO_URING
+#include "ingest/uring_ingest_server.hpp"
+#endif
+#include <spdlog/spdlog.h>
+#include <functional>
+#include <memory>
+#include <random>
 #include "utils/thread_pool.hpp"
 
 using namespace std;
 using namespace std::chrono;
 using namespace EventStream;
 
+// ============================================================================
+// HEAP ALLOCATION COUNTER (operator new, while counting is switched on)
+// ============================================================================
+
+static atomic<bool> g_count_allocations{false};
+static atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    if (g_count_allocations.load(memory_order_relaxed)) g_allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
 // ============================================================================
 // BENCHMARK RESULT STRUCTURE
 // ============================================================================
@@ -180,6 +216,53 @@ public:
 };
 */
 
+// ============================================================================
+// BENCHMARK 1b: EventBusMulti lane throughput (single pop vs popBatch)
+// ============================================================================
+
+class EventBusMultiBenchmark {
+public:
+    BenchmarkResult run(int num_producers, size_t total_events, size_t batch_size) {
+        cout << "\n=== EventBusMulti Lane Test ===" << endl;
+        cout << "Producers: " << num_producers << " | Consumer batch: " << batch_size << endl;
+
+        EventBusMulti bus;
+        auto evt = makeEvent();
+        size_t per_producer = total_events / num_producers;
+        size_t expected = per_producer * num_producers;
+
+        auto start = steady_clock::now();
+        vector<thread> producers;
+        for (int p = 0; p < num_producers; p++) {
+            producers.emplace_back([&]() {
+                for (size_t j = 0; j < per_producer; j++) {
+                    while (!bus.push(EventBusMulti::QueueId::TRANSACTIONAL, evt)) this_thread::yield();
+                }
+            });
+        }
+
+        size_t received = 0;
+        vector<EventPtr> batch(batch_size);
+        while (received < expected) {
+            if (batch_size == 1) {
+                if (bus.pop(EventBusMulti::QueueId::TRANSACTIONAL, milliseconds(10)).has_value()) received++;
+            } else {
+                received += bus.popBatch(EventBusMulti::QueueId::TRANSACTIONAL, batch, milliseconds(10));
+            }
+        }
+        for (auto& t : producers) t.join();
+        double elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+
+        BenchmarkResult result{};
+        result.total_events = expected;
+        result.successful_events = received;
+        result.duration_sec = elapsed;
+        result.throughput_eps = (elapsed > 0) ? received / elapsed : 0;
+        result.print();
+        return result;
+    }
+};
+
 // ============================================================================
 // BENCHMARK 2: TCP Load Test (Client Simulation)
 // ============================================================================
@@ -293,6 +376,396 @@ public:
 };
 
 
+// ============================================================================
+// BENCHMARK 2b: Ingest Backends (in-process server, test.py frame mix)
+// ============================================================================
+
+class IngestBackendBenchmark {
+public:
+    using ServerFactory = function<unique_ptr<IngestServer>(Dispatcher&, int port)>;
+
+    // Same wire format as test.py: [4B frame_len][1B priority][2B topic_len][topic][payload]
+    static string makeFrame(const string& topic, const string& payload, uint8_t priority) {
+        string frame;
+        uint32_t frame_len = static_cast<uint32_t>(1 + 2 + topic.size() + payload.size());
+        for (int shift = 24; shift >= 0; shift -= 8) frame.push_back(static_cast<char>(frame_len >> shift));
+        frame.push_back(static_cast<char>(priority));
+        frame.push_back(static_cast<char>(topic.size() >> 8));
+        frame.push_back(static_cast<char>(topic.size() & 0xFF));
+        return frame + topic + payload;
+    }
+
+    static bool sendAll(int sock, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = send(sock, data, len, 0);
+            if (n <= 0) return false;
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Each client loop sends test.py's round: f1+f2 as one sticky write, then
+    // f1+f2 again split at a random cut. That is 4 events per round.
+    BenchmarkResult run(const string& name, const ServerFactory& factory, int port,
+                        int num_clients, int rounds_per_client) {
+        cout << "\n=== Ingest Backend Test: " << name << " ===" << endl;
+        cout << "Clients: " << num_clients << " | Rounds per client: " << rounds_per_client << endl;
+
+        EventBusMulti bus;
+        Dispatcher dispatcher(bus);
+        dispatcher.start();
+        unique_ptr<IngestServer> server = factory(dispatcher, port);
+        server->start();
+        this_thread::sleep_for(milliseconds(50));
+
+        size_t expected = static_cast<size_t>(num_clients) * rounds_per_client * 4;
+        atomic<size_t> drained{0};
+        atomic<bool> draining{true};
+        thread drain([&]() {
+            vector<EventPtr> batch(256);
+            while (drained.load() < expected && draining.load(std::memory_order_acquire)) {
+                size_t n = 0;
+                for (auto q : {EventBusMulti::QueueId::REALTIME, EventBusMulti::QueueId::TRANSACTIONAL,
+                               EventBusMulti::QueueId::BATCH}) {
+                    n += bus.popBatch(q, batch, milliseconds(0));
+                }
+                if (n == 0) this_thread::sleep_for(microseconds(100));
+                drained += n;
+            }
+        });
+
+        atomic<size_t> errors{0};
+        auto start = steady_clock::now();
+        vector<thread> clients;
+        for (int i = 0; i < num_clients; i++) {
+            clients.emplace_back([&, i]() {
+                int sock = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr{};
+                addr.sin_family = AF_INET;
+                addr.sin_port = htons(port);
+                inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+                if (sock < 0 || connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+                    errors++;
+                    if (sock >= 0) close(sock);
+                    return;
+                }
+                mt19937 rng(i);
+                static const char hex[] = "0123456789ABCDEF";
+                for (int counter = 0; counter < rounds_per_client; counter++) {
+                    string payload2 = "world" + to_string(counter);
+                    for (int k = 0; k < 40; k++) payload2.push_back(hex[rng() % 16]);
+                    string frag = makeFrame("sensor/1", "helloWorld-" + to_string(counter), 2) +
+                                  makeFrame("sensor/2", payload2, 3);
+                    size_t cut = 4 + rng() % (frag.size() - 5);
+                    if (!sendAll(sock, frag.data(), frag.size()) ||
+                        !sendAll(sock, frag.data(), cut) ||
+                        !sendAll(sock, frag.data() + cut, frag.size() - cut)) {
+                        errors++;
+                        break;
+                    }
+                }
+                close(sock);
+            });
+        }
+        for (auto& t : clients) t.join();
+
+        auto deadline = steady_clock::now() + seconds(30);
+        while (drained.load() < expected && steady_clock::now() < deadline) {
+            this_thread::sleep_for(milliseconds(1));
+        }
+        double elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+        draining.store(false, std::memory_order_release);
+        drain.join();
+        server->stop();
+        dispatcher.stop();
+
+        BenchmarkResult result{};
+        result.total_events = expected;
+        result.successful_events = drained.load();
+        result.failed_events = expected - min(expected, drained.load());
+        result.duration_sec = elapsed;
+        result.throughput_eps = (elapsed > 0) ? (drained.load() / elapsed) : 0;
+        result.print();
+        if (errors.load() > 0) cout << "Client errors: " << errors.load() << endl;
+        return result;
+    }
+};
+
+// ============================================================================
+// BENCHMARK 2c: Heap allocations per ingested event
+// ============================================================================
+
+class AllocationBenchmark {
+public:
+    // Feeds test.py's frame mix through consumeFrames in 16KB reads, into a
+    // Dispatcher whose lanes a drain thread empties, and counts every heap
+    // allocation on all threads after a warm-up pass
+    void run(size_t events_per_pass, int passes) {
+        cout << "\n=== Ingest Allocation Test ===" << endl;
+        cout << "Events per pass: " << events_per_pass << " | Measured passes: " << passes << endl;
+
+        string stream;
+        mt19937 rng(1);
+        static const char hex[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < events_per_pass; i += 2) {
+            string payload = "world" + to_string(i);
+            for (int k = 0; k < 40; k++) payload.push_back(hex[rng() % 16]);
+            stream += IngestBackendBenchmark::makeFrame("sensor/1", "helloWorld-" + to_string(i), 2);
+            stream += IngestBackendBenchmark::makeFrame("sensor/temperature", payload, 3);
+        }
+        span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(stream.data()), stream.size());
+
+        EventBusMulti bus;
+        Dispatcher dispatcher(bus);
+        dispatcher.start();
+        atomic<size_t> drained{0};
+        atomic<bool> draining{true};
+        thread drain([&]() {
+            vector<EventPtr> batch(256);
+            while (draining.load(memory_order_acquire)) {
+                size_t n = 0;
+                for (auto q : {EventBusMulti::QueueId::REALTIME, EventBusMulti::QueueId::TRANSACTIONAL,
+                               EventBusMulti::QueueId::BATCH}) {
+                    n += bus.popBatch(q, batch, milliseconds(0));
+                }
+                for (size_t i = 0; i < n; i++) batch[i] = nullptr;
+                if (n == 0) this_thread::sleep_for(microseconds(50));
+                drained += n;
+            }
+        });
+
+        ClientConnection conn(-1, "127.0.0.1:50000");
+        auto sink = [&](span<EventPtr> events) { dispatcher.pushBatchWithBackpressure(events, milliseconds(100)); };
+        auto pass = [&]() {
+            size_t target = drained.load() + events_per_pass;
+            for (size_t offset = 0; offset < bytes.size(); offset += 16384) {
+                consumeFrames(conn, bytes.subspan(offset, min<size_t>(16384, bytes.size() - offset)), sink);
+            }
+            while (drained.load() < target) this_thread::sleep_for(microseconds(100));
+        };
+
+        pass();   // warm-up: thread_local buffers, rings, pools
+        g_allocations = 0;
+        g_count_allocations = true;
+        auto start = steady_clock::now();
+        for (int i = 0; i < passes; i++) pass();
+        double elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+        g_count_allocations = false;
+        size_t allocations = g_allocations.load();
+
+        draining.store(false, memory_order_release);
+        drain.join();
+        dispatcher.stop();
+
+        size_t events = events_per_pass * static_cast<size_t>(passes);
+        cout << fixed << setprecision(3) << "Allocations: " << allocations << " | per event: "
+             << static_cast<double>(allocations) / events << " | throughput: " << setprecision(0)
+             << events / elapsed << " events/sec" << endl;
+    }
+
+    // Event::metadata before and after: an unordered_map of strings against
+    // the flat Metadata, built with the ingest path's key names and then
+    // probed for one key. Allocations are counted on the building thread;
+    // Metadata's spilled blocks come from the EventPool once it is warm.
+    void runMetadata(size_t objects, size_t lookups) {
+        cout << "\n=== Event Metadata Test ===" << endl;
+        cout << "sizeof: unordered_map " << sizeof(unordered_map<string, string>) << " B | Metadata "
+             << sizeof(Metadata) << " B | Event " << sizeof(Event) << " B" << endl;
+
+        vector<string> names = {"client_address", "tenant", "trace_id", "content_type",
+                                "schema", "region", "source", "retries"};
+        vector<string> values = {"127.0.0.1:54321", "acme", "4bf92f3577b34da6", "application/json",
+                                 "v2", "eu-west-1", "gateway", "0"};
+        vector<MetadataKey> keys;
+        for (const auto& name : names) keys.emplace_back(name);
+
+        for (size_t entries : {1, 4, 8}) {
+            vector<unordered_map<string, string>> maps(objects);
+            vector<Metadata> flat(objects);
+            size_t sink = 0;
+
+            auto measure = [&](auto&& build) {
+                g_allocations = 0;
+                g_count_allocations = true;
+                auto start = steady_clock::now();
+                for (size_t i = 0; i < objects; i++) build(i);
+                double ns = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(objects);
+                g_count_allocations = false;
+                return make_pair(ns, static_cast<double>(g_allocations.load()) / objects);
+            };
+            auto [map_build, map_allocs] = measure([&](size_t i) {
+                for (size_t e = 0; e < entries; e++) maps[i][names[e]] = values[e];
+            });
+            auto [flat_build, flat_allocs] = measure([&](size_t i) {
+                for (size_t e = 0; e < entries; e++) flat[i].set(keys[e], values[e]);
+            });
+
+            const string& probe = names[entries - 1];
+            auto start = steady_clock::now();
+            for (size_t i = 0; i < lookups; i++) sink += maps[i % objects].find(probe)->second.size();
+            double map_find = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(lookups);
+            start = steady_clock::now();
+            for (size_t i = 0; i < lookups; i++) sink += flat[i % objects].find(keys[entries - 1])->size();
+            double flat_find = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(lookups);
+
+            cout << fixed << setprecision(1) << entries << " entries | unordered_map: " << map_build
+                 << " ns build, " << map_allocs << " allocs, " << map_find << " ns find | Metadata: "
+                 << flat_build << " ns build, " << flat_allocs << " allocs, " << flat_find << " ns find"
+                 << (sink == 0 ? " " : "") << endl;
+        }
+    }
+};
+
+// ============================================================================
+// BENCHMARK 3: Dispatcher Inbound Contention
+// ============================================================================
+
+class DispatcherContentionBenchmark {
+public:
+    // Producers hammer Dispatcher::tryPush while the DispatchLoop routes into the
+    // bus and a drain thread empties it; measures the inbound queue under contention.
+    BenchmarkResult run(int num_producers, size_t total_events, size_t shards = 1) {
+        cout << "\n=== Dispatcher Contention Test ===" << endl;
+        cout << "Producers: " << num_producers << " | Shards: " << shards << endl;
+        cout << "Total events: " << total_events << endl;
+
+        EventBusMulti bus;
+        Dispatcher dispatcher(bus, shards);
+        dispatcher.start();
+
+        size_t per_producer = total_events / num_producers;
+        size_t expected = per_producer * num_producers;
+
+        // Pre-build events so allocation does not dominate the measurement
+        vector<vector<EventPtr>> events(num_producers);
+        for (int p = 0; p < num_producers; p++) {
+            events[p].reserve(per_producer);
+            for (size_t j = 0; j < per_producer; j++) {
+                auto evt = makeEvent();
+                evt->header.id = static_cast<uint32_t>(p * per_producer + j);
+                evt->header.priority = EventPriority::MEDIUM;
+                evt->header.sourceType = EventSourceType::INTERNAL;
+                evt->topic = "contention/" + to_string(j % 16);
+                events[p].push_back(std::move(evt));
+            }
+        }
+
+        atomic<size_t> drained{0};
+        atomic<bool> draining{true};
+        thread drain([&]() {
+            while (drained.load() < expected && draining.load(std::memory_order_acquire)) {
+                auto evt = bus.pop(EventBusMulti::QueueId::TRANSACTIONAL, milliseconds(10));
+                if (evt.has_value()) drained++;
+            }
+        });
+
+        atomic<size_t> retries{0};
+        auto start = steady_clock::now();
+        vector<thread> producers;
+        for (int p = 0; p < num_producers; p++) {
+            producers.emplace_back([&, p]() {
+                size_t local_retries = 0;
+                for (auto& evt : events[p]) {
+                    while (!dispatcher.tryPush(evt)) {
+                        local_retries++;
+                        this_thread::yield();
+                    }
+                }
+                retries += local_retries;
+            });
+        }
+        for (auto& t : producers) t.join();
+        double push_elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+
+        auto deadline = steady_clock::now() + seconds(10);
+        while (drained.load() < expected && steady_clock::now() < deadline) {
+            this_thread::sleep_for(milliseconds(1));
+        }
+        double elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+        draining.store(false, std::memory_order_release);
+        drain.join();
+        dispatcher.stop();
+
+        BenchmarkResult result{};
+        result.total_events = expected;
+        result.successful_events = drained.load();
+        result.failed_events = expected - drained.load();
+        result.duration_sec = elapsed;
+        result.throughput_eps = (elapsed > 0) ? (drained.load() / elapsed) : 0;
+        result.print();
+        cout << "Push-side throughput: " << (push_elapsed > 0 ? expected / push_elapsed : 0)
+             << " events/sec (" << retries.load() << " full-queue retries)" << endl;
+        return result;
+    }
+
+    // Per-event topic work of routing: priority lookup plus shard choice, by
+    // string (hash the name, probe a string-keyed map) versus by interned id
+    void runRouteBenchmark(size_t num_topics, size_t routes) {
+        cout << "\n=== Topic Routing Test ===" << endl;
+        cout << "Topics: " << num_topics << " | Routes: " << routes << endl;
+
+        auto path = filesystem::temp_directory_path() / "benchmark_topics.conf";
+        unordered_map<string, EventPriority> by_name;
+        {
+            ofstream conf(path);
+            for (size_t t = 0; t < num_topics; t += 2) {
+                string topic = "sensors/building-" + to_string(t) + "/temperature";
+                conf << topic << ": HIGH\n";
+                by_name[topic] = EventPriority::HIGH;
+            }
+        }
+        auto table = make_shared<TopicTable>();
+        table->LoadFileConfig(path.string());
+        filesystem::remove(path);
+
+        EventBusMulti bus;
+        Dispatcher dispatcher(bus);
+        dispatcher.setTopicTable(table);
+        vector<EventPtr> events;
+        vector<string> names;   // what events carried before topics were interned
+        for (size_t t = 0; t < num_topics; t++) {
+            auto evt = makeEvent();
+            names.push_back("sensors/building-" + to_string(t) + "/temperature");
+            evt->topic = names.back();
+            events.push_back(std::move(evt));
+        }
+
+        // Before interning: TopicTable::FoundTopic probed a string-keyed map
+        // under its shared_mutex and hash_modulo hashed the string again
+        shared_mutex table_mutex;
+        size_t sink = 0;
+        auto start = steady_clock::now();
+        for (size_t i = 0; i < routes; i++) {
+            const string& name = names[i % names.size()];
+            shared_lock lock(table_mutex);
+            auto it = by_name.find(name);
+            sink += (it != by_name.end() ? static_cast<size_t>(it->second) : 1) + hash<string>{}(name) % 8;
+        }
+        double by_string = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(routes);
+
+        start = steady_clock::now();
+        for (size_t i = 0; i < routes; i++) {
+            const Event& evt = *events[i % events.size()];
+            EventPriority priority = EventPriority::MEDIUM;
+            table->FoundTopic(evt.topic, priority);
+            sink += static_cast<size_t>(priority) + evt.topic.hash() % 8;
+        }
+        double by_id = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(routes);
+
+        start = steady_clock::now();
+        for (size_t i = 0; i < routes; i++) {
+            const EventPtr& evt = events[i % events.size()];
+            evt->header.priority = EventPriority::CRITICAL;
+            sink += static_cast<size_t>(dispatcher.Route(evt));
+        }
+        double route = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(routes);
+
+        cout << fixed << setprecision(1) << "By string: " << by_string << " ns/event | by id: " << by_id
+             << " ns/event | whole Route(): " << route << " ns/event" << (sink == 0 ? " " : "") << endl;
+    }
+};
+
 // ============================================================================
 // BENCHMARK 4: Storage Engine Benchmark
 // ============================================================================
@@ -304,6 +777,7 @@ private:
     atomic<size_t> writes_failed{0};
     mutex latency_mutex;
     vector<int64_t> write_latencies_ns;
+    volatile uint64_t reader_sink_ = 0;
     
 public:
     StorageBenchmark(StorageEngine* se) : storage(se) {
@@ -384,6 +858,699 @@ public:
         
         return result;
     }
+
+    // Point lookups through the offset index while writers keep appending
+    BenchmarkResult runLookupBenchmark(int num_writers, int num_readers, size_t preload, size_t lookups_per_reader) {
+        cout << "\n=== Storage Lookup Benchmark ===" << endl;
+        cout << "Preloaded events: " << preload << endl;
+        cout << "Concurrent writers: " << num_writers << " | Readers: " << num_readers << endl;
+
+        // Ids well away from the write benchmark's
+        const uint64_t base_id = 3000000000ULL;
+        auto makeBatch = [](uint64_t first, size_t count) {
+            vector<EventPtr> batch;
+            batch.reserve(count);
+            for (size_t k = 0; k < count; k++) {
+                auto evt = makeEvent();
+                evt->header.id = static_cast<uint32_t>(first + k);
+                evt->header.sourceType = EventSourceType::INTERNAL;
+                evt->topic = "storage_lookup";
+                evt->body.assign(64, static_cast<uint8_t>(k));
+                batch.push_back(move(evt));
+            }
+            return batch;
+        };
+        for (size_t i = 0; i < preload; i += 256) {
+            storage->appendBatch(makeBatch(base_id + i, min<size_t>(256, preload - i))).get();
+        }
+
+        atomic<bool> writing{true};
+        atomic<size_t> background_writes{0};
+        vector<thread> writers;
+        for (int w = 0; w < num_writers; w++) {
+            writers.emplace_back([&, w]() {
+                uint64_t next = base_id + preload + static_cast<uint64_t>(w) * 10000000ULL;
+                while (writing.load(memory_order_relaxed)) {
+                    storage->appendBatch(makeBatch(next, 64)).get();
+                    next += 64;
+                    background_writes += 64;
+                }
+            });
+        }
+
+        atomic<size_t> hits{0};
+        atomic<size_t> misses{0};
+        vector<int64_t> latencies;
+        mutex latencies_mutex;
+        auto start = steady_clock::now();
+        vector<thread> readers;
+        for (int r = 0; r < num_readers; r++) {
+            readers.emplace_back([&, r]() {
+                mt19937_64 rng(r + 1);
+                uniform_int_distribution<uint64_t> pick(0, preload - 1);
+                vector<int64_t> local;
+                local.reserve(lookups_per_reader);
+                Event evt;
+                for (size_t i = 0; i < lookups_per_reader; i++) {
+                    uint64_t id = static_cast<uint32_t>(base_id + pick(rng));
+                    auto t0 = steady_clock::now();
+                    bool found = storage->retrieveEvent(id, evt);
+                    local.push_back(duration_cast<nanoseconds>(steady_clock::now() - t0).count());
+                    (found ? hits : misses)++;
+                }
+                lock_guard<mutex> lock(latencies_mutex);
+                latencies.insert(latencies.end(), local.begin(), local.end());
+            });
+        }
+        for (auto& t : readers) t.join();
+        double elapsed = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+        writing = false;
+        for (auto& t : writers) t.join();
+
+        BenchmarkResult result{};
+        result.total_events = hits + misses;
+        result.successful_events = hits;
+        result.failed_events = misses;
+        result.duration_sec = elapsed;
+        result.throughput_eps = elapsed > 0 ? hits / elapsed : 0;
+        if (!latencies.empty()) {
+            sort(latencies.begin(), latencies.end());
+            result.latency_avg_us = accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size() / 1000.0;
+            result.latency_p50_us = latencies[latencies.size() / 2] / 1000.0;
+            result.latency_p99_us = latencies[(latencies.size() * 99) / 100] / 1000.0;
+            result.latency_max_us = latencies.back() / 1000.0;
+        }
+        result.print();
+        cout << "Events written during lookups: " << background_writes << endl;
+        return result;
+    }
+
+    // Writes num_events events, one per simulated millisecond, round-robin
+    // over num_topics topics, into a fresh log under dir
+    static void writeDataset(const string& dir, const SegmentedLog::Options& options,
+                             size_t num_events, size_t num_topics) {
+        filesystem::remove_all(dir);
+        StorageEngine dataset(dir, options);
+        for (size_t i = 0; i < num_events; i += 1000) {
+            vector<EventPtr> batch;
+            for (size_t k = i; k < min(num_events, i + 1000); k++) {
+                auto evt = makeEvent();
+                evt->header.id = static_cast<uint32_t>(k);
+                evt->header.timestamp = k * 1000000ULL;
+                evt->topic = "topic/" + to_string(k % num_topics);
+                evt->body.assign(96, static_cast<uint8_t>(k));
+                batch.push_back(move(evt));
+            }
+            dataset.appendBatch(batch).get();
+        }
+    }
+
+    static vector<filesystem::path> segmentFiles(const string& dir, size_t& total_bytes) {
+        vector<filesystem::path> segments;
+        total_bytes = 0;
+        for (const auto& entry : filesystem::directory_iterator(dir)) {
+            if (entry.path().extension() != ".log") continue;
+            segments.push_back(entry.path());
+            total_bytes += entry.file_size();
+        }
+        sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    static SegmentedLog::Options datasetOptions() {
+        SegmentedLog::Options options;
+        options.segment_bytes = 16 * 1024 * 1024;
+        options.sync_policy = SegmentedLog::SyncPolicy::Interval;
+        return options;
+    }
+
+    // "All events of one topic between T1 and T2" over a log of many
+    // segments: the time/topic index versus a linear scan of every segment
+    void runRangeQueryBenchmark(size_t num_events, size_t num_topics) {
+        cout << "\n=== Storage Range Query Benchmark ===" << endl;
+        const string dir = "benchmark/benchmark_query_log";
+        writeDataset(dir, datasetOptions(), num_events, num_topics);
+
+        StorageEngine query_storage(dir, datasetOptions());
+        size_t log_bytes = 0;
+        vector<filesystem::path> segments = segmentFiles(dir, log_bytes);
+        cout << "Events: " << num_events << " | Topics: " << num_topics
+             << " | Segments: " << segments.size() << " | Log: " << (log_bytes >> 20) << " MB" << endl;
+
+        const string topic = "topic/3";
+        for (uint64_t window_ms : {1000ULL, 10000ULL, 100000ULL}) {
+            uint64_t from = (num_events / 2) * 1000000ULL;
+            uint64_t to = from + window_ms * 1000000ULL;
+
+            auto start = steady_clock::now();
+            size_t scanned = 0;
+            for (const auto& path : segments) {
+                ifstream in(path, ios::binary);
+                vector<uint8_t> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+                span<const uint8_t> rest(bytes);
+                RecordFormat::RecordKey key;
+                while (size_t used = RecordFormat::peek(rest, key)) {
+                    if (key.timestamp >= from && key.timestamp <= to && key.topic == topic) scanned++;
+                    rest = rest.subspan(used);
+                }
+            }
+            double scan_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+
+            vector<Event> out;
+            TimeTopicIndex::QueryStats stats;
+            start = steady_clock::now();
+            query_storage.queryRange(topic, from, to, out, &stats);
+            double index_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+
+            cout << "Window " << window_ms << " ms: " << out.size() << " matches (scan found " << scanned << ")"
+                 << " | linear scan " << fixed << setprecision(2) << scan_ms << " ms"
+                 << " | indexed " << index_ms << " ms"
+                 << " | blocks read " << (stats.blocks - stats.blocks_skipped) << "/" << stats.blocks
+                 << " | segments skipped " << stats.segments_skipped << "/" << stats.segments << endl;
+        }
+        filesystem::remove_all(dir);
+    }
+
+    // Lookups of recent events, and short range queries at the head of the
+    // log, with and without the tail cache in front of the log
+    void runTailCacheBenchmark(size_t num_events, size_t cache_bytes, size_t lookups) {
+        cout << "\n=== Storage Tail Cache Benchmark ===" << endl;
+        cout << "Events: " << num_events << " | Cache: " << (cache_bytes >> 20) << " MB" << endl;
+        const string dir = "benchmark/benchmark_tail_log";
+        for (size_t bytes : {size_t{0}, cache_bytes}) {
+            filesystem::remove_all(dir);
+            StorageEngine engine(dir, datasetOptions(), 1, {}, {}, bytes);
+            for (size_t i = 0; i < num_events; i += 1000) {
+                vector<EventPtr> batch;
+                for (size_t k = i; k < min(num_events, i + 1000); k++) {
+                    auto evt = makeEvent();
+                    evt->header.id = static_cast<uint32_t>(k);
+                    evt->header.timestamp = k * 1000000ULL;
+                    evt->topic = "topic/" + to_string(k % 32);
+                    evt->body.assign(96, static_cast<uint8_t>(k));
+                    batch.push_back(move(evt));
+                }
+                engine.appendBatch(batch).get();
+            }
+
+            // The newest 10% of the events
+            mt19937_64 rng(7);
+            uniform_int_distribution<size_t> pick(num_events - num_events / 10, num_events - 1);
+            vector<int64_t> latencies;
+            latencies.reserve(lookups);
+            Event evt;
+            for (size_t i = 0; i < lookups; i++) {
+                auto t0 = steady_clock::now();
+                engine.retrieveEvent(pick(rng), evt);
+                latencies.push_back(duration_cast<nanoseconds>(steady_clock::now() - t0).count());
+            }
+            sort(latencies.begin(), latencies.end());
+            double avg_us = accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size() / 1000.0;
+
+            // One topic over the last second
+            size_t matches = 0;
+            auto start = steady_clock::now();
+            for (size_t i = 0; i < 100; i++) {
+                vector<Event> out;
+                uint64_t to = (num_events - 1 - i) * 1000000ULL;
+                matches += engine.queryRange("topic/3", to - 1000000000ULL, to, out);
+            }
+            double query_us = duration_cast<microseconds>(steady_clock::now() - start).count() / 100.0;
+
+            auto stats = engine.tailCacheStats();
+            cout << (bytes ? "Cached:   " : "Uncached: ") << fixed << setprecision(2)
+                 << "lookup avg " << avg_us << " us, p99 " << latencies[latencies.size() * 99 / 100] / 1000.0
+                 << " us | 1s query " << query_us << " us (" << matches / 100 << " matches)"
+                 << " | hits " << stats.hits << "/" << stats.hits + stats.misses
+                 << ", range hits " << stats.range_hits << "/" << stats.range_hits + stats.range_misses
+                 << " | " << stats.events << " events cached" << endl;
+        }
+        filesystem::remove_all(dir);
+    }
+
+    // Disk usage and full-scan time of a log of sensor readings, before and
+    // after compacting it into columnar segments, with a cold and a warm
+    // page cache
+    void runCompactionBenchmark(size_t num_events) {
+        cout << "\n=== Storage Compaction Benchmark ===" << endl;
+        const string dir = "benchmark/benchmark_compaction_log";
+        filesystem::remove_all(dir);
+        ColumnarSegment::CompactionOptions compaction;
+        compaction.hot_segments = 0;
+        StorageEngine compacted(dir, datasetOptions(), 1, compaction);
+        mt19937 rng(42);
+        for (size_t i = 0; i < num_events; i += 1000) {
+            vector<EventPtr> batch;
+            for (size_t k = i; k < min(num_events, i + 1000); k++) {
+                auto evt = makeEvent();
+                evt->header.id = static_cast<uint32_t>(k);
+                evt->header.timestamp = 1700000000000000000ULL + k * 1000000ULL + rng() % 1000;
+                evt->header.sourceType = EventSourceType::UDP;
+                evt->header.priority = EventPriority::MEDIUM;
+                evt->topic = "sensors/building-" + to_string(k % 8) + "/floor-" + to_string(k % 5) + "/temperature";
+                string payload = "{\"sensor_id\":" + to_string(k % 40) + ",\"unit\":\"celsius\",\"value\":" +
+                                 to_string(200 + rng() % 50) + ",\"status\":\"ok\"}";
+                evt->body.assign(payload.begin(), payload.end());
+                evt->header.crc32 = Checksum::crc32c(evt->body);
+                batch.push_back(move(evt));
+            }
+            compacted.appendBatch(batch).get();
+        }
+
+        auto diskBytes = [&] {
+            size_t bytes = 0;
+            for (const auto& entry : filesystem::directory_iterator(dir)) {
+                auto extension = entry.path().extension();
+                if (extension == ".log" || extension == ".col") bytes += entry.file_size();
+            }
+            return bytes;
+        };
+        auto dropCache = [&] {
+            for (const auto& entry : filesystem::directory_iterator(dir)) {
+                int fd = ::open(entry.path().c_str(), O_RDONLY);
+                if (fd < 0) continue;
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(fd);
+            }
+        };
+        auto scan = [&](const string& name) {
+            for (bool cold : {true, false}) {
+                if (cold) dropCache();
+                auto start = steady_clock::now();
+                StorageReader reader(dir);
+                RecordFormat::RecordView view;
+                size_t records = 0;
+                uint64_t sink = 0;
+                while (reader.next(view)) {
+                    sink += view.timestamp + view.payload.size();
+                    records++;
+                }
+                double seconds = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+                reader_sink_ = sink;
+                cout << left << setw(22) << name << setw(6) << (cold ? "cold" : "warm") << right << fixed
+                     << setprecision(1) << (records / seconds / 1e6) << " M records/s | " << setprecision(3)
+                     << seconds << " s" << endl;
+            }
+        };
+
+        size_t row_bytes = diskBytes();
+        scan("row segments");
+        auto start = steady_clock::now();
+        size_t segments = compacted.compact();
+        double compact_seconds = duration_cast<milliseconds>(steady_clock::now() - start).count() / 1000.0;
+        size_t packed_bytes = diskBytes();
+        scan("columnar segments");
+
+        cout << "Events: " << num_events << " | compacted " << segments << " segments in " << setprecision(2)
+             << compact_seconds << " s | disk " << (row_bytes >> 20) << " MB -> " << (packed_bytes >> 20)
+             << " MB (x" << setprecision(1) << (double(row_bytes) / packed_bytes) << ", active segment stays row)"
+             << endl;
+        filesystem::remove_all(dir);
+    }
+
+    // Append latency (until durable) of concurrent writers, through the page
+    // cache with an fdatasync per group commit against O_DIRECT | O_DSYNC
+    // writes from double and triple buffers
+    void runDirectIoBenchmark(int num_writers, size_t batches_per_writer, size_t batch_size) {
+        cout << "\n=== Storage Direct I/O Benchmark ===" << endl;
+        cout << "Writers: " << num_writers << " | Batches per writer: " << batches_per_writer << " | Batch: "
+             << batch_size << " events of 256 bytes" << endl;
+        const string dir = "benchmark/benchmark_direct_log";
+
+        struct Mode {
+            string name;
+            bool direct;
+            size_t buffers;
+        };
+        for (const Mode& mode : {Mode{"buffered + fdatasync", false, 0}, Mode{"O_DIRECT, 2 buffers", true, 2},
+                                 Mode{"O_DIRECT, 3 buffers", true, 3}}) {
+            filesystem::remove_all(dir);
+            SegmentedLog::Options options;
+            options.direct_io = mode.direct;
+            if (mode.direct) options.direct_buffers = mode.buffers;
+            StorageEngine storage(dir, options);
+
+            vector<vector<uint64_t>> latencies(num_writers);
+            auto start = steady_clock::now();
+            vector<thread> writers;
+            for (int w = 0; w < num_writers; w++) {
+                writers.emplace_back([&, w]() {
+                    vector<EventPtr> batch;
+                    latencies[w].reserve(batches_per_writer);
+                    for (size_t b = 0; b < batches_per_writer; b++) {
+                        batch.clear();
+                        for (size_t k = 0; k < batch_size; k++) {
+                            auto evt = makeEvent();
+                            evt->header.id = static_cast<uint32_t>((w * batches_per_writer + b) * batch_size + k);
+                            evt->topic = "direct/" + to_string(w);
+                            evt->body.assign(256, static_cast<uint8_t>(k));
+                            batch.push_back(move(evt));
+                        }
+                        auto t0 = steady_clock::now();
+                        storage.appendBatch(batch).get();
+                        latencies[w].push_back(duration_cast<nanoseconds>(steady_clock::now() - t0).count());
+                    }
+                });
+            }
+            for (auto& t : writers) t.join();
+            double seconds = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+
+            vector<uint64_t> all;
+            for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+            sort(all.begin(), all.end());
+            cout << left << setw(24) << mode.name << right << fixed << setprecision(0)
+                 << (num_writers * batches_per_writer * batch_size / seconds) << " events/s | p50 " << setprecision(1)
+                 << all[all.size() / 2] / 1000.0 << " us | p99 " << all[(all.size() * 99) / 100] / 1000.0
+                 << " us | max " << all.back() / 1000.0 << " us" << endl;
+        }
+        filesystem::remove_all(dir);
+    }
+
+    // Append latency of one writer while retention keeps the store under a
+    // size cap, deleting the oldest segments in paced batches, against the
+    // same load with retention idle
+    void runRetentionBenchmark(size_t num_batches, size_t batch_size) {
+        cout << "\n=== Storage Retention Benchmark ===" << endl;
+        const string dir = "benchmark/benchmark_retention_log";
+        SegmentedLog::Options options;
+        options.segment_bytes = 1024 * 1024;
+        options.sync_policy = SegmentedLog::SyncPolicy::Interval;
+        RetentionPolicy::Options retention;
+        retention.max_bytes = 8 * 1024 * 1024;
+        retention.delete_batch = 2;
+        retention.batch_pause = milliseconds(5);
+        cout << "Batches: " << num_batches << " x " << batch_size << " events of 128 bytes | segments 1 MB"
+             << " | cap " << (retention.max_bytes >> 20) << " MB" << endl;
+
+        for (bool enforce : {false, true}) {
+            filesystem::remove_all(dir);
+            StorageEngine storage(dir, options, 1, ColumnarSegment::CompactionOptions{}, retention);
+            atomic<bool> done{false};
+            StorageEngine::RetentionStats freed;
+            thread enforcer([&] {
+                while (!done.load()) {
+                    if (enforce) {
+                        auto stats = storage.enforceRetention(EventFactory::nowNanos());
+                        freed.segments_deleted += stats.segments_deleted;
+                        freed.bytes_freed += stats.bytes_freed;
+                    }
+                    this_thread::sleep_for(milliseconds(20));
+                }
+            });
+
+            vector<uint64_t> latencies_ns;
+            latencies_ns.reserve(num_batches);
+            vector<EventPtr> batch;
+            for (size_t b = 0; b < num_batches; b++) {
+                batch.clear();
+                for (size_t k = 0; k < batch_size; k++) {
+                    auto evt = makeEvent();
+                    evt->header.id = static_cast<uint32_t>(b * batch_size + k);
+                    evt->header.timestamp = EventFactory::nowNanos();
+                    evt->topic = "retention/" + to_string(k % 4);
+                    evt->body.assign(128, static_cast<uint8_t>(k));
+                    batch.push_back(move(evt));
+                }
+                auto start = steady_clock::now();
+                storage.appendBatch(batch).get();
+                latencies_ns.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+            }
+            done = true;
+            enforcer.join();
+
+            sort(latencies_ns.begin(), latencies_ns.end());
+            size_t disk = 0;
+            for (const auto& entry : filesystem::directory_iterator(dir)) {
+                if (entry.path().extension() == ".log") disk += entry.file_size();
+            }
+            cout << left << setw(18) << (enforce ? "retention on" : "retention off") << right << fixed
+                 << setprecision(1) << "p50 " << latencies_ns[latencies_ns.size() / 2] / 1000.0 << " us | p99 "
+                 << latencies_ns[(latencies_ns.size() * 99) / 100] / 1000.0 << " us | max "
+                 << latencies_ns.back() / 1000.0 << " us | deleted " << freed.segments_deleted << " segments, "
+                 << (freed.bytes_freed >> 20) << " MB | on disk " << (disk >> 20) << " MB" << endl;
+        }
+        filesystem::remove_all(dir);
+    }
+
+    // One writer thread per topic appending batches, over 1..16 topic-hash
+    // partitions. Under SyncPolicy::EveryBatch the device flush dominates and one
+    // log already shares it between all writers; Interval shows the writer
+    // path itself.
+    void runPartitionBenchmark(int num_writers, size_t batches_per_writer, size_t batch_size,
+                               SegmentedLog::SyncPolicy policy) {
+        cout << "\n=== Storage Partition Scaling Benchmark ===" << endl;
+        cout << "Writers: " << num_writers << " (one topic each) | Batches per writer: " << batches_per_writer
+             << " | Batch: " << batch_size << " events | Sync: "
+             << (policy == SegmentedLog::SyncPolicy::EveryBatch ? "batch" : "interval") << endl;
+        SegmentedLog::Options options;
+        options.sync_policy = policy;
+        const string dir = "benchmark/benchmark_partition_log";
+
+        double baseline = 0;
+        for (size_t partitions : {1, 2, 4, 8, 16}) {
+            filesystem::remove_all(dir);
+            StorageEngine partitioned(dir, options, partitions);
+            set<size_t> used;
+            for (int w = 0; w < num_writers; w++) used.insert(partitioned.partitionOf("partition/" + to_string(w)));
+
+            auto start = steady_clock::now();
+            vector<thread> writers;
+            for (int w = 0; w < num_writers; w++) {
+                writers.emplace_back([&, w]() {
+                    const string topic = "partition/" + to_string(w);
+                    vector<EventPtr> batch;
+                    for (size_t b = 0; b < batches_per_writer; b++) {
+                        batch.clear();
+                        for (size_t k = 0; k < batch_size; k++) {
+                            auto evt = makeEvent();
+                            evt->header.id = static_cast<uint32_t>((w * batches_per_writer + b) * batch_size + k);
+                            evt->header.timestamp = steady_clock::now().time_since_epoch().count();
+                            evt->topic = topic;
+                            evt->body.assign(128, static_cast<uint8_t>(k));
+                            batch.push_back(move(evt));
+                        }
+                        partitioned.appendBatch(batch).get();
+                    }
+                });
+            }
+            for (auto& t : writers) t.join();
+            double seconds = duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+
+            double eps = num_writers * batches_per_writer * batch_size / seconds;
+            if (partitions == 1) baseline = eps;
+            cout << "Partitions " << setw(2) << partitions << " (" << setw(2) << used.size() << " in use): "
+                 << fixed << setprecision(0) << eps << " events/s | x" << setprecision(2) << (eps / baseline) << endl;
+        }
+        filesystem::remove_all(dir);
+    }
+
+    // Restart time of a log: with its index files (only the active segment
+    // is validated), and with every index lost, where the sealed segments are
+    // validated and reindexed in the background on 1 or N threads. Open is
+    // when appends can start; ready is when the first lookup returns.
+    void runRecoveryBenchmark(size_t num_events) {
+        cout << "\n=== Storage Recovery Benchmark ===" << endl;
+        const string dir = "benchmark/benchmark_recovery_log";
+        SegmentedLog::Options options = datasetOptions();
+        writeDataset(dir, options, num_events, 32);
+        size_t log_bytes = 0;
+        vector<filesystem::path> segments = segmentFiles(dir, log_bytes);
+        size_t cores = max(1u, thread::hardware_concurrency());
+        cout << "Events: " << num_events << " | Segments: " << segments.size() << " | Log: " << (log_bytes >> 20)
+             << " MB | Cores: " << cores << " (page cache warm)" << endl;
+
+        auto restart = [&](const string& name, bool drop_indexes, size_t threads) {
+            if (drop_indexes) {
+                for (const auto& entry : filesystem::directory_iterator(dir)) {
+                    auto extension = entry.path().extension();
+                    if (extension == ".idx" || extension == ".sum") filesystem::remove(entry.path());
+                }
+            }
+            options.recovery_threads = threads;
+            auto start = steady_clock::now();
+            StorageEngine storage(dir, options);
+            double open_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+            Event event;
+            storage.retrieveEvent(static_cast<uint32_t>(num_events / 3), event);
+            double ready_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+            cout << left << setw(30) << name << right << fixed << setprecision(1) << "open " << open_ms
+                 << " ms | ready " << ready_ms << " ms | " << setprecision(2)
+                 << (log_bytes / (ready_ms / 1000.0) / 1e9) << " GB/s" << endl;
+        };
+        restart("index files intact", false, 0);
+        restart("indexes lost, 1 thread", true, 1);
+        restart("indexes lost, " + to_string(cores) + " thread(s)", true, cores);
+        filesystem::remove_all(dir);
+    }
+
+    // Full sequential pass over the log: zero-copy views from StorageReader
+    // versus decoding every record into an Event
+    void runReaderBenchmark(size_t num_events) {
+        cout << "\n=== Storage Reader Benchmark ===" << endl;
+        const string dir = "benchmark/benchmark_reader_log";
+        writeDataset(dir, datasetOptions(), num_events, 32);
+        size_t log_bytes = 0;
+        vector<filesystem::path> segments = segmentFiles(dir, log_bytes);
+        cout << "Events: " << num_events << " | Segments: " << segments.size()
+             << " | Log: " << (log_bytes >> 20) << " MB (page cache warm)" << endl;
+
+        auto report = [&](const string& name, size_t records, double seconds) {
+            cout << left << setw(28) << name << right << fixed << setprecision(2)
+                 << (log_bytes / seconds / 1e9) << " GB/s | " << (records / seconds / 1e6) << " M records/s" << endl;
+        };
+
+        for (int pass = 0; pass < 2; pass++) {
+            // Views: touch every header field and every payload byte
+            auto start = steady_clock::now();
+            StorageReader reader(dir);
+            RecordFormat::RecordView view;
+            size_t records = 0;
+            uint64_t sink = 0;
+            while (reader.next(view)) {
+                sink += view.id + view.timestamp + view.topic.size();
+                for (uint8_t b : view.payload) sink += b;
+                records++;
+            }
+            report("StorageReader views", records, duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6);
+
+            start = steady_clock::now();
+            records = 0;
+            for (const auto& path : segments) {
+                ifstream in(path, ios::binary);
+                vector<uint8_t> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+                span<const uint8_t> rest(bytes);
+                Event evt;
+                while (size_t used = RecordFormat::decode(rest, evt)) {
+                    sink += evt.header.id + evt.body.size();
+                    rest = rest.subspan(used);
+                    records++;
+                }
+            }
+            report("read + decode into Event", records, duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6);
+            reader_sink_ = sink;
+        }
+        filesystem::remove_all(dir);
+    }
+};
+
+// ============================================================================
+// BENCHMARK 5: Checksum kernels (CRC32C)
+// ============================================================================
+
+class ChecksumBenchmark {
+public:
+    using Kernel = uint32_t (*)(std::span<const uint8_t>, uint32_t);
+
+    // Throughput of each CRC32C kernel over payloads from 16B to 1MB, plus the
+    // legacy byte-at-a-time loop as the baseline.
+    void run() {
+        cout << "\n=== Checksum Kernel Test ===" << endl;
+        cout << "Runtime dispatch picked: " << Checksum::crc32cImplementation() << endl;
+
+        vector<pair<string, Kernel>> kernels = {
+            {"bytewise", &Checksum::crc32cBytewise},
+            {"slicing-by-8", &Checksum::crc32cSlicingBy8},
+        };
+        if (Checksum::sse42Supported()) kernels.emplace_back("sse4.2", &Checksum::crc32cSse42);
+        if (Checksum::sse42Supported() && Checksum::pclmulSupported()) {
+            kernels.emplace_back("sse4.2+pclmul", &Checksum::crc32cSse42Pclmul);
+        }
+
+        vector<uint8_t> buffer(1 << 20);
+        mt19937 rng(42);
+        for (auto& b : buffer) b = static_cast<uint8_t>(rng());
+
+        cout << left << setw(10) << "size";
+        for (auto& [name, kernel] : kernels) cout << setw(16) << name;
+        cout << "(GB/s)" << endl;
+
+        for (size_t size = 16; size <= buffer.size(); size *= 4) {
+            cout << setw(10) << size;
+            // Roughly 256MB of input per measurement
+            size_t iterations = max<size_t>(1, (256u << 20) / size);
+            for (auto& [name, kernel] : kernels) {
+                span<const uint8_t> data(buffer.data(), size);
+                uint32_t sink = 0;
+                auto start = steady_clock::now();
+                for (size_t i = 0; i < iterations; i++) sink ^= kernel(data, sink);
+                double elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1e9;
+                double gbps = elapsed > 0 ? (static_cast<double>(size) * iterations / elapsed) / 1e9 : 0;
+                cout << setw(16) << fixed << setprecision(2) << gbps;
+                checksum_sink_ = sink;  // keep the loop from being optimized out
+            }
+            cout << endl;
+        }
+        cout << right;
+    }
+
+private:
+    volatile uint32_t checksum_sink_ = 0;
+};
+
+// ============================================================================
+// BENCHMARK 6: Event ids and timestamps
+// ============================================================================
+
+class EventFactoryBenchmark {
+public:
+    // Cost of one EventClock reading per source, and how far it strays from
+    // system_clock across several anchor renewals
+    void runClock(size_t calls, int seconds) {
+        cout << "\n=== Event Clock Test ===" << endl;
+        auto original = EventClock::source();
+        auto wallNow = [] {
+            return static_cast<uint64_t>(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+        };
+        uint64_t sink = 0;
+        auto start = steady_clock::now();
+        for (size_t i = 0; i < calls; i++) sink += wallNow();
+        double system_ns = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(calls);
+        cout << fixed << setprecision(1) << "system_clock::now(): " << system_ns << " ns/call" << endl;
+
+        for (auto source : {EventClock::Source::TSC, EventClock::Source::COARSE, EventClock::Source::SYSTEM}) {
+            if (EventClock::setSource(source) != source) continue;
+            start = steady_clock::now();
+            for (size_t i = 0; i < calls; i++) sink += EventClock::now();
+            double ns = duration_cast<nanoseconds>(steady_clock::now() - start).count() / double(calls);
+
+            int64_t worst = 0;
+            auto until = steady_clock::now() + std::chrono::seconds(seconds);
+            while (steady_clock::now() < until) {
+                int64_t skew = static_cast<int64_t>(EventClock::now() - wallNow());
+                worst = max(worst, skew < 0 ? -skew : skew);
+                this_thread::sleep_for(milliseconds(1));
+            }
+            cout << setw(7) << EventClock::sourceName(source) << ": " << ns << " ns/call | max skew vs system_clock over "
+                 << seconds << " s: " << worst / 1000.0 << " us" << (sink == 0 ? " " : "") << endl;
+        }
+        EventClock::setSource(original);
+    }
+
+    // reserveIds(1) from several threads against one shared fetch_add per id
+    void runIds(size_t ids_per_thread) {
+        cout << "\n=== Event Id Test ===" << endl;
+        for (int threads : {1, 4, 16}) {
+            atomic<uint64_t> shared{0};
+            auto measure = [&](auto&& take) {
+                vector<thread> workers;
+                auto start = steady_clock::now();
+                for (int t = 0; t < threads; t++) {
+                    workers.emplace_back([&] {
+                        uint64_t sink = 0;
+                        for (size_t i = 0; i < ids_per_thread; i++) sink += take();
+                        if (sink == 1) cout << "";
+                    });
+                }
+                for (auto& w : workers) w.join();
+                double elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1e9;
+                return threads * ids_per_thread / elapsed / 1e6;
+            };
+            double atomic_mops = measure([&] { return shared.fetch_add(1, memory_order_relaxed); });
+            double leased_mops = measure([] { return EventFactory::reserveIds(1); });
+            cout << fixed << setprecision(1) << setw(2) << threads << " threads | shared fetch_add: " << atomic_mops
+                 << " M ids/s | leased: " << leased_mops << " M ids/s" << endl;
+        }
+    }
 };
 
 // ============================================================================
@@ -429,28 +1596,54 @@ int main(int argc, char* argv[]) {
     bool run_tcp = false;  // Requires server running
     bool run_processor = true;
     bool run_storage = true;
+    bool run_dispatcher = true;
+    bool run_ingest = false;  // Starts its own servers on ports 19400+
+    bool run_checksum = true;
+    bool run_alloc = true;
+    bool run_factory = true;
     
     for (int i = 1; i < argc; i++) {
         string arg = argv[i];
         if (arg == "--eventbus-only") {
-            run_tcp = run_processor = run_storage = false;
+            run_tcp = run_processor = run_storage = run_dispatcher = run_checksum = run_alloc = run_factory = false;
         } else if (arg == "--tcp-only") {
-            run_eventbus = run_processor = run_storage = false;
+            run_eventbus = run_processor = run_storage = run_dispatcher = run_checksum = run_alloc = run_factory = false;
             run_tcp = true;
         } else if (arg == "--processor-only") {
-            run_eventbus = run_tcp = run_storage = false;
+            run_eventbus = run_tcp = run_storage = run_dispatcher = run_checksum = run_alloc = run_factory = false;
             run_processor = true;
         } else if (arg == "--storage-only") {
-            run_eventbus = run_tcp = run_processor = false;
+            run_eventbus = run_tcp = run_processor = run_dispatcher = run_checksum = run_alloc = run_factory = false;
+        } else if (arg == "--dispatcher-only") {
+            run_eventbus = run_tcp = run_processor = run_storage = run_checksum = run_alloc = run_factory = false;
+            run_dispatcher = true;
+        } else if (arg == "--ingest-only") {
+            run_eventbus = run_tcp = run_processor = run_storage = run_dispatcher = run_checksum = run_alloc = run_factory = false;
+            run_ingest = true;
+        } else if (arg == "--checksum-only") {
+            run_eventbus = run_tcp = run_processor = run_storage = run_dispatcher = run_alloc = run_factory = false;
+            run_checksum = true;
+        } else if (arg == "--alloc-only") {
+            run_eventbus = run_tcp = run_processor = run_storage = run_dispatcher = run_checksum = run_factory = false;
+            run_alloc = true;
+        } else if (arg == "--factory-only") {
+            run_eventbus = run_tcp = run_processor = run_storage = run_dispatcher = run_checksum = run_alloc = false;
+            run_factory = true;
         } else if (arg == "--all") {
-            run_eventbus = run_tcp = run_processor = run_storage = true;
+            run_eventbus = run_tcp = run_processor = run_storage = run_dispatcher = run_checksum = run_alloc = true;
+            run_factory = true;
         } else if (arg == "--help") {
             cout << "\nUsage: ./benchmark [options]" << endl;
             cout << "Options:" << endl;
-            cout << "  --eventbus-only    EventBus throughput test only" << endl;
+            cout << "  --eventbus-only    EventBusMulti lane throughput test only" << endl;
             cout << "  --tcp-only         TCP load test (requires server on 9090)" << endl;
             cout << "  --processor-only   Event processor test only" << endl;
             cout << "  --storage-only     Storage write test only" << endl;
+            cout << "  --dispatcher-only  Dispatcher inbound contention test only" << endl;
+            cout << "  --ingest-only      threaded vs epoll vs io_uring ingest, test.py frame mix" << endl;
+            cout << "  --checksum-only    CRC32C kernels, 16B to 1MB payloads" << endl;
+            cout << "  --alloc-only       heap allocations per event on the ingest path" << endl;
+            cout << "  --factory-only     event clock sources and id reservation" << endl;
             cout << "  --all              Run all benchmarks" << endl;
             cout << "  --help             Show this message" << endl;
             return 0;
@@ -459,17 +1652,17 @@ int main(int argc, char* argv[]) {
     
     // Initialize components
     EventStream::EventBusMulti bus;
-    StorageEngine storage("benchmark/benchmark_output.txt");
+    StorageEngine storage("benchmark/benchmark_log");
     ThreadPool pool(4);
     // RealtimeProcessor processor(bus, storage, &pool);
     
     // Benchmark 1: EventBus
     if (run_eventbus) {
         cout << "\n\n[1/4] Running EventBus Benchmark..." << endl;
-        // EventBusBenchmark eb_bench(&bus);
-        // eb_bench.runThroughputTest(1, 1, 10000);
-        // eb_bench.runThroughputTest(4, 8, 50000);
-        cout << "EventBus benchmark skipped (uses legacy API)" << endl;
+        EventBusMultiBenchmark lane_bench;
+        for (size_t batch : {1, 64, 256}) {
+            lane_bench.run(4, 1 << 20, batch);
+        }
     }
     
     // Benchmark 2: TCP Load
@@ -483,14 +1676,91 @@ int main(int argc, char* argv[]) {
         tcp_gen.runLoadTest(5, 200);
         tcp_gen.runLoadTest(10, 500);
     }
-    
-    
-    // Benchmark 3: Storage
+
+    // Benchmark 2b: Ingest backends
+    if (run_ingest) {
+        cout << "\n\n[2b/4] Running Ingest Backend Benchmark..." << endl;
+        // Per-frame info logging would dominate the measurement
+        spdlog::set_level(spdlog::level::warn);
+        IngestBackendBenchmark ingest_bench;
+        vector<pair<string, IngestBackendBenchmark::ServerFactory>> backends;
+        backends.emplace_back("threaded", [](Dispatcher& d, int port) {
+            return make_unique<TcpIngestServer>(d, port);
+        });
+#ifdef __linux__
+        backends.emplace_back("epoll", [](Dispatcher& d, int port) {
+            return make_unique<EpollIngestServer>(d, port, 4, 0);
+        });
+#endif
+#ifdef EVENTSTREAM_HAVE_IO_URING
+        if (UringIngestServer::isSupported()) {
+            backends.emplace_back("io_uring", [](Dispatcher& d, int port) {
+                return make_unique<UringIngestServer>(d, port, 4, 0);
+            });
+        }
+#endif
+        int port = 19400;
+        for (auto& [name, factory] : backends) {
+            ingest_bench.run(name, factory, port++, 16, 20000);
+        }
+        spdlog::set_level(spdlog::level::info);
+    }
+
+    // Benchmark 2c: Ingest allocations
+    if (run_alloc) {
+        cout << "\n\n[2c/4] Running Ingest Allocation Benchmark..." << endl;
+        AllocationBenchmark alloc_bench;
+        alloc_bench.run(100000, 5);
+        alloc_bench.runMetadata(100000, 5000000);
+    }
+
+    // Benchmark 3: Dispatcher contention
+    if (run_dispatcher) {
+        cout << "\n\n[3/4] Running Dispatcher Contention Benchmark..." << endl;
+        DispatcherContentionBenchmark dispatcher_bench;
+        for (int producers : {1, 2, 4, 8, 16, 32, 64}) {
+            dispatcher_bench.run(producers, 1 << 20);
+        }
+        for (size_t shards : {2, 4, 8}) {
+            dispatcher_bench.run(16, 1 << 20, shards);
+        }
+        dispatcher_bench.runRouteBenchmark(64, 5000000);
+    }
+
+    // Benchmark 4: Storage
     if (run_storage) {
         cout << "\n\n[4/4] Running Storage Benchmark..." << endl;
         StorageBenchmark storage_bench(&storage);
         storage_bench.runWriteBenchmark(1, 5000);
         storage_bench.runWriteBenchmark(4, 5000);
+        // Many concurrent writers share each writev + fdatasync (group commit)
+        storage_bench.runWriteBenchmark(128, 500);
+        storage_bench.runLookupBenchmark(0, 1, 100000, 200000);
+        storage_bench.runLookupBenchmark(4, 4, 100000, 100000);
+        storage_bench.runRangeQueryBenchmark(2000000, 32);
+        storage_bench.runTailCacheBenchmark(1000000, 64 << 20, 200000);
+        storage_bench.runReaderBenchmark(2000000);
+        storage_bench.runRecoveryBenchmark(2000000);
+        storage_bench.runCompactionBenchmark(2000000);
+        storage_bench.runRetentionBenchmark(6000, 64);
+        storage_bench.runDirectIoBenchmark(8, 500, 16);
+        storage_bench.runPartitionBenchmark(16, 400, 64, SegmentedLog::SyncPolicy::EveryBatch);
+        storage_bench.runPartitionBenchmark(16, 400, 64, SegmentedLog::SyncPolicy::Interval);
+    }
+
+    // Benchmark 5: Checksum kernels
+    if (run_checksum) {
+        cout << "\n\n[5] Running Checksum Benchmark..." << endl;
+        ChecksumBenchmark checksum_bench;
+        checksum_bench.run();
+    }
+
+    // Benchmark 6: Event ids and timestamps
+    if (run_factory) {
+        cout << "\n\n[6] Running Event Factory Benchmark..." << endl;
+        EventFactoryBenchmark factory_bench;
+        factory_bench.runClock(20000000, 3);
+        factory_bench.runIds(5000000);
     }
     
     ProfilerHelper::suggestProfilingCommands();
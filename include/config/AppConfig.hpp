@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -12,6 +14,9 @@ namespace AppConfig {
         int port;
         bool enable = false;
         int maxConnections;
+        std::string mode = "threaded";  // "threaded" (thread per client), "epoll" or "io_uring"
+        int ioThreads = 4;              // epoll / io_uring modes only
+        size_t maxTopics = 65536;       // registry size past which client frames cannot add topics
     };
 
     struct UDPConfig 
@@ -42,6 +47,12 @@ namespace AppConfig {
         int shards;
         std::string strategy;
         int buffer_size;
+        // Fractions of each EventBusMulti lane's capacity for ingest backpressure
+        double high_watermark = 0.8;
+        double low_watermark = 0.5;
+        // Topic priority overrides, reloaded on change when watched
+        std::string topics_file = "config/topics.conf";
+        bool watch_topics = true;
 
     };
 
@@ -56,7 +67,44 @@ namespace AppConfig {
     struct StorageConfig
     {
         std::string backend;
-        std::string path;
+        std::string path;                        // log directory
+        size_t segment_bytes = 64 * 1024 * 1024;
+        std::string sync_policy = "batch";       // batch, interval, bytes
+        int sync_interval_ms = 10;
+        size_t sync_bytes = 1024 * 1024;
+        size_t partitions = 1;                   // independent logs, by topic hash
+        size_t recovery_threads = 0;             // startup index rebuilds per partition; 0 = one per core
+        bool direct_io = false;                  // O_DIRECT writes from aligned buffers, bypassing the page cache
+        size_t direct_io_buffers = 2;
+        size_t direct_io_buffer_bytes = 1024 * 1024;
+        size_t tail_cache_bytes = 0;             // newest records kept in memory for lookups; 0 = off
+
+        // Background rewrite of sealed segments into compressed columnar form
+        bool compaction = false;
+        size_t compaction_hot_segments = 2;      // newest sealed segments left as they are
+        int compaction_interval_ms = 5000;
+        size_t compaction_block_bytes = 64 * 1024;
+
+        // Background deletion of expired records; ages in seconds, 0 = forever
+        bool retention = false;
+        uint64_t retention_max_age_s = 0;
+        std::unordered_map<std::string, uint64_t> retention_topic_max_age_s;   // overrides max_age_s
+        uint64_t retention_max_bytes = 0;        // 0 = no size limit
+        int retention_interval_ms = 10000;
+        size_t retention_delete_batch = 4;       // segments between pauses
+        int retention_batch_pause_ms = 50;
+    };
+
+    // One-shot replay of a stored time window at startup
+    struct ReplayConfig
+    {
+        bool enable = false;
+        uint64_t from_ts = 0;                    // header.timestamp bounds, inclusive
+        uint64_t to_ts = UINT64_MAX;
+        std::string topic;                       // empty = every topic
+        std::string pace = "max";                // max, realtime, scaled
+        double speed = 1.0;                      // scaled only
+        int readers = 4;
     };
 
     struct PythonConfig
@@ -93,6 +141,7 @@ namespace AppConfig {
         Router router;
         Rule_Engine rule_engine;
         StorageConfig storage;
+        ReplayConfig replay;
         PythonConfig python;
         BoardCastConfig broadcast;
         ThreadsPoolConfig thread_pool;
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace EventStream {
+
+    // Stored in EventHeader::checksumAlgo so a reader knows how to verify crc32
+    enum struct ChecksumAlgorithm : uint8_t {
+        CRC32 = 0,    // IEEE 802.3 (zlib) polynomial, what EventFactory used before
+        CRC32C = 1,   // Castagnoli polynomial, hardware accelerated on x86-64
+    };
+
+    class Checksum {
+    public:
+        // CRC32C through the fastest kernel this CPU supports (picked once via CPUID).
+        // Pass a previous result as crc to continue over split data.
+        static uint32_t crc32c(std::span<const uint8_t> data, uint32_t crc = 0);
+
+        // IEEE CRC32, for verifying events written with ChecksumAlgorithm::CRC32
+        static uint32_t crc32(std::span<const uint8_t> data, uint32_t crc = 0);
+
+        static uint32_t compute(ChecksumAlgorithm algo, std::span<const uint8_t> data);
+
+        // Name of the CRC32C kernel selected at startup
+        static const char* crc32cImplementation();
+
+        // Individual kernels, exposed for tests and benchmarks. The hardware ones
+        // must only be called when the matching *Supported() returns true.
+        static uint32_t crc32cBytewise(std::span<const uint8_t> data, uint32_t crc = 0);
+        static uint32_t crc32cSlicingBy8(std::span<const uint8_t> data, uint32_t crc = 0);
+        static uint32_t crc32cSse42(std::span<const uint8_t> data, uint32_t crc = 0);
+        static uint32_t crc32cSse42Pclmul(std::span<const uint8_t> data, uint32_t crc = 0);
+        static bool sse42Supported();
+        static bool pclmulSupported();
+    };
+
+} // namespace EventStream
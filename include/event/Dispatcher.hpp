@@ -2,48 +2,112 @@
 #include "Event.hpp"
 #include "EventBusMulti.hpp"
 #include "Topic_table.hpp"
+#include "utils/mpsc_ring.hpp"
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <memory>
+#include <string>
 #include <vector>
-#include <mutex>
-#include <condition_variable>
-#include <deque>
+#include <array>
 #include <chrono>
+#include <deque>
 #include <optional>
+#include <span>
 #include <spdlog/spdlog.h>
 
 using namespace EventStream;
 
 class Dispatcher {
 public:
-    explicit Dispatcher(EventBusMulti& bus) : event_bus_(bus) {}
-    ~Dispatcher() { stop(); }
+    // Maps an event to a shard index in [0, shard_count). Events of one topic must
+    // always land on the same shard for per-topic ordering to hold.
+    using ShardStrategy = std::function<size_t(const Event& evt, size_t shard_count)>;
+
+    static constexpr size_t kDefaultShardCapacity = 65536;  // Increased from 8192 for burst handling
+
+    explicit Dispatcher(EventBusMulti& bus, size_t shard_count = 1,
+                        size_t shard_capacity = kDefaultShardCapacity);
+    ~Dispatcher();
 
     // lifecycle
     void start();
     void stop();
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
 
     bool tryPush(const EventPtr& evt);
-    std::optional<EventPtr> tryPop(std::chrono::milliseconds timeout);
+
+    // Moves a prefix of events into the shard rings, one ring reservation and
+    // one wake-up per run of events bound for the same shard. Returns how many
+    // were taken; events[n..) are left untouched. Events must be non-null.
+    size_t tryPushBatch(std::span<EventPtr> events);
+    std::optional<EventPtr> tryPop(std::chrono::milliseconds timeout, size_t shard = 0);
+
+    // Backpressure for producers: retries tryPush until it succeeds, the
+    // timeout expires or the dispatcher stops, sleeping while it waits.
+    bool pushWithBackpressure(const EventPtr& evt, std::chrono::milliseconds timeout);
+
+    // Batch form of pushWithBackpressure; returns how many events were taken.
+    size_t pushBatchWithBackpressure(std::span<EventPtr> events, std::chrono::milliseconds timeout);
+
+    // True while the bus is above its high watermark; ingest stops reading sockets.
+    bool isBackpressured() { return event_bus_.isPaused(); }
+
+    // Blocks until the bus drops back under its low watermark (or timeout/stop).
+    bool waitForCapacity(std::chrono::milliseconds timeout);
 
     EventBusMulti::QueueId Route(const EventPtr& evt);
 
+    // Events of topic that have gone through Route()
+    uint64_t routedEvents(Topic topic) const;
+
     void setTopicTable(std::shared_ptr<TopicTable> t) { topic_table_ = std::move(t); }
 
+    // Must be called before start()
+    void setShardStrategy(ShardStrategy strategy) { shard_strategy_ = std::move(strategy); }
+    size_t shardCount() const { return shards_.size(); }
+
+    // "hash_modulo" (interned topic hash, keeps per-topic order) or "round_robin"
+    // (spreads load evenly, ordering only holds per shard). Throws on unknown names.
+    static ShardStrategy makeShardStrategy(const std::string& name);
+
 private:
+    // Routed events a full lane refused, held per lane (in order) by the shard
+    // instead of sleeping or dropping. Capped so a stuck lane backs up inbound.
+    static constexpr size_t kMaxPendingPerShard = 4096;
+    static constexpr size_t kDispatchBatch = 256;
+    static constexpr size_t kLaneCount = 3;
+
+    struct Shard {
+        explicit Shard(size_t capacity) : inbound_queue(capacity) {}
+        // Ingest threads push concurrently, the shard's DispatchLoop is the only consumer.
+        MpscRingBuffer<EventPtr> inbound_queue;
+        ConsumerParker inbound_parker;
+        std::thread worker_thread;
+
+        std::array<std::deque<EventPtr>, kLaneCount> pending;
+        size_t pending_count = 0;
+    };
+
     EventBusMulti& event_bus_;
 
-    std::deque<EventPtr> inbound_queue_;
-    std::mutex inbound_mutex_;
-    std::condition_variable inbound_cv_;
-    size_t inbound_capacity_ = 65536;  // Increased from 8192 for burst handling
-   
-    void DispatchLoop();
-    std::thread worker_thread_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    ShardStrategy shard_strategy_;
+
+    size_t shardFor(const Event& evt) {
+        return shards_.size() == 1 ? 0 : shard_strategy_(evt, shards_.size());
+    }
+    void DispatchLoop(size_t shard_index);
+    void dispatchOne(Shard& shard, EventPtr&& evt);
+    void flushPending(Shard& shard);
     std::atomic<bool> running_{false};
 
+    // Producers blocked on backpressure park here; woken by the bus resuming
+    // and by shards draining their inbound rings.
+    ConsumerParker capacity_parker_;
+
     std::shared_ptr<TopicTable> topic_table_;
+    TopicArray<std::atomic<uint64_t>> routed_;
 };
 
 
@@ -1,9 +1,16 @@
 #pragma once  
 #include <memory>
+#include <new>
+#include <span>
 #include <string>
 #include <cstdint>
 #include <vector>   
-#include <unordered_map>    
+#include "Checksum.hpp"
+#include "EventPool.hpp"
+#include "Metadata.hpp"
+#include "Payload.hpp"
+#include "TopicRegistry.hpp"
+#include "utils/intrusive_ptr.hpp"
 
 namespace EventStream {
 
@@ -26,27 +33,47 @@ namespace EventStream {
     struct EventHeader {
         EventSourceType sourceType;
         EventPriority priority;
-        uint32_t id;
+        uint64_t id;
         uint64_t timestamp;
         uint32_t body_len;
         uint16_t topic_len;
         uint32_t crc32;
+        ChecksumAlgorithm checksumAlgo = ChecksumAlgorithm::CRC32C;  // how crc32 was computed
     };
 
-    struct Event {
+    // Plain value when decoded from storage; shared through EventPtr, which
+    // only makeEvent() creates, once it enters the pipeline
+    struct Event : RefCounted {
         EventHeader header;
-        std::string topic;
-        std::vector<uint8_t> body;
-        std::unordered_map<std::string, std::string> metadata;
+        Topic topic;
+        Payload body;
+        Metadata metadata;
         
         Event() = default;
-        Event(const EventHeader& header , std::string t, std::vector<uint8_t> b , std::unordered_map<std::string, std::string> metadata) 
-            : header(header) , topic(std::move(t)) , body(std::move(b)) , metadata(std::move(metadata)) {}
+        Event(const EventHeader& header , Topic t, std::span<const uint8_t> b , Metadata metadata) 
+            : header(header) , topic(t) , body(b) , metadata(std::move(metadata)) {}
 
-       
+        // IntrusivePtr: the last reference returns the event to its EventPool
+        void release() const noexcept {
+            if (releaseRef()) {
+                this->~Event();
+                EventPool::deallocate(const_cast<Event*>(this));
+            }
+        }
     };
 
-    using EventPtr = std::shared_ptr<Event>;
-   
+    using EventPtr = IntrusivePtr<Event>;
 
-}
\ No newline at end of file
+    // Constructs an event in a block of the calling thread's EventPool
+    template <typename... Args>
+    EventPtr makeEvent(Args&&... args) {
+        void* block = EventPool::allocate(sizeof(Event));
+        try {
+            return EventPtr(new (block) Event(std::forward<Args>(args)...));
+        } catch (...) {
+            EventPool::deallocate(block);
+            throw;
+        }
+    }
+
+}
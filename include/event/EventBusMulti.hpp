@@ -1,46 +1,86 @@
 #pragma once
 #include "Event.hpp"
-#include <mutex>
-#include <condition_variable>
-#include <deque>
+#include "utils/mpsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <span>
 #include <vector>
 #include <optional>
 
 namespace EventStream {
 
+// Three bounded lock-free lanes. Any number of threads may push; each lane is
+// drained by a single consumer at a time (the event processor).
+//
+// Flow control: the bus pauses once any lane reaches its high watermark and
+// resumes only when every lane is back under its low watermark. Upstream stages
+// (Dispatcher, ingest) poll isPaused() and stop pulling work while it holds.
 class EventBusMulti {
 public:
     enum class QueueId : int { REALTIME = 0, TRANSACTIONAL = 1, BATCH = 2};
-  
-    EventBusMulti() {
-        // Increased capacities to handle burst traffic
-        RealtimeBus_.capacity = 65536;      // High-priority queue
-        TransactionalBus_.capacity = 131072; // Default queue (most events)
-        BatchBus_.capacity = 32768;          // Low-priority batch queue
+
+    // Increased capacities to handle burst traffic (must stay powers of two)
+    EventBusMulti()
+        : RealtimeBus_(65536),        // High-priority queue
+          TransactionalBus_(131072),  // Default queue (most events)
+          BatchBus_(32768) {          // Low-priority batch queue
+        setWatermarks(kDefaultHighWatermark, kDefaultLowWatermark);
     }
     ~EventBusMulti() = default;
 
     bool push(QueueId q, const EventPtr& evt);
 
+    // Moves the longest prefix of events that fits into the lane; returns its length.
+    size_t pushBatch(QueueId q, std::span<EventPtr> events);
+
     std::optional<EventPtr> pop(QueueId q, std::chrono::milliseconds timeout);
 
+    // Waits up to timeout for the lane to become non-empty, then drains up to
+    // out.size() events in one pass. Returns the number written to out.
+    size_t popBatch(QueueId q, std::span<EventPtr> out, std::chrono::milliseconds timeout);
+
     size_t size(QueueId q) const;
 
+    // Ratios of each lane's capacity, 0 < low < high <= 1
+    void setWatermarks(double high_ratio, double low_ratio);
+
+    // Re-evaluates a stale pause, so an idle bus never stays paused. May run
+    // the resume handler, so never call it under a lock the handler takes.
+    bool isPaused();
+
+    // isPaused() without side effects: paused, and some lane still above its
+    // low watermark. Safe under any lock, e.g. in a ConsumerParker predicate.
+    bool pauseHolds() const;
+
+    // Invoked on every paused -> running transition, on whichever thread
+    // notices it: a consumer in pop()/popBatch(), or a caller of isPaused()
+    void setResumeHandler(std::function<void()> handler) { resume_handler_ = std::move(handler); }
+
+    static constexpr double kDefaultHighWatermark = 0.8;
+    static constexpr double kDefaultLowWatermark = 0.5;
+
 private:
     struct Q {
-        mutable std::mutex m;
-        std::condition_variable cv;
-        std::deque<EventPtr> dq;
-        size_t capacity = 0;
+        explicit Q(size_t capacity) : ring(capacity) {}
+        MpscRingBuffer<EventPtr> ring;
+        ConsumerParker parker;
+        size_t high_mark = 0;
+        size_t low_mark = 0;
     };
 
     Q RealtimeBus_;
     Q TransactionalBus_;
     Q BatchBus_;
-   
+
+    std::atomic<bool> paused_{false};
+    std::function<void()> resume_handler_;
+
     Q* getQueue(QueueId q) const;
+    void checkHighWatermark(const Q& queue);
+    bool belowLowWatermarks() const;
+    void maybeResume();
 };
 
 } // namespace EventStream
 
-
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+namespace EventStream {
+
+    // Event timestamps: nanoseconds since the Unix epoch, without a system
+    // call or a shared write per reading.
+    //
+    // The clock extrapolates from an anchor, a (counter, wall clock) pair
+    // that whichever thread first finds it over a second old renews. The
+    // counter is the TSC where the CPU has an invariant one, its rate
+    // calibrated against CLOCK_MONOTONIC_RAW over ever longer baselines;
+    // otherwise CLOCK_MONOTONIC_COARSE, read through the vDSO at tick
+    // resolution. Readings are strictly increasing per thread, also across
+    // re-anchoring when the wall clock has been stepped back. Between
+    // threads they agree to within the anchor's error (well under a
+    // millisecond on TSC, a tick on the coarse clock).
+    class EventClock {
+    public:
+        enum class Source : uint8_t {
+            TSC,
+            COARSE,
+            SYSTEM,   // CLOCK_REALTIME on every call
+        };
+
+        static uint64_t now() noexcept;
+
+        static Source source() noexcept;
+        // Switches source and re-anchors; TSC falls back to COARSE where the
+        // CPU lacks an invariant TSC. Returns the source now in use. For
+        // benchmarks and tests: readings around the switch may be off by the
+        // anchor error.
+        static Source setSource(Source source);
+        static bool tscSupported() noexcept;
+        static const char* sourceName(Source source) noexcept;
+    };
+
+} // namespace EventStream
@@ -1,7 +1,9 @@
 #pragma once    
 #include "Event.hpp"
+#include "EventClock.hpp"
 #include <atomic>
-#include <chrono>
+#include <span>
+#include <string_view>
 
 
 namespace EventStream {
@@ -13,10 +15,42 @@ namespace EventStream {
                                  EventPriority priority,
                                  std::vector<uint8_t>&& payload, 
                                  std::string&&  topic,
-                                 std::unordered_map<std::string, std::string>&& metadata);
+                                 Metadata&& metadata);
+
+        // Builds the event straight from views into a receive buffer; topic and
+        // payload are copied exactly once, into the event's own storage.
+        static Event createEvent(EventSourceType sourceType,
+                                 EventPriority priority,
+                                 std::span<const uint8_t> payload,
+                                 std::string_view topic,
+                                 Metadata&& metadata);
+
+        // Ids leased to one thread at a time from the global counter
+        static constexpr size_t kIdLeaseSize = 4096;
+
+        // Reserves count consecutive event ids and returns the first. Each
+        // thread takes ids kIdLeaseSize at a time from the shared counter, so
+        // most calls touch no shared cache line. Ids are unique and
+        // increasing per thread, but not ordered across threads. Used by batch
+        // producers together with the overload below.
+        static uint64_t reserveIds(size_t count);
+
+        // Same as above, with an id from reserveIds() and a timestamp the
+        // caller reads once for the whole batch, built in place in the calling
+        // thread's EventPool. The caller interns the topic, so it decides
+        // what to do with names it will not register.
+        static EventPtr createEvent(EventSourceType sourceType,
+                                 EventPriority priority,
+                                 std::span<const uint8_t> payload,
+                                 Topic topic,
+                                 Metadata&& metadata,
+                                 uint64_t id,
+                                 uint64_t timestamp);
+
+        // EventClock::now()
+        static uint64_t nowNanos();
      
     private:
-        static uint32_t calculateCRC32(const std::vector<uint8_t>& data);
         static std::atomic<uint64_t> global_event_id;
     };
    
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace EventStream {
+
+    // Size-class block allocator behind events and their payloads.
+    //
+    // Every thread allocates from its own cache: one free list per power-of-two
+    // class from 64 bytes to kMaxPooledBytes, refilled a chunk at a time. A
+    // block freed on the thread that allocated it goes straight back on that
+    // list; one freed elsewhere (an ingest thread's event released by a
+    // consumer) is pushed onto a lock-free return stack of its owning cache,
+    // which the owner takes over whole when its list runs dry. Once the
+    // pipeline has warmed up, events therefore recycle without calling
+    // malloc. Memory stays with the pool; the cache of an exiting thread is
+    // adopted by the next thread that starts allocating. Larger blocks go to
+    // the heap directly.
+    class EventPool {
+    public:
+        static constexpr size_t kMinBlockBytes = 64;
+        static constexpr size_t kMaxPooledBytes = 64 * 1024;
+
+        // Aligned to 16 bytes; never nullptr (throws std::bad_alloc)
+        static void* allocate(size_t bytes);
+        static void deallocate(void* block) noexcept;
+
+        // Usable size of a block from allocate(), at least what was asked for
+        static size_t capacity(const void* block) noexcept;
+
+        // Bytes all caches together have taken from the heap in chunks; flat
+        // once the pipeline recycles its events
+        static size_t reservedBytes() noexcept;
+    };
+
+} // namespace EventStream
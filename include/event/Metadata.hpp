@@ -0,0 +1,120 @@
+#pragma once
+#include "EventPool.hpp"
+#include "Payload.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace EventStream {
+
+    // A metadata key interned in a process-wide table, like topics in
+    // TopicRegistry but in a table of their own
+    class MetadataKey {
+    public:
+        static constexpr size_t kMaxKeys = 65536;
+
+        MetadataKey() noexcept = default;
+        // Registers name if new; throws std::length_error past kMaxKeys
+        explicit MetadataKey(std::string_view name);
+        // Never registers
+        static std::optional<MetadataKey> find(std::string_view name);
+        // id must come from the table
+        static MetadataKey fromId(uint16_t id) noexcept {
+            MetadataKey key;
+            key.id_ = id;
+            return key;
+        }
+
+        uint16_t id() const noexcept { return id_; }
+        std::string_view name() const noexcept;
+
+        friend bool operator==(MetadataKey a, MetadataKey b) noexcept { return a.id_ == b.id_; }
+
+    private:
+        uint16_t id_ = 0;
+    };
+
+    // Event metadata as a flat list of (interned key, value) pairs. Up to
+    // kInlineEntries entries and Payload::kInlineBytes of values live in the
+    // object itself, so the usual handful of short entries costs no
+    // allocation; beyond that entries and values move to EventPool blocks.
+    // Lookup is a linear scan comparing 16-bit key ids.
+    class Metadata {
+    public:
+        static constexpr size_t kInlineEntries = 4;
+        static constexpr size_t kMaxValueBytes = UINT16_MAX;
+
+        Metadata() noexcept = default;
+        Metadata(std::initializer_list<std::pair<std::string_view, std::string_view>> entries);
+        Metadata(const Metadata& other);
+        Metadata(Metadata&& other) noexcept;
+        Metadata& operator=(const Metadata& other);
+        Metadata& operator=(Metadata&& other) noexcept;
+        ~Metadata() { EventPool::deallocate(heap_slots_); }
+
+        // Adds key or replaces its value. A longer replacement leaves the old
+        // bytes unused until clear(). value must not point into this object.
+        // Throws std::length_error for values over kMaxValueBytes.
+        void set(MetadataKey key, std::string_view value);
+        void set(std::string_view key, std::string_view value) { set(MetadataKey(key), value); }
+
+        std::optional<std::string_view> find(MetadataKey key) const noexcept {
+            const Slot* slot = slotOf(key.id());
+            if (!slot) return std::nullopt;
+            return valueOf(*slot);
+        }
+        // Never registers key
+        std::optional<std::string_view> find(std::string_view key) const {
+            auto interned = MetadataKey::find(key);
+            return interned ? find(*interned) : std::nullopt;
+        }
+
+        size_t size() const noexcept { return count_; }
+        bool empty() const noexcept { return count_ == 0; }
+        void clear() noexcept {
+            count_ = 0;
+            values_.clear();
+        }
+
+        // f(std::string_view key, std::string_view value), in insertion order
+        template <typename F>
+        void forEach(F&& f) const {
+            for (const Slot* slot = slots(); slot != slots() + count_; ++slot) {
+                f(MetadataKey::fromId(slot->key).name(), valueOf(*slot));
+            }
+        }
+
+    private:
+        struct Slot {
+            uint16_t key;
+            uint16_t length;
+            uint32_t offset;
+        };
+
+        const Slot* slots() const noexcept { return heap_slots_ ? heap_slots_ : inline_slots_; }
+        Slot* slots() noexcept { return heap_slots_ ? heap_slots_ : inline_slots_; }
+
+        const Slot* slotOf(uint16_t key) const noexcept {
+            for (const Slot* slot = slots(); slot != slots() + count_; ++slot) {
+                if (slot->key == key) return slot;
+            }
+            return nullptr;
+        }
+        std::string_view valueOf(const Slot& slot) const noexcept {
+            return {reinterpret_cast<const char*>(values_.data()) + slot.offset, slot.length};
+        }
+
+        void copySlots(const Metadata& other);
+        void takeSlots(Metadata& other) noexcept;
+
+        Payload values_;                 // values back to back
+        Slot* heap_slots_ = nullptr;     // EventPool block once past kInlineEntries
+        Slot inline_slots_[kInlineEntries];
+        uint16_t count_ = 0;
+        uint16_t capacity_ = kInlineEntries;
+    };
+
+} // namespace EventStream
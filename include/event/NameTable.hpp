@@ -0,0 +1,68 @@
+#pragma once
+#include "TopicRegistry.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace EventStream {
+
+    // Append-only interner behind TopicRegistry and MetadataKeys: names get
+    // dense ids from 1 in order of first sight (0 is the empty name), and are
+    // never freed, so name(id) and hash(id) are lock-free array loads. Each
+    // thread keeps its own map of the names it has resolved; only a miss
+    // there takes the table's lock. Tables are meant to live for the whole
+    // process.
+    class NameTable {
+    public:
+        NameTable(std::string_view what, size_t max_names);
+        NameTable(const NameTable&) = delete;
+        NameTable& operator=(const NameTable&) = delete;
+
+        // Throws std::length_error once max_names are in use
+        uint32_t intern(std::string_view name);
+        // Same, but registers a new name only while fewer than limit ids are
+        // in use (the empty name counts); nullopt otherwise. Never throws.
+        std::optional<uint32_t> tryIntern(std::string_view name, size_t limit);
+        std::optional<uint32_t> find(std::string_view name);
+
+        std::string_view name(uint32_t id) const noexcept {
+            const Slot* slot = slots_.find(id);
+            return slot ? slot->name : std::string_view{};
+        }
+        uint64_t hash(uint32_t id) const noexcept {
+            const Slot* slot = id == 0 ? nullptr : slots_.find(id);
+            return slot ? slot->hash : kEmptyHash;
+        }
+        uint32_t size() const noexcept { return count_.load(std::memory_order_acquire); }
+
+    private:
+        struct Slot {
+            std::string_view name;
+            uint64_t hash = 0;
+        };
+        using Known = std::unordered_map<std::string_view, uint32_t>;
+
+        static constexpr uint64_t kEmptyHash = TopicRegistry::stableHash({});
+
+        Known& knownHere() const;
+
+        std::string what_;
+        size_t max_names_;
+        size_t index_;                 // picks this table's per-thread map
+
+        // Slots are written under mutex_ before their id is handed out
+        TopicArray<Slot> slots_;
+        std::atomic<uint32_t> count_{1};
+
+        std::mutex mutex_;
+        std::deque<std::string> storage_;   // never moves its elements
+        Known ids_;
+    };
+
+} // namespace EventStream
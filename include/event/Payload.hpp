@@ -0,0 +1,116 @@
+#pragma once
+#include "event/EventPool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace EventStream {
+
+    // Event body bytes: up to kInlineBytes held in the object itself, larger
+    // bodies in one EventPool block. Keeps the subset of std::vector<uint8_t>
+    // the code base uses, and converts to std::span<const uint8_t>.
+    class Payload {
+    public:
+        using value_type = uint8_t;
+        using size_type = size_t;
+        using iterator = uint8_t*;
+        using const_iterator = const uint8_t*;
+
+        static constexpr size_t kInlineBytes = 48;
+
+        Payload() noexcept = default;
+        Payload(std::span<const uint8_t> bytes) { assign(bytes); }
+        Payload(const Payload& other) { assign(std::span<const uint8_t>(other)); }
+        Payload(Payload&& other) noexcept { take(other); }
+        ~Payload() { EventPool::deallocate(heap_); }
+
+        Payload& operator=(const Payload& other) {
+            if (this != &other) assign(std::span<const uint8_t>(other));
+            return *this;
+        }
+        Payload& operator=(Payload&& other) noexcept {
+            if (this != &other) {
+                EventPool::deallocate(heap_);
+                take(other);
+            }
+            return *this;
+        }
+
+        // bytes must not point into this payload
+        void assign(std::span<const uint8_t> bytes) {
+            uint8_t* out = prepare(bytes.size());
+            if (!bytes.empty()) std::memcpy(out, bytes.data(), bytes.size());
+        }
+        void assign(size_t count, uint8_t value) { std::memset(prepare(count), value, count); }
+        template <typename It>
+        void assign(It first, It last) {
+            std::copy(first, last, prepare(static_cast<size_t>(std::distance(first, last))));
+        }
+
+        // Keeps the first min(size(), count) bytes; new ones are zero
+        void resize(size_t count) {
+            size_t kept = std::min(size(), count);
+            if (count > capacity_) {
+                Payload grown;
+                std::memcpy(grown.prepare(count), data(), kept);
+                *this = std::move(grown);
+            }
+            if (count > kept) std::memset(data() + kept, 0, count - kept);
+            size_ = static_cast<uint32_t>(count);
+        }
+        void clear() noexcept { size_ = 0; }
+
+        uint8_t* data() noexcept { return heap_ ? heap_ : inline_; }
+        const uint8_t* data() const noexcept { return heap_ ? heap_ : inline_; }
+        size_t size() const noexcept { return size_; }
+        size_t capacity() const noexcept { return capacity_; }
+        bool empty() const noexcept { return size_ == 0; }
+
+        iterator begin() noexcept { return data(); }
+        iterator end() noexcept { return data() + size_; }
+        const_iterator begin() const noexcept { return data(); }
+        const_iterator end() const noexcept { return data() + size_; }
+        uint8_t& operator[](size_t i) noexcept { return data()[i]; }
+        uint8_t operator[](size_t i) const noexcept { return data()[i]; }
+
+        operator std::span<const uint8_t>() const noexcept { return {data(), size_}; }
+
+        friend bool operator==(const Payload& a, const Payload& b) noexcept {
+            return std::ranges::equal(std::span<const uint8_t>(a), std::span<const uint8_t>(b));
+        }
+        friend bool operator==(const Payload& a, const std::vector<uint8_t>& b) noexcept {
+            return std::ranges::equal(std::span<const uint8_t>(a), b);
+        }
+
+    private:
+        // Room for count bytes, contents unspecified; sets the size
+        uint8_t* prepare(size_t count) {
+            if (count > capacity_) {
+                auto* block = static_cast<uint8_t*>(EventPool::allocate(count));
+                EventPool::deallocate(heap_);
+                heap_ = block;
+                capacity_ = static_cast<uint32_t>(EventPool::capacity(block));
+            }
+            size_ = static_cast<uint32_t>(count);
+            return data();
+        }
+
+        void take(Payload& other) noexcept {
+            heap_ = std::exchange(other.heap_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, static_cast<uint32_t>(kInlineBytes));
+            if (!heap_) std::memcpy(inline_, other.inline_, size_);
+        }
+
+        uint8_t* heap_ = nullptr;
+        uint32_t size_ = 0;
+        uint32_t capacity_ = kInlineBytes;
+        uint8_t inline_[kInlineBytes];
+    };
+
+} // namespace EventStream
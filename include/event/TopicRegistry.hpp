@@ -0,0 +1,132 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string_view>
+
+namespace EventStream {
+
+    // Process-wide table of topic names, each given a dense id the first time
+    // it is seen. Ids are never reused and names never freed, so an id can be
+    // turned back into its name (and its stable hash) with two array loads
+    // and no lock. Id 0 is the empty topic.
+    //
+    // Ids are only meaningful inside one process: anything persisted keeps
+    // the name.
+    class TopicRegistry {
+    public:
+        static constexpr size_t kMaxTopics = size_t{1} << 20;
+
+        // Id of name, registering it if new. Each thread remembers the names
+        // it has looked up, so only a thread's first sight of a topic takes
+        // the registry lock. Throws std::length_error past kMaxTopics.
+        static uint32_t intern(std::string_view name);
+        // For names from outside the process: registers name only while
+        // fewer than limit ids are in use, so a peer cannot fill the
+        // registry. nullopt if name is new and the limit is reached.
+        static std::optional<uint32_t> tryIntern(std::string_view name, size_t limit);
+        // Id of name if it has been registered; never registers
+        static std::optional<uint32_t> find(std::string_view name);
+
+        static std::string_view name(uint32_t id) noexcept;
+        // stableHash(name(id)), computed once at registration
+        static uint64_t hash(uint32_t id) noexcept;
+        // Ids in use are [0, size())
+        static uint32_t size() noexcept;
+
+        // FNV-1a; stable across builds and runs
+        static constexpr uint64_t stableHash(std::string_view name) noexcept {
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (char c : name) {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+    };
+
+    // Per-topic values indexed by topic id, allocated a block of ids at a time
+    // on first write. Reads and writes of existing elements take no lock.
+    template <typename T>
+    class TopicArray {
+    public:
+        static constexpr size_t kBlockSize = 1024;
+
+        constexpr TopicArray() noexcept = default;
+        TopicArray(const TopicArray&) = delete;
+        TopicArray& operator=(const TopicArray&) = delete;
+        ~TopicArray() {
+            for (auto& block : blocks_) delete[] block.load(std::memory_order_relaxed);
+        }
+
+        // Value-initialised on first access
+        T& operator[](uint32_t id) {
+            auto& slot = blocks_[id / kBlockSize];
+            T* block = slot.load(std::memory_order_acquire);
+            if (!block) {
+                T* fresh = new T[kBlockSize]();
+                if (slot.compare_exchange_strong(block, fresh, std::memory_order_acq_rel)) {
+                    block = fresh;
+                } else {
+                    delete[] fresh;
+                }
+            }
+            return block[id % kBlockSize];
+        }
+
+        // nullptr if nothing in id's block has been written yet
+        const T* find(uint32_t id) const noexcept {
+            if (id >= TopicRegistry::kMaxTopics) return nullptr;
+            const T* block = blocks_[id / kBlockSize].load(std::memory_order_acquire);
+            return block ? block + id % kBlockSize : nullptr;
+        }
+
+    private:
+        std::array<std::atomic<T*>, TopicRegistry::kMaxTopics / kBlockSize> blocks_{};
+    };
+
+    // An interned topic name: a 32-bit id that compares, hashes and indexes
+    // per-topic tables without touching the characters. Converts to the name
+    // for anything a person reads or that leaves the process.
+    class Topic {
+    public:
+        Topic() noexcept = default;
+        explicit Topic(std::string_view name) : id_(TopicRegistry::intern(name)) {}
+        Topic& operator=(std::string_view name) {
+            id_ = TopicRegistry::intern(name);
+            return *this;
+        }
+
+        // id must come from the registry
+        static Topic fromId(uint32_t id) noexcept {
+            Topic topic;
+            topic.id_ = id;
+            return topic;
+        }
+
+        uint32_t id() const noexcept { return id_; }
+        std::string_view name() const noexcept { return TopicRegistry::name(id_); }
+        uint64_t hash() const noexcept { return TopicRegistry::hash(id_); }
+        size_t size() const noexcept { return name().size(); }
+        bool empty() const noexcept { return id_ == 0; }
+
+        operator std::string_view() const noexcept { return name(); }
+
+        friend bool operator==(Topic a, Topic b) noexcept { return a.id_ == b.id_; }
+        friend bool operator==(Topic a, std::string_view b) noexcept { return a.name() == b; }
+        friend std::ostream& operator<<(std::ostream& os, Topic topic) { return os << topic.name(); }
+
+    private:
+        uint32_t id_ = 0;
+    };
+
+} // namespace EventStream
+
+template <>
+struct std::hash<EventStream::Topic> {
+    size_t operator()(EventStream::Topic topic) const noexcept { return topic.id(); }
+};
@@ -1,21 +1,61 @@
 #pragma once
 #include "Event.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
-#include <unordered_map>
-#include <shared_mutex>
+#include <thread>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 namespace EventStream {
 
+// Topic priority overrides. Readers look priorities up in an immutable
+// snapshot reached through an atomic pointer, under an Epoch::Guard and
+// without a lock; a load parses the file into a new snapshot and swaps it in
+// whole, retiring the old one once no lookup can still be using it.
 class TopicTable {
 public:
     TopicTable() = default;
+    ~TopicTable();
+    TopicTable(const TopicTable&) = delete;
+    TopicTable& operator=(const TopicTable&) = delete;
+
+    // Replaces the table with the "topic: PRIORITY" lines of path (# starts
+    // a comment). If the file cannot be read or a line does not parse, logs
+    // why and keeps serving the current table.
     bool LoadFileConfig (const std::string & path);
+    // Indexes the table by topic id
+    bool FoundTopic (Topic topic , EventPriority & priority) const;
+    // Looks the name up without registering it
     bool FoundTopic (const std::string & topic , EventPriority & priority) const;
 
+    // Reloads path whenever it is rewritten or another file is renamed over
+    // it, watching its directory with inotify from a background thread.
+    // False if the directory cannot be watched (or off Linux).
+    bool WatchFile (const std::string & path);
+    void StopWatching ();
+
+    // Tables published so far; bumped by every successful load
+    uint64_t Version () const { return version_.load(std::memory_order_acquire); }
+
 private:
-    mutable std::shared_mutex share_mutex;
-    std::unordered_map<std::string, EventPriority> Table;
+    static constexpr int8_t kUnset = -1;
+
+    struct Snapshot {
+        std::vector<int8_t> priorities;   // topic id -> EventPriority, kUnset if not configured
+        size_t configured = 0;
+    };
+
+    void WatchLoop (std::string path);
+
+    std::atomic<const Snapshot*> current_{nullptr};
+    std::atomic<uint64_t> version_{0};
+    std::mutex load_mutex_;   // one load parses and publishes at a time
+
+    std::thread watcher_;
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;        // eventfd: StopWatching
 };
 
 } // namespace EventStream
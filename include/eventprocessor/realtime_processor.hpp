@@ -6,6 +6,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <vector>
 #include "utils/thread_pool.hpp"
 
 class RealtimeProcessor : public EventProcessor {
@@ -20,4 +21,9 @@ public:
 
     virtual void processLoop() override;
 
+private:
+    // Upper bound on events drained from a lane per wakeup
+    static constexpr size_t kMaxBatch = 256;
+
+    void storeBatch(const std::vector<EventStream::EventPtr>& events);
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include "event/Dispatcher.hpp"
+#include "event/Event.hpp"
+#include "ingest/frame_buffer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+
+// Per-connection receive state shared by the ingest servers.
+struct ClientConnection {
+    ClientConnection(int fd, std::string address) : fd(fd), address(std::move(address)) {}
+
+    int fd;
+    std::string address;
+    FrameBuffer buffer;            // bytes received but not yet framed
+    bool readable = false;         // epoll: socket may still hold unread data
+};
+
+// Receives every event decoded from one read, in stream order; it may move
+// the events out of the span.
+using EventBatchSink = std::function<void(std::span<EventStream::EventPtr>)>;
+
+// Largest frame accepted before the connection is considered broken
+constexpr uint32_t MAX_FRAME_SIZE = 10 * 1024 * 1024;
+
+// Turns every complete frame at the front of conn.buffer into an event and
+// hands them to sink as one batch, with ids from a single reservation. Frames
+// are parsed in place; only the event's own topic and body are copied.
+// Returns false when the stream cannot be recovered (frame larger than
+// MAX_FRAME_SIZE); the caller must then close the connection.
+bool consumeFrames(ClientConnection& conn, const EventBatchSink& sink);
+
+// Same, for bytes that arrived in a buffer the caller has to give back (e.g.
+// an io_uring provided buffer). Whole frames are parsed straight out of
+// incoming; only a trailing partial frame is staged in conn.buffer.
+bool consumeFrames(ClientConnection& conn, std::span<const uint8_t> incoming,
+                   const EventBatchSink& sink);
+
+// Hands events to the dispatcher, blocking the calling thread (not dropping)
+// while it is over its high watermark. Gives up, logging what is dropped,
+// once running turns false or the dispatcher stops.
+void pushWithBackpressure(Dispatcher& dispatcher, std::span<EventStream::EventPtr> events,
+                          const std::atomic<bool>& running, const std::string& address);
+
+// Default for setClientTopicLimit
+constexpr size_t DEFAULT_CLIENT_TOPIC_LIMIT = 65536;
+
+// Topic names are interned for the life of the process, so frames may only
+// register a new topic while the registry holds fewer than limit names;
+// frames with any other new topic are dropped (and logged per read).
+void setClientTopicLimit(size_t limit);
+
+void closeSocket(int fd);
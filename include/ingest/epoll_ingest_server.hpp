@@ -0,0 +1,48 @@
+#pragma once
+#include "ingest_server.hpp"
+#include "ingest/client_connection.hpp"
+#include "utils/mpsc_ring.hpp"
+
+#include <deque>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Edge-triggered epoll reactor: one accept thread hands non-blocking sockets
+// to a fixed set of I/O threads, each running its own epoll loop. Thousands of
+// mostly idle connections cost a ClientConnection each instead of a thread.
+class EpollIngestServer : public IngestServer {
+public:
+    EpollIngestServer(Dispatcher& dispatcher, int port, int ioThreads, int maxConnections);
+    ~EpollIngestServer();
+    void start() override;
+    void stop() override;
+
+    int activeConnections() const { return activeConnections_.load(std::memory_order_acquire); }
+
+private:
+    struct IoThread {
+        int epoll_fd = -1;
+        int wake_fd = -1;   // eventfd: new connection handed over or shutdown
+        MpscRingBuffer<ClientConnection*> incoming{1024};
+        std::thread thread;
+    };
+
+    void acceptConnections() override;
+    void ioLoop(IoThread& io);
+    void adoptIncoming(IoThread& io,
+                       std::unordered_map<int, std::unique_ptr<ClientConnection>>& connections);
+    // Reads up to a fixed budget; false means the connection must be closed.
+    bool readConnection(ClientConnection& conn);
+
+    int serverPort;
+    int ioThreadCount;
+    int maxConnections;                   // 0 = unlimited
+    int server_fd = -1;
+    std::atomic<bool> isRunning{false};
+    std::atomic<int> activeConnections_{0};
+    std::thread acceptThread;
+    std::vector<std::unique_ptr<IoThread>> ioThreads;
+    size_t nextIoThread = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Per-connection receive buffer with a read cursor. Frames are parsed in place
+// through readable(); consume() only advances the cursor. Unread bytes are
+// moved back to the front lazily, when prepare() runs out of tail room and the
+// dead prefix is at least as large as what has to be moved.
+class FrameBuffer {
+public:
+    explicit FrameBuffer(size_t initialCapacity = 8192) : storage_(initialCapacity) {}
+
+    std::span<const uint8_t> readable() const {
+        return {storage_.data() + read_, write_ - read_};
+    }
+    size_t size() const { return write_ - read_; }
+    bool empty() const { return read_ == write_; }
+
+    void consume(size_t n) {
+        read_ += n;
+        if (read_ == write_) read_ = write_ = 0;   // cheapest compaction there is
+    }
+
+    // Returns at least minBytes of writable space after the unread data;
+    // follow with commit() for the bytes actually written.
+    std::span<uint8_t> prepare(size_t minBytes);
+    void commit(size_t n) { write_ += n; }
+
+    void append(std::span<const uint8_t> bytes);
+
+private:
+    std::vector<uint8_t> storage_;
+    size_t read_ = 0;
+    size_t write_ = 0;
+};
@@ -9,6 +9,7 @@
     class IngestServer { 
         public:
             IngestServer(Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+            virtual ~IngestServer() = default;
             virtual void start() = 0;
             virtual void stop() = 0;
 
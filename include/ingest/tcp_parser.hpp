@@ -1,6 +1,8 @@
 #pragma once
 #include "event/Event.hpp"
-#include <string> 
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #ifdef _WIN32
@@ -19,6 +21,20 @@ struct ParsedResult {
     std::vector<uint8_t> payload;
 };
 
+// Non-owning parse result: topic and payload point into the frame that was
+// parsed and are only valid while that receive buffer is left untouched.
+struct FrameView {
+    EventStream::EventPriority priority;
+    std::string_view topic;
+    std::span<const uint8_t> payload;
+};
+
+// Length of the frame body announced by the 4-byte big-endian prefix
+uint32_t peekFrameLength(std::span<const uint8_t> data);
+
+FrameView parseFrameView(std::span<const uint8_t> frame_body);
+FrameView parseTCPFrameView(std::span<const uint8_t> full_frame_include_length);
+
 ParsedResult parseFrame(const std::vector<uint8_t>& frame_body);
 ParsedResult parseTCPFrame(const std::vector<uint8_t>& full_frame_include_length);
 
@@ -16,23 +16,37 @@
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <mutex>
+#include <span>
+#include <vector>
 
 
 
     class TcpIngestServer : public IngestServer {
     public:
-        TcpIngestServer(Dispatcher& dispatcher, int port);
+        TcpIngestServer(Dispatcher& dispatcher, int port, int maxConnections = 0);
         ~TcpIngestServer();
         void start() override;
         void stop() override;
+
+        int activeConnections() const { return activeConnections_.load(std::memory_order_acquire); }
+        // Client threads not yet joined: the live ones plus any that ended
+        // since the last accept, so at most maxConnections + those
+        size_t clientThreadCount();
     
     private:
         void acceptConnections() override;
         void handleClient(int client_fd , std::string client_address);
+        // Joins the client threads whose connection has closed
+        void reapClients();
         
         int serverPort;
         int server_fd;
         std::atomic<bool> isRunning{false};
         std::thread acceptThread;
+        std::mutex clientsMutex;
         std::vector<std::thread> clientThreads;
+        std::vector<std::thread::id> finishedClients;   // handlers that returned, not yet joined
+        int maxConnections;                  // 0 = unlimited
+        std::atomic<int> activeConnections_{0};
     };
@@ -0,0 +1,39 @@
+#pragma once
+#include "ingest_server.hpp"
+#include "ingest/client_connection.hpp"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+// io_uring ingest backend: each I/O thread owns a ring with a multishot accept
+// on the shared listening socket and one multishot recv per connection. Recv
+// data lands in kernel-selected buffers from a provided buffer group, so a
+// single io_uring_enter can complete many small frames across many sockets
+// without a recv() per read.
+class UringIngestServer : public IngestServer {
+public:
+    UringIngestServer(Dispatcher& dispatcher, int port, int ioThreads, int maxConnections);
+    ~UringIngestServer();
+    void start() override;
+    void stop() override;
+
+    // Probes io_uring_setup and providing the recv buffer group
+    static bool isSupported();
+
+    int activeConnections() const { return activeConnections_.load(std::memory_order_acquire); }
+
+private:
+    class Worker;
+
+    void acceptConnections() override;
+
+    int serverPort;
+    int ioThreadCount;
+    int maxConnections;                   // 0 = unlimited
+    int server_fd = -1;
+    std::atomic<bool> isRunning{false};
+    std::atomic<int> activeConnections_{0};
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> workerThreads;
+};
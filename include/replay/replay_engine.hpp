@@ -0,0 +1,115 @@
+#pragma once
+#include "event/Dispatcher.hpp"
+#include "event/EventBusMulti.hpp"
+#include "storage_engine/storage_reader.hpp"
+#include "storage_engine/time_topic_index.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Re-injects a time window of the stored log into the live pipeline.
+//
+// The window is split into tasks: the candidate byte ranges the time/topic
+// summaries leave for sealed segments, and whole segments that have none
+// (the active one), across every partition of the store. Reader threads
+// take tasks oldest first, so paced readers move through partitions
+// together, and push matching records through the Dispatcher as new events
+// tagged EventSourceType::INTERNAL, keeping the original id, timestamp and
+// payload.
+//
+// The log is read only up to where it ended at start(), so replayed events
+// that the pipeline stores again are never replayed a second time.
+//
+// Replay yields to live traffic. Priorities are capped at max_priority
+// (MEDIUM by default, which keeps replay out of the REALTIME lane), and it
+// only pushes while the bus is not paused, the REALTIME lane holds at most
+// realtime_backlog_limit events and the other lanes at most
+// lane_backlog_limit. The last limit sits well under the high watermarks, so
+// replay alone never pauses the bus and blocks live ingest.
+class ReplayEngine {
+public:
+    enum class Pace {
+        MaxSpeed,    // as fast as backpressure allows
+        RealTime,    // original inter-event spacing
+        Scaled,      // original spacing divided by speed
+    };
+
+    struct Options {
+        uint64_t from_ts = 0;
+        uint64_t to_ts = UINT64_MAX;
+        std::string topic;                  // empty replays every topic
+        Pace pace = Pace::MaxSpeed;
+        double speed = 1.0;                 // Scaled only, > 0
+        size_t readers = 4;                 // segments read in parallel
+        size_t batch_size = 256;
+        EventStream::EventPriority max_priority = EventStream::EventPriority::MEDIUM;
+        size_t realtime_backlog_limit = 1024;
+        size_t lane_backlog_limit = 8192;
+    };
+
+    struct Stats {
+        uint64_t replayed = 0;
+        uint64_t matched = 0;    // records inside the window and topic
+        uint64_t scanned = 0;    // records read
+    };
+
+    ReplayEngine(std::string directory, Dispatcher& dispatcher, EventStream::EventBusMulti& bus, Options options);
+    ~ReplayEngine();
+
+    ReplayEngine(const ReplayEngine&) = delete;
+    ReplayEngine& operator=(const ReplayEngine&) = delete;
+
+    void start();
+    // Abandons the rest of the window
+    void stop();
+    // Blocks until every task is done or the replay was stopped
+    void wait();
+    bool finished() const { return remaining_readers_.load(std::memory_order_acquire) == 0; }
+
+    Stats stats() const;
+
+    // "max", "realtime" or "scaled"; throws on anything else
+    static Pace parsePace(const std::string& name);
+
+private:
+    struct Task {
+        size_t partition = 0;   // index into partitions_
+        StorageReader::Position begin;
+        StorageReader::Position end;
+        uint64_t first_ts = 0;  // oldest record the range holds, as far as known
+    };
+
+    void planTasks();
+    void planPartition(size_t partition);
+    void readerLoop();
+    void runTask(const Task& task, std::vector<EventStream::EventPtr>& batch);
+    bool flush(std::vector<EventStream::EventPtr>& batch);
+    bool waitForLiveHeadroom();
+    bool hasLiveHeadroom();
+    std::chrono::steady_clock::time_point dueTime(uint64_t timestamp) const;
+    bool matches(const RecordFormat::RecordView& view) const;
+    EventStream::EventPtr toEvent(const RecordFormat::RecordView& view) const;
+
+    std::string directory_;
+    Dispatcher& dispatcher_;
+    EventStream::EventBusMulti& bus_;
+    Options options_;
+
+    std::vector<std::string> partitions_;   // log directories
+    std::vector<Task> tasks_;
+    std::atomic<size_t> next_task_{0};
+    std::vector<std::thread> readers_;
+    std::atomic<size_t> remaining_readers_{0};
+    std::atomic<bool> stopping_{false};
+
+    // Pacing: record time base maps to wall-clock start_
+    uint64_t base_ts_ = 0;
+    std::chrono::steady_clock::time_point start_;
+
+    std::atomic<uint64_t> replayed_{0};
+    std::atomic<uint64_t> matched_{0};
+    std::atomic<uint64_t> scanned_{0};
+};
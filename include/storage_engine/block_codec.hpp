@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Byte-oriented LZ77 block compressor used for payload columns of compacted
+// segments. No dictionary or framing beyond the block itself, and nothing
+// outside this file, so the on-disk format does not depend on a library.
+//
+// A block is a run of sequences, each a token byte (literal count in the high
+// nibble, match length - 4 in the low one, 15 meaning "more bytes follow",
+// each adding up to 255), the literals, then a u16 little-endian match
+// offset. The last sequence has literals only. Matches reach back at most
+// 64 KiB and may overlap the bytes they produce.
+namespace BlockCodec {
+
+    // Worst case size of compress() output for n input bytes
+    size_t maxCompressedSize(size_t n);
+
+    // Appends the compressed form of in to out; returns how many bytes it added
+    size_t compress(std::span<const uint8_t> in, std::vector<uint8_t>& out);
+
+    // Fills out, which must be exactly the uncompressed size. Returns false
+    // if in is malformed or does not produce exactly out.size() bytes.
+    bool decompress(std::span<const uint8_t> in, std::span<uint8_t> out);
+
+} // namespace BlockCodec
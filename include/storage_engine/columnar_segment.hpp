@@ -0,0 +1,111 @@
+#pragma once
+#include "storage_engine/record_format.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compacted, read-only form of a sealed log segment (segment-NNNNNN.col).
+//
+// The records are cut into blocks at record boundaries, each covering a range
+// of the original segment's byte offsets, and stored column by column:
+//
+//   timestamps     first value, then zigzag varint delta-of-deltas
+//   ids            zigzag varint deltas
+//   topics         varint ids into a per-segment dictionary
+//   source, priority, checksum algorithm, crc32   one fixed-width column each
+//   payload sizes  varints
+//   payloads       concatenated and compressed with BlockCodec (or raw if
+//                  that does not help)
+//
+// Decoding a block reproduces the original row-format bytes exactly, so the
+// offset and time/topic indexes, which address records by their offset in the
+// row segment, keep working unchanged: readers locate the block holding an
+// offset, decode it and read the record from there.
+//
+// Layout: FileHeader, blocks, topic dictionary ([u32 length][bytes] each),
+// then one BlockEntry per block. Every block carries a CRC32C.
+class ColumnarSegment {
+public:
+    // Background rewriting of sealed segments, run by StorageEngine
+    struct CompactionOptions {
+        bool enable = false;
+        size_t hot_segments = 2;                    // newest sealed segments left row-format
+        std::chrono::milliseconds interval{5000};   // between compaction passes
+        size_t block_bytes = 64 * 1024;             // row bytes per block
+    };
+
+    struct Block {
+        uint64_t logical_begin;   // offsets in the row segment
+        uint64_t logical_end;
+        uint64_t file_offset;
+        uint64_t min_ts;
+        uint64_t max_ts;
+        uint32_t file_size;
+        uint32_t records;
+        uint32_t crc;
+        uint32_t reserved;
+    };
+
+    ~ColumnarSegment();
+
+    ColumnarSegment(const ColumnarSegment&) = delete;
+    ColumnarSegment& operator=(const ColumnarSegment&) = delete;
+
+    static std::string fileName(uint64_t segment);
+
+    // Writes the complete records of rows to path (through a temporary file,
+    // synced before the rename). A record failing its CRC goes into a block
+    // of its own, stored verbatim and counted in no recordCount(). Returns the
+    // size of the row bytes it covers, or 0 on failure.
+    static uint64_t write(const std::string& path, std::span<const uint8_t> rows, size_t block_bytes);
+
+    // Maps a file written by write(); nullptr if it is missing or malformed
+    static std::shared_ptr<const ColumnarSegment> open(const std::string& path);
+
+    // Size of the row segment this replaces, and of this file
+    uint64_t logicalSize() const { return logical_size_; }
+    uint64_t storedSize() const { return map_bytes_; }
+    uint64_t recordCount() const { return records_; }
+    std::span<const Block> blocks() const { return blocks_; }
+
+    // Index of the block holding row offset, or blocks().size() if none does
+    size_t blockAt(uint64_t offset) const;
+
+    // Replaces rows with the row-format bytes of one block; false if the
+    // block is corrupt
+    bool decodeBlock(size_t block, std::vector<uint8_t>& rows) const;
+
+    // Replaces rows with the row-format bytes of [begin, end), which must lie
+    // on record boundaries
+    bool read(uint64_t begin, uint64_t end, std::vector<uint8_t>& rows) const;
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t logical_size;
+        uint64_t records;
+        uint32_t blocks;
+        uint32_t topics;
+        uint64_t dictionary_offset;
+        uint64_t directory_offset;
+    };
+
+    static constexpr uint32_t kMagic = 0x4c4f4345;   // "ECOL"
+    static constexpr uint32_t kVersion = 1;
+
+    ColumnarSegment() = default;
+    bool appendBlock(size_t block, std::vector<uint8_t>& rows) const;
+
+    const uint8_t* map_ = nullptr;
+    size_t map_bytes_ = 0;
+    uint64_t logical_size_ = 0;
+    uint64_t records_ = 0;
+    std::span<const Block> blocks_;
+    std::vector<std::string_view> topics_;   // point into the mapping
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include "storage_engine/record_format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Event id -> (segment, byte offset) index over a SegmentedLog directory.
+//
+// Every sealed segment gets a sidecar segment-NNNNNN.idx holding its entries
+// sorted by id; the file is memory-mapped and searched with a binary search,
+// and its id range lets lookups skip the segment without touching it. The
+// active segment is indexed in memory and written out when it is sealed.
+// Index files are derived data: a missing or damaged one is rebuilt from its
+// segment's records on open.
+//
+// Ids are not in log order (several producers stage appends concurrently), so
+// each segment is indexed densely rather than by sampled offsets.
+class OffsetIndex {
+public:
+    struct Entry {
+        uint64_t id;
+        uint64_t offset;
+    };
+
+    struct Location {
+        uint64_t segment;
+        uint64_t offset;
+    };
+
+    explicit OffsetIndex(std::string directory);
+    ~OffsetIndex();
+
+    OffsetIndex(const OffsetIndex&) = delete;
+    OffsetIndex& operator=(const OffsetIndex&) = delete;
+
+    // Recovery, before any writes. loadSealed maps a sealed segment's index
+    // file and returns false if it is missing or malformed; buildSealed then
+    // recreates it from the segment's records. loadActive indexes the
+    // segment that will keep taking appends.
+    bool loadSealed(uint64_t segment);
+    void buildSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+    void loadActive(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+
+    // Writer thread: records carry absolute offsets within the active segment
+    void add(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+    // Writer thread: persists the active segment's entries and maps them
+    void seal(uint64_t segment);
+
+    // Retention, sealed segments only: forget one and delete its index file,
+    // or swap in the entries of a rewritten one in a single step
+    void dropSealed(uint64_t segment);
+    void replaceSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+    // Deletes only the persisted copy, which the next start rebuilds
+    void discardFile(uint64_t segment);
+
+    // Newest segment wins if an id was written more than once
+    std::optional<Location> find(uint64_t id) const;
+    // Every entry with first <= id <= last, ordered by id
+    void findRange(uint64_t first, uint64_t last, std::vector<Location>& out) const;
+
+    size_t size() const;
+
+    static std::string indexFileName(uint64_t segment);
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count;
+        uint64_t min_id;
+        uint64_t max_id;
+    };
+
+    struct SealedSegment {
+        uint64_t segment;
+        const Entry* entries;
+        size_t count;
+        uint64_t min_id;
+        uint64_t max_id;
+        void* map;
+        size_t map_bytes;
+    };
+
+    static constexpr uint32_t kMagic = 0x58444945;   // "EIDX"
+    static constexpr uint32_t kVersion = 1;
+
+    std::string pathFor(uint64_t segment, const char* suffix) const;
+    bool writeIndexFile(uint64_t segment, std::vector<Entry>& entries) const;
+    std::optional<SealedSegment> mapIndexFile(uint64_t segment) const;
+    static SealedSegment anonymousCopy(uint64_t segment, const std::vector<Entry>& entries);
+    void insertSealed(const SealedSegment& sealed);   // caller holds mutex_ exclusively
+    std::optional<SealedSegment> removeSealed(uint64_t segment);   // caller holds mutex_ exclusively
+    SealedSegment persist(uint64_t segment, std::vector<Entry>& entries) const;
+
+    std::string directory_;
+    mutable std::shared_mutex mutex_;
+    std::vector<SealedSegment> sealed_;        // ascending segment order
+    uint64_t active_segment_ = 0;
+    std::map<uint64_t, uint64_t> active_;      // id -> offset in active_segment_
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "event/Event.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// On-disk layout of one event in a log segment (little-endian, packed):
+//
+//   frame  [u32 length][u32 crc32c]
+//   body   [u64 timestamp][u8 sourceType][u8 priority][u8 checksumAlgo][u64 id]
+//          [u32 crc32][u32 topicLen][topic][u64 payloadSize][payload]
+//
+// length counts the body and crc32c covers it, so recovery can tell a torn
+// or corrupted record from a complete one. Only validate() checks the CRC;
+// the read paths trust records that recovery has already seen.
+namespace RecordFormat {
+
+    constexpr size_t kFrameSize = 4 + 4;
+    constexpr size_t kFixedHeaderSize = 8 + 1 + 1 + 1 + 8 + 4 + 4;   // of the body
+
+    size_t encodedSize(const EventStream::Event& event);
+
+    // Appends the encoded event to out
+    void encode(const EventStream::Event& event, std::vector<uint8_t>& out);
+
+    // Decodes one record from the front of data. Returns the bytes consumed,
+    // or 0 if data does not hold a complete record.
+    size_t decode(std::span<const uint8_t> data, EventStream::Event& event);
+
+    // The fields the segment indexes are keyed on
+    struct RecordKey {
+        uint64_t id;
+        uint64_t timestamp;
+        std::string_view topic;   // points into the record bytes
+    };
+
+    // What the writer hands the indexes for one record it has written
+    struct IndexedRecord {
+        uint64_t id;
+        uint64_t offset;          // within the segment (within the append while staged)
+        uint64_t size;
+        uint64_t timestamp;
+        uint64_t topicHash;
+    };
+
+    // One record seen in place: topic and payload point into the record bytes
+    struct RecordView {
+        uint64_t timestamp;
+        EventStream::EventSourceType sourceType;
+        EventStream::EventPriority priority;
+        EventStream::ChecksumAlgorithm checksumAlgo;
+        uint64_t id;
+        uint32_t crc32;
+        std::string_view topic;
+        std::span<const uint8_t> payload;
+    };
+
+    // decode() without the copies; same return convention
+    size_t decodeView(std::span<const uint8_t> data, RecordView& view);
+
+    // Appends the record view describes, byte for byte as it was decoded
+    void encode(const RecordView& view, std::vector<uint8_t>& out);
+
+    // Reads only the key fields and total size of the record at the front of
+    // data; returns the record size, or 0 if it is incomplete.
+    size_t peek(std::span<const uint8_t> data, RecordKey& key);
+
+    // Stable across builds and runs: persisted in topic bloom filters
+    uint64_t topicHash(std::string_view topic);
+    // Same value, from the one computed when the topic was interned
+    inline uint64_t topicHash(EventStream::Topic topic) { return topic.hash(); }
+
+    // How many bytes the record starting at prefix needs: its full size once
+    // the prefix covers the frame, otherwise the frame size.
+    size_t requiredSize(std::span<const uint8_t> prefix);
+
+    // Size of the record at the front of data if it is complete, well formed
+    // and matches its CRC; 0 otherwise
+    size_t validate(std::span<const uint8_t> data);
+
+    // Fills in the frame at frame for the body_size bytes that follow it;
+    // for encoders that write the body themselves
+    void sealFrame(uint8_t* frame, size_t body_size);
+
+} // namespace RecordFormat
@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Which stored records StorageEngine may drop.
+//
+// Age limits apply to header.timestamp (system clock nanoseconds): globally,
+// or per topic, where a topic's own limit replaces the global one. A zero age
+// keeps records forever. max_bytes caps the segment files of all partitions
+// together; the oldest sealed segments go first. The active segment of a
+// partition is never touched.
+class RetentionPolicy {
+public:
+    struct Options {
+        bool enable = false;
+        std::chrono::seconds max_age{0};
+        std::unordered_map<std::string, std::chrono::seconds> topic_max_age;
+        uint64_t max_bytes = 0;                        // 0: no size limit
+        std::chrono::milliseconds interval{10000};     // between retention passes
+        // Deletions and rewrites run in batches of delete_batch segments with
+        // batch_pause between them, so freeing a backlog never floods the disk
+        size_t delete_batch = 4;
+        std::chrono::milliseconds batch_pause{50};
+    };
+
+    explicit RetentionPolicy(Options options);
+
+    const Options& options() const { return options_; }
+    bool limitsAge() const { return shortest_age_.has_value(); }
+
+    // Records of topic with timestamps below the cutoff have expired;
+    // nullopt if the topic is kept forever
+    std::optional<uint64_t> cutoff(std::string_view topic, uint64_t now_ns) const;
+
+    // Below this every record has expired whatever its topic, so a segment
+    // older than it can go without being read; nullopt if some topic is
+    // kept forever
+    std::optional<uint64_t> cutoffForAll(uint64_t now_ns) const;
+
+    // Nothing at or above this can have expired yet; nullopt without age limits
+    std::optional<uint64_t> cutoffForAny(uint64_t now_ns) const;
+
+private:
+    static std::optional<uint64_t> cutoffFor(std::chrono::seconds age, uint64_t now_ns);
+
+    Options options_;
+    std::optional<std::chrono::seconds> longest_age_;   // unset if some topic is kept forever
+    std::optional<std::chrono::seconds> shortest_age_;  // unset without any age limit
+};
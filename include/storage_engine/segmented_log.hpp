@@ -0,0 +1,234 @@
+#pragma once
+#include "storage_engine/offset_index.hpp"
+#include "storage_engine/time_topic_index.hpp"
+#include "utils/mpsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Append-only log split into fixed-size segment files in one directory
+// (segment-000000.log, segment-000001.log, ...). A sealed segment may have
+// been compacted to segment-NNNNNN.col (see ColumnarSegment); offsets keep
+// referring to the row layout either way.
+//
+// Producers hand over already serialised bytes through a lock-free staging
+// ring and get a future back; a single writer thread drains the ring, turns
+// everything it finds into one writev() per batch and syncs according to the
+// SyncPolicy. A future completes once its bytes are synced, so many producers
+// share one fdatasync (group commit).
+//
+// Appends may describe the records they contain (offsets within the append);
+// the writer rebases them onto the segment and feeds the OffsetIndex and the
+// TimeTopicIndex once the bytes are written, so lookups see a record as soon
+// as a reader could pread it.
+//
+// Recovery on open: the active segment is validated record by record
+// (RecordFormat CRCs) and truncated after its last intact record, which only
+// drops writes that were never acknowledged. Sealed segments were synced
+// before they were sealed and are trusted when their index files exist; the
+// ones missing an index are validated and reindexed in the background, on
+// recovery_threads threads, while appends already run. Lookups that must see
+// every segment call waitForIndexes() first.
+//
+// With direct_io the writer bypasses the page cache: it serialises appends
+// into one of direct_buffers aligned buffers while an I/O thread writes the
+// previous ones with O_DIRECT | O_DSYNC, so every completed write is durable
+// and sync_policy no longer applies. A buffer goes out as soon as the I/O
+// thread is idle, or when it fills; appends arriving during a write batch up
+// behind it. Writes cover whole kDirectAlignment blocks, so the active
+// segment may end in zeros until the next write or seal trims it; readers
+// treat those like a record still being written. Falls back to buffered
+// writes if the filesystem refuses O_DIRECT.
+class SegmentedLog {
+public:
+    enum class SyncPolicy {
+        EveryBatch,   // fdatasync after every writev batch
+        Interval,     // at most one fdatasync per sync_interval
+        Bytes,        // once sync_bytes are unsynced (sync_interval as a backstop)
+    };
+
+    struct Options {
+        size_t segment_bytes = 64 * 1024 * 1024;
+        size_t staging_capacity = 16384;            // appends in flight, power of two
+        SyncPolicy sync_policy = SyncPolicy::EveryBatch;
+        std::chrono::milliseconds sync_interval{10};
+        size_t sync_bytes = 1024 * 1024;
+        size_t summary_block_bytes = TimeTopicIndex::kDefaultBlockBytes;   // time/topic index granularity
+        size_t recovery_threads = 0;                // index rebuilds at startup; 0: one per core
+        bool direct_io = false;
+        size_t direct_buffers = 2;                  // 2: double, 3: triple buffering
+        size_t direct_buffer_bytes = 1024 * 1024;   // multiple of kDirectAlignment
+        // Called with each append's bytes and records (offsets within the
+        // append) once they are written, before they are indexed; never for
+        // a write that failed. Runs on the writer or direct I/O thread.
+        std::function<void(std::span<const uint8_t>, std::span<const RecordFormat::IndexedRecord>)> on_written;
+    };
+
+    static constexpr size_t kDirectAlignment = 4096;
+
+    SegmentedLog(std::string directory, Options options);
+    ~SegmentedLog();
+
+    SegmentedLog(const SegmentedLog&) = delete;
+    SegmentedLog& operator=(const SegmentedLog&) = delete;
+
+    // Queues bytes for the writer; they are never split across segments.
+    // Blocks only while the staging ring is full. The future throws if the
+    // write or sync failed, or if the log was closed first.
+    std::future<void> append(std::vector<uint8_t>&& bytes,
+                             std::vector<RecordFormat::IndexedRecord>&& records = {});
+
+    // Drains everything staged, syncs and stops the writer. Idempotent.
+    void close();
+
+    const std::string& directory() const { return directory_; }
+    uint64_t activeSegment() const { return active_segment_.load(std::memory_order_acquire); }
+    const OffsetIndex& index() const { return index_; }
+    const TimeTopicIndex& timeIndex() const { return time_index_; }
+    // False if direct_io was requested but the filesystem refused O_DIRECT
+    bool directIo() const { return direct_; }
+
+    // False until the sealed segments found without indexes at startup are
+    // reindexed; waitForIndexes() blocks until then (or until close())
+    bool indexesReady() const { return indexes_ready_.load(std::memory_order_acquire); }
+    void waitForIndexes() const;
+
+    // Newest timestamp among the records found on open, nullopt if there
+    // were none; final once indexesReady()
+    std::optional<uint64_t> recoveredMaxTimestamp() const;
+
+    // Retention, sealed segments only. forgetSegment drops a segment from both
+    // indexes and deletes their files; the caller deletes the segment itself.
+    // replaceSegment renames a rewritten copy (named target plus
+    // kReplacementSuffix) over target, one of the segment's files, and swaps
+    // in its records; the index files are deleted first, so a crash part way
+    // leaves them to be rebuilt. Throws if the rename fails.
+    static constexpr std::string_view kReplacementSuffix = ".retain";
+    void forgetSegment(uint64_t segment);
+    void replaceSegment(uint64_t segment, const std::string& target,
+                        std::span<const RecordFormat::IndexedRecord> records);
+
+    static std::string segmentFileName(uint64_t index);
+    // Indices of the segment files in directory, row or compacted, ascending
+    static std::vector<uint64_t> listSegments(const std::string& directory);
+    static SyncPolicy parseSyncPolicy(const std::string& name);
+
+private:
+    struct PendingWrite {
+        std::vector<uint8_t> bytes;
+        std::vector<RecordFormat::IndexedRecord> records;   // offsets relative to bytes
+        std::promise<void> done;
+    };
+
+    static constexpr size_t kMaxBatch = 1024;   // staged appends per writev (IOV_MAX)
+
+    // direct_io: one aligned buffer, covering [file_offset, file_offset + used)
+    // of a segment. Records and futures complete when its write does.
+    struct DirectBuffer {
+        struct Free {
+            void operator()(uint8_t* p) const { std::free(p); }
+        };
+        std::unique_ptr<uint8_t, Free> data;
+        size_t used = 0;
+        uint64_t file_offset = 0;
+        uint64_t segment = 0;
+        int fd = -1;
+        std::vector<RecordFormat::IndexedRecord> records;
+        std::vector<std::promise<void>> done;
+        uint64_t appends_end = 0;   // segment offset after the last append in done
+        // With on_written: the appends ending in this buffer, as handed over
+        std::vector<std::pair<std::vector<uint8_t>, std::vector<RecordFormat::IndexedRecord>>> appends;
+    };
+
+    // Index entries of the intact records of a segment; a sealed one skips
+    // corrupt records, the active one stops at the first and is truncated there
+    std::vector<RecordFormat::IndexedRecord> scanSegment(uint64_t index) const;
+    std::vector<RecordFormat::IndexedRecord> recoverActive(uint64_t index);
+    void recoveryLoop();
+    void noteRecovered(std::span<const RecordFormat::IndexedRecord> records);
+    void noteRecovered(uint64_t timestamp);
+    void writerLoop();
+    bool openSegment(uint64_t index);
+    void writeBatch(PendingWrite* batch, size_t count);
+    void writeDirect(PendingWrite* batch, size_t count);
+    // Queues filling_ for the I/O thread and continues in a free buffer
+    void submitDirect();
+    void drainDirect();
+    bool directIdle();
+    // After a failed direct write: cuts the segment back to the last append
+    // that completed, fails the appends serialised since and starts over there
+    void recoverDirect();
+    void directLoop();
+    void writeRun(PendingWrite* batch, size_t count);
+    void maybeSync();
+    void sync();
+    void failAll(std::exception_ptr error, PendingWrite* batch, size_t count);
+
+    std::string directory_;
+    Options options_;
+    OffsetIndex index_;
+    TimeTopicIndex time_index_;
+
+    MpscRingBuffer<PendingWrite> staging_;
+    ConsumerParker data_parker_;    // writer sleeps here when the ring is empty
+    ConsumerParker space_parker_;   // producers sleep here when it is full
+    std::atomic<bool> accepting_{true};
+    std::atomic<int> appenders_{0};       // producers inside append()
+    std::atomic<bool> stopping_{false};   // writer drains and exits
+    std::thread writer_;
+
+    // Sealed segments reindexed in the background at startup
+    struct PendingRebuild {
+        uint64_t segment;
+        bool index;
+        bool summary;
+    };
+    std::vector<PendingRebuild> rebuilds_;
+    std::atomic<size_t> next_rebuild_{0};
+    std::atomic<size_t> rebuilders_{0};
+    std::atomic<bool> indexes_ready_{true};
+    mutable std::mutex rebuild_mutex_;
+    mutable std::condition_variable rebuild_cv_;
+    std::vector<std::thread> recovery_;
+    std::atomic<uint64_t> recovered_max_ts_{0};
+    std::atomic<bool> recovered_any_{false};
+
+    // direct_io: free buffers, and the ones queued or being written, in order
+    bool direct_ = false;
+    std::vector<std::unique_ptr<DirectBuffer>> direct_free_;
+    std::deque<std::unique_ptr<DirectBuffer>> direct_queue_;
+    std::mutex direct_mutex_;
+    std::condition_variable direct_cv_;
+    bool direct_stopping_ = false;
+    std::thread direct_thread_;
+    // Set by the I/O thread on a failed write; until the writer recovers it
+    // fails every buffer queued behind, unwritten
+    std::atomic<bool> direct_failed_{false};
+    std::exception_ptr direct_error_;
+    uint64_t durable_end_ = 0;   // active segment offset after the last append written
+
+    // Writer thread only
+    std::unique_ptr<DirectBuffer> filling_;   // direct_io: being serialised into
+    int fd_ = -1;
+    size_t segment_size_ = 0;
+    size_t unsynced_bytes_ = 0;
+    std::vector<std::promise<void>> awaiting_sync_;
+    std::vector<RecordFormat::IndexedRecord> index_scratch_;
+    std::chrono::steady_clock::time_point last_sync_;
+    std::atomic<uint64_t> active_segment_{0};
+};
@@ -1,18 +1,173 @@
 #pragma once
 #include "event/Event.hpp"
-#include <string> 
+#include "storage_engine/columnar_segment.hpp"
+#include "storage_engine/retention_policy.hpp"
+#include "storage_engine/segmented_log.hpp"
+#include "storage_engine/tail_cache.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
 #include <mutex>
-#include <fstream>
+#include <shared_mutex>
+#include <span>
+#include <string> 
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+// Persists events to segmented append-only logs under storagePath (a directory).
+//
+// Events are partitioned by topic hash into independent SegmentedLogs, each
+// with its own group-commit writer and indexes, so writers on different topics
+// never share a queue or a file. All events of a topic land in one partition
+// and keep their append order there. With one partition the log lives directly
+// in storagePath; with more, in storagePath/partition-NN. The layout on disk
+// wins over the requested count, since moving topics would lose their order.
+// Partitions recover in parallel when opened (see SegmentedLog); lookups
+// wait for their partition's background index rebuilds, appends never do.
+//
+// With compaction enabled a background thread rewrites sealed segments, all
+// but the newest hot_segments of each partition, into ColumnarSegments and
+// deletes the row files. Every read path decodes them transparently.
+//
+// With retention enabled the same thread applies the RetentionPolicy to
+// sealed segments: one whose records have all expired is deleted unread,
+// one holding some expired records is rewritten without them, in its own
+// format, and the oldest are deleted while the store is over max_bytes.
+// A segment and its indexes are swapped under a per-partition lock that
+// lookups hold shared, so a lookup sees either the old or the new version.
+// The write path never takes it. StorageReaders already positioned in a
+// rewritten segment may skip the rest of it.
+//
+// With tail_cache_bytes set, each partition keeps a TailCache of its newest
+// records (an equal share of the bytes), filled by the log's writer once
+// each append is written, so it never holds a record that is not on disk.
+// retrieveEvent and queryRange answer from it without I/O when it covers the
+// request.
 class StorageEngine {
 public:
-    StorageEngine(const std::string& storagePath);
+    struct RetentionStats {
+        size_t segments_deleted = 0;
+        size_t segments_rewritten = 0;
+        uint64_t records_dropped = 0;
+        uint64_t bytes_freed = 0;
+    };
+
+    // Range lookups count once per partition they read
+    struct TailCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t range_hits = 0;
+        uint64_t range_misses = 0;
+        size_t events = 0;
+        size_t bytes = 0;
+    };
+
+    explicit StorageEngine(const std::string& storagePath,
+                           SegmentedLog::Options options = SegmentedLog::Options{},
+                           size_t partitions = 1,
+                           ColumnarSegment::CompactionOptions compaction = ColumnarSegment::CompactionOptions{},
+                           RetentionPolicy::Options retention = RetentionPolicy::Options{},
+                           size_t tailCacheBytes = 0);
     ~StorageEngine();
 
+    // Blocks until the event is durable under the configured sync policy; throws on failure.
     void storeEvent(const EventStream::Event& event);
+
+    // Non-blocking forms: serialise on the calling thread, complete with the group commit.
+    std::future<void> appendEvent(const EventStream::Event& event);
+    std::future<void> appendBatch(std::span<const EventStream::EventPtr> events);
+
+    // Point lookup through the offset index; false if the id was never written.
+    // Records become visible once written, before their group commit syncs.
     bool retrieveEvent(uint64_t eventId, EventStream::Event& event);
 
+    // Appends every stored event with firstId <= id <= lastId to out, in id
+    // order; returns how many were appended.
+    size_t retrieveRange(uint64_t firstId, uint64_t lastId, std::vector<EventStream::Event>& out);
+
+    // Appends every stored event of topic (any topic if empty) with
+    // fromTs <= header.timestamp <= toTs to out, in log order per partition
+    // (arrival order where the tail cache answers). A topic query reads one
+    // partition. Segments and blocks the time/topic index rules out are never
+    // read.
+    size_t queryRange(std::string_view topic, uint64_t fromTs, uint64_t toTs,
+                      std::vector<EventStream::Event>& out, TimeTopicIndex::QueryStats* stats = nullptr);
+
+    // One compaction pass over every partition, whether or not the
+    // background thread is enabled; returns how many segments it compacted
+    size_t compact();
+
+    // One retention pass as of now_ns (system clock nanoseconds), whether or
+    // not the background thread is enabled
+    RetentionStats enforceRetention(uint64_t now_ns);
+
+    TailCacheStats tailCacheStats() const;
+
+    const std::string& path() const { return storagePath; }
+    size_t partitionCount() const { return partitions.size(); }
+    size_t partitionOf(std::string_view topic) const;
+    size_t partitionOf(EventStream::Topic topic) const;
+
+    // The log directories of the store at storagePath, in partition order
+    static std::vector<std::string> partitionDirectories(const std::string& storagePath);
+    static std::string partitionDirectoryName(size_t partition);
+
 private:
-    std::ofstream storageFile;
-    std::mutex storageMutex;
-};
\ No newline at end of file
+    // A segment open for reading: a descriptor on the row file, or the
+    // compacted copy. Readers hold it while they use it, so compaction can
+    // swap it out underneath them.
+    struct SegmentFile {
+        ~SegmentFile();
+
+        int fd = -1;
+        std::shared_ptr<const ColumnarSegment> columnar;
+    };
+
+    struct Partition {
+        Partition(const std::string& directory, const SegmentedLog::Options& options, size_t cacheBytes);
+
+        // Before log: the writer fills it until the log is closed
+        TailCache cache;
+        SegmentedLog log;
+        // Lookups hold it shared from the index lookup to the read; retention
+        // holds it exclusively while it swaps a segment and its indexes
+        std::shared_mutex segments_mutex;
+        // Per segment, opened on first lookup
+        std::shared_mutex readers_mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<const SegmentFile>> readers;
+        // Retention: segments it read and kept whole, and when to look again
+        std::unordered_map<uint64_t, uint64_t> retention_recheck;
+    };
+
+    bool readRecord(Partition& partition, const OffsetIndex::Location& location, EventStream::Event& event);
+    std::shared_ptr<const SegmentFile> segmentReader(Partition& partition, uint64_t segment);
+    size_t queryPartition(Partition& partition, std::string_view topic, uint64_t fromTs, uint64_t toTs,
+                          std::vector<EventStream::Event>& out, TimeTopicIndex::QueryStats* stats);
+    size_t compactPartition(Partition& partition);
+    void deleteSegment(Partition& partition, const TimeTopicIndex::SegmentRange& range, RetentionStats& stats);
+    void filterSegment(Partition& partition, const TimeTopicIndex::SegmentRange& range, uint64_t now_ns,
+                       RetentionStats& stats);
+    bool readSegment(Partition& partition, uint64_t segment, std::vector<uint8_t>& rows);
+    void maintenanceLoop();
+    // Sleeps between retention batches; false once the engine is shutting down
+    bool pauseMaintenance(std::chrono::milliseconds pause);
+
+    std::string storagePath;
+    std::vector<std::unique_ptr<Partition>> partitions;
+    bool cached = false;
+    std::atomic<uint64_t> cache_hits{0};
+    std::atomic<uint64_t> cache_misses{0};
+    std::atomic<uint64_t> cache_range_hits{0};
+    std::atomic<uint64_t> cache_range_misses{0};
+
+    ColumnarSegment::CompactionOptions compaction;
+    RetentionPolicy retention;
+    std::mutex pass_mutex;   // one compaction or retention pass at a time
+    std::mutex maintenance_mutex;
+    std::condition_variable maintenance_cv;
+    bool maintenance_stopping = false;
+    std::thread maintenance;
+};
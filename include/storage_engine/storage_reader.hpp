@@ -0,0 +1,79 @@
+#pragma once
+#include "storage_engine/columnar_segment.hpp"
+#include "storage_engine/record_format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Sequential zero-copy reader over a SegmentedLog directory.
+//
+// Segments are memory-mapped read-only with MADV_SEQUENTIAL and records come
+// back as RecordFormat::RecordViews pointing into the mapping, so nothing is
+// copied or allocated per record. While the reader is in the last
+// kPrefetchBytes of a segment it maps the next one and asks the kernel to
+// start reading it (MADV_WILLNEED), so crossing a segment boundary does not
+// stall on a cold page cache. Compacted segments are mapped the same way and
+// decoded one block at a time into a buffer the views then point into.
+//
+// A view stays valid until next() moves into another segment or block, or
+// re-maps the one that is still being written. Copy out anything that must
+// outlive that.
+// At the end of the log next() returns false. A later call picks up records
+// and segments written since then, so the reader can also follow the tail.
+// A reader given an end position stops before the first record at or past it
+// and never maps segments beyond it, which is how work is split across threads.
+// Not thread-safe; use one reader per thread.
+class StorageReader {
+public:
+    struct Position {
+        uint64_t segment = 0;
+        uint64_t offset = 0;
+    };
+
+    static constexpr size_t kPrefetchBytes = 8 * 1024 * 1024;
+
+    explicit StorageReader(std::string directory);
+    StorageReader(std::string directory, Position start);
+    StorageReader(std::string directory, Position start, Position end);
+    ~StorageReader();
+
+    StorageReader(const StorageReader&) = delete;
+    StorageReader& operator=(const StorageReader&) = delete;
+
+    bool next(RecordFormat::RecordView& view);
+
+    // Where the next record starts
+    Position position() const { return {current_.segment, offset_}; }
+
+private:
+    struct Mapping {
+        uint64_t segment = 0;
+        const uint8_t* data = nullptr;   // row bytes [base, limit)
+        size_t size = 0;                 // row size of the whole segment
+        size_t base = 0;
+        size_t limit = 0;
+        bool valid = false;
+        // Compacted segments: data points into rows, one decoded block
+        std::shared_ptr<const ColumnarSegment> columnar;
+        std::vector<uint8_t> rows;
+    };
+
+    Mapping map(uint64_t segment) const;
+    static void unmap(Mapping& mapping);
+    // Makes current_ cover offset_; false if nothing can
+    bool window();
+    std::optional<uint64_t> nextSegmentAfter(uint64_t segment) const;
+    bool advance();
+    bool atEnd() const;
+    void prefetchNext();
+
+    std::string directory_;
+    Mapping current_;
+    Mapping next_;
+    uint64_t offset_ = 0;
+    Position end_{UINT64_MAX, UINT64_MAX};
+    bool prefetched_ = false;   // next_ already looked up for current_
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include "event/Event.hpp"
+#include "storage_engine/record_format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Copies of the most recently appended records of one partition, kept in a
+// ring of capacity_bytes in their RecordFormat encoding. Appending past the
+// end overwrites the oldest records.
+//
+// Point lookups are served for any id still in the ring. A time-range query
+// is only served when the ring provably holds every stored record it could
+// match: the cache tracks a floor, the newest timestamp of any record it no
+// longer holds (evicted, too large, or dropped by retention), and answers
+// queries starting above it. Timestamps need not arrive in order; a late
+// record only raises the floor when it leaves the ring. A query binary
+// searches past the entries that arrived before anything in its window, so
+// windows near the head of the log touch few entries.
+class TailCache {
+public:
+    explicit TailCache(size_t capacity_bytes);
+
+    TailCache(const TailCache&) = delete;
+    TailCache& operator=(const TailCache&) = delete;
+
+    bool enabled() const { return !ring_.empty(); }
+
+    // record is the encoded record key describes (offset unused)
+    void insert(const RecordFormat::IndexedRecord& key, std::span<const uint8_t> record);
+
+    bool find(uint64_t id, EventStream::Event& event) const;
+
+    // Appends the cached records of topic (any topic without topicHash) with
+    // fromTs <= timestamp <= toTs to out, in arrival order, and returns how
+    // many; nullopt, leaving out alone, if records older than the ring could
+    // match. Nothing stored before the cache existed is in it: storedFloor is
+    // the newest timestamp among those, if there are any.
+    std::optional<size_t> query(std::optional<uint64_t> topicHash, std::string_view topic, uint64_t fromTs,
+                                uint64_t toTs, std::optional<uint64_t> storedFloor,
+                                std::vector<EventStream::Event>& out) const;
+
+    // Retention: drops the records expired says have gone from disk
+    void dropIf(const std::function<bool(std::string_view topic, uint64_t timestamp)>& expired);
+
+    size_t events() const;
+    size_t bytes() const;
+
+private:
+    struct Entry {
+        uint64_t id;
+        uint64_t timestamp;
+        uint64_t newest;   // largest timestamp up to this entry, so queries can skip older ones
+        uint64_t topic_hash;
+        size_t offset;
+        size_t size;
+        bool live;
+    };
+
+    std::span<const uint8_t> recordOf(const Entry& entry) const {
+        return {ring_.data() + entry.offset, entry.size};
+    }
+    void evictFront();
+    // Unlinks a live entry; lose() records that the cache no longer covers
+    // everything stored at or below timestamp
+    void forget(uint64_t seq);
+    void lose(uint64_t timestamp);
+
+    mutable std::shared_mutex mutex_;
+    std::vector<uint8_t> ring_;
+    size_t head_ = 0;            // where the next record goes
+    std::deque<Entry> entries_;  // oldest first
+    uint64_t first_seq_ = 0;     // sequence number of entries_.front()
+    std::unordered_map<uint64_t, uint64_t> by_id_;   // id -> sequence number
+    std::optional<uint64_t> floor_;   // unset until a record leaves
+    size_t live_events_ = 0;
+    size_t live_bytes_ = 0;
+};
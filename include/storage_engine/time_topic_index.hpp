@@ -0,0 +1,145 @@
+#pragma once
+#include "storage_engine/record_format.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Fixed-size bloom filter over RecordFormat::topicHash values (k = 4)
+template <size_t Bits>
+struct TopicBloom {
+    static_assert(Bits % 64 == 0, "TopicBloom size must be whole words");
+    std::array<uint64_t, Bits / 64> words{};
+
+    void add(uint64_t hash) {
+        forEachBit(hash, [this](size_t bit) { words[bit / 64] |= uint64_t{1} << (bit % 64); });
+    }
+
+    bool mightContain(uint64_t hash) const {
+        bool all = true;
+        forEachBit(hash, [&](size_t bit) { all = all && (words[bit / 64] >> (bit % 64)) & 1; });
+        return all;
+    }
+
+private:
+    template <typename F>
+    static void forEachBit(uint64_t hash, F&& f) {
+        // Remix (FNV-1a mixes its high bits poorly), then double hashing
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        uint32_t a = static_cast<uint32_t>(hash);
+        uint32_t b = static_cast<uint32_t>(hash >> 32) | 1;
+        for (uint32_t i = 0; i < 4; ++i) f((a + i * b) % Bits);
+    }
+};
+
+// Secondary index answering "records of topic X with timestamps in [from, to]".
+//
+// Each segment keeps its timestamp range and a topic bloom filter, and is cut
+// into blocks of about block_bytes at record boundaries, each with its own
+// timestamp range and (smaller) bloom filter. A query skips whole segments,
+// then whole blocks, and only the surviving byte ranges are read and scanned.
+// Sealed segments persist this as segment-NNNNNN.sum; like the offset index it
+// is rebuilt from the segment when missing.
+class TimeTopicIndex {
+public:
+    static constexpr size_t kDefaultBlockBytes = 64 * 1024;
+
+    using SegmentBloom = TopicBloom<4096>;
+    using BlockBloom = TopicBloom<512>;
+
+    // A byte range of one segment that may hold matching records
+    struct Candidate {
+        uint64_t segment;
+        uint64_t begin;
+        uint64_t end;
+        uint64_t min_ts;   // oldest record in the range, of any topic
+    };
+
+    struct QueryStats {
+        size_t segments = 0;
+        size_t segments_skipped = 0;
+        size_t blocks = 0;
+        size_t blocks_skipped = 0;
+    };
+
+    explicit TimeTopicIndex(std::string directory, size_t block_bytes = kDefaultBlockBytes);
+
+    // Same recovery protocol as OffsetIndex
+    bool loadSealed(uint64_t segment);
+    void buildSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+    void loadActive(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+
+    // Writer thread
+    void add(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+    void seal(uint64_t segment);
+
+    // Retention, as for OffsetIndex
+    void dropSealed(uint64_t segment);
+    void replaceSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records);
+    void discardFile(uint64_t segment);
+
+    // Timestamp range of every sealed segment, ascending segment order
+    struct SegmentRange {
+        uint64_t segment;
+        uint64_t min_ts;
+        uint64_t max_ts;
+        uint64_t records;
+    };
+    std::vector<SegmentRange> sealedRanges() const;
+
+    // Appends the byte ranges worth scanning, in log order; adjacent blocks
+    // are coalesced. No topic hash means any topic.
+    void candidates(std::optional<uint64_t> topicHash, uint64_t fromTs, uint64_t toTs,
+                    std::vector<Candidate>& out, QueryStats* stats = nullptr) const;
+
+    static std::string summaryFileName(uint64_t segment);
+
+private:
+    struct Block {
+        uint64_t begin;
+        uint64_t end;
+        uint64_t min_ts;
+        uint64_t max_ts;
+        uint64_t records;
+        BlockBloom topics;
+    };
+
+    struct SegmentSummary {
+        uint64_t segment = 0;
+        uint64_t min_ts = UINT64_MAX;
+        uint64_t max_ts = 0;
+        uint64_t records = 0;
+        SegmentBloom topics;
+        std::vector<Block> blocks;
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t block_count;
+        uint64_t records;
+        uint64_t min_ts;
+        uint64_t max_ts;
+        SegmentBloom topics;
+    };
+
+    static constexpr uint32_t kMagic = 0x4d555345;   // "ESUM"
+    static constexpr uint32_t kVersion = 1;
+
+    void addTo(SegmentSummary& summary, std::span<const RecordFormat::IndexedRecord> records) const;
+    bool writeSummaryFile(const SegmentSummary& summary) const;
+    void insertSealed(SegmentSummary&& summary);   // caller holds mutex_ exclusively
+    std::string pathFor(uint64_t segment, const char* suffix) const;
+
+    std::string directory_;
+    size_t block_bytes_;
+    mutable std::shared_mutex mutex_;
+    std::vector<SegmentSummary> sealed_;   // ascending segment order
+    SegmentSummary active_;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+
+// Epoch-based reclamation for data that readers reach through an atomic
+// pointer and writers replace rarely.
+//
+// A reader holds an Epoch::Guard while it uses what it loaded; pinning writes
+// only to the calling thread's own record, so readers never contend with
+// each other or wait for a writer. A writer first swaps the pointer, then
+// retires the old object, which is freed once every thread that was pinned
+// at that moment has let go. Guards nest. One process-wide domain, like the
+// thread records it keeps: a record is handed to a new thread when its
+// owner exits.
+class Epoch {
+public:
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // p must already be unreachable for readers that pin after this call
+    template <typename T>
+    static void retire(const T* p) {
+        retire(const_cast<T*>(p), [](void* q) { delete static_cast<T*>(q); });
+    }
+    static void retire(void* p, void (*deleter)(void*));
+
+    // Frees whatever no pinned thread can still hold; returns how many
+    // retired objects are left waiting. retire() calls this itself.
+    static size_t reclaim();
+};
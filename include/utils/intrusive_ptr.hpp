@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Reference count embedded in the object it counts, for IntrusivePtr. Copies
+// of the object start unshared.
+class RefCounted {
+public:
+    void retain() const noexcept { refs_.fetch_add(1, std::memory_order_relaxed); }
+    // True when this dropped the last reference
+    bool releaseRef() const noexcept { return refs_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    uint32_t refCount() const noexcept { return refs_.load(std::memory_order_relaxed); }
+
+protected:
+    RefCounted() = default;
+    RefCounted(const RefCounted&) noexcept {}
+    RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+    ~RefCounted() = default;
+
+private:
+    mutable std::atomic<uint32_t> refs_{0};
+};
+
+// Shared ownership without a separate control block: T provides retain() and
+// release(), the latter disposing of the object once the count reaches zero.
+// One pointer wide, so copying it touches only the object's own cache line.
+template <typename T>
+class IntrusivePtr {
+public:
+    IntrusivePtr() noexcept = default;
+    IntrusivePtr(std::nullptr_t) noexcept {}
+    explicit IntrusivePtr(T* p) noexcept : p_(p) {
+        if (p_) p_->retain();
+    }
+    IntrusivePtr(const IntrusivePtr& other) noexcept : p_(other.p_) {
+        if (p_) p_->retain();
+    }
+    IntrusivePtr(IntrusivePtr&& other) noexcept : p_(std::exchange(other.p_, nullptr)) {}
+    ~IntrusivePtr() {
+        if (p_) p_->release();
+    }
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        IntrusivePtr(other).swap(*this);
+        return *this;
+    }
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        IntrusivePtr(std::move(other)).swap(*this);
+        return *this;
+    }
+    IntrusivePtr& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    void reset() noexcept { IntrusivePtr().swap(*this); }
+    void swap(IntrusivePtr& other) noexcept { std::swap(p_, other.p_); }
+
+    T* get() const noexcept { return p_; }
+    T& operator*() const noexcept { return *p_; }
+    T* operator->() const noexcept { return p_; }
+    explicit operator bool() const noexcept { return p_ != nullptr; }
+
+    friend bool operator==(const IntrusivePtr& a, const IntrusivePtr& b) noexcept { return a.p_ == b.p_; }
+    friend bool operator==(const IntrusivePtr& a, std::nullptr_t) noexcept { return a.p_ == nullptr; }
+
+private:
+    T* p_ = nullptr;
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+// Bounded multi-producer / single-consumer ring buffer.
+//
+// Every slot carries a sequence number (Vyukov bounded queue). Producers claim a
+// slot with a single CAS on head_, publish the value, then release the slot by
+// bumping its sequence. The single consumer owns tail_ and never touches head_,
+// so producers only contend with each other on one cache line.
+template <typename T>
+class MpscRingBuffer {
+public:
+    static constexpr size_t kCacheLine = 64;
+
+    explicit MpscRingBuffer(size_t capacity) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("MpscRingBuffer capacity must be a power of two >= 2");
+        }
+        mask_ = capacity - 1;
+        cells_ = std::make_unique<Cell[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    // Producer side, safe from any number of threads. Returns false when full.
+    bool tryPush(T&& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value) {
+        T copy(value);
+        return tryPush(std::move(copy));
+    }
+
+    // Claims up to count consecutive slots with one CAS and moves items[0..n) in.
+    // Returns n; a short count means the ring filled up, items[n..) are untouched.
+    size_t tryPushBatch(T* items, size_t count) {
+        if (count == 0) return 0;
+        size_t pos = head_.load(std::memory_order_relaxed);
+        size_t n;
+        for (;;) {
+            // The consumer frees slots strictly in order, so tail_ bounds the free
+            // space and every slot below tail_ + capacity is already released.
+            size_t tail = tail_.load(std::memory_order_acquire);
+            intptr_t used = static_cast<intptr_t>(pos - tail);
+            if (used < 0) {
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            size_t free = capacity() - std::min(static_cast<size_t>(used), capacity());
+            n = std::min(count, free);
+            if (n == 0) return 0;
+            if (head_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) break;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            Cell& cell = cells_[(pos + i) & mask_];
+            cell.value = std::move(items[i]);
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    // Consumer side, must only be called from one thread at a time.
+    bool tryPop(T& out) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        out = std::move(cell.value);
+        cell.value = T{};
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves up to max ready items into out and publishes the new tail once.
+    size_t tryPopBatch(T* out, size_t max) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        size_t n = 0;
+        while (n < max) {
+            Cell& cell = cells_[(pos + n) & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + n + 1) break;
+            out[n] = std::move(cell.value);
+            cell.value = T{};
+            cell.sequence.store(pos + n + mask_ + 1, std::memory_order_release);
+            ++n;
+        }
+        if (n > 0) tail_.store(pos + n, std::memory_order_release);
+        return n;
+    }
+
+    // Approximate while producers are active.
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() >= capacity(); }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+};
+
+// Lets a consumer sleep on an empty lock-free ring without putting a lock on the
+// producers' fast path: producers only take the mutex when someone is parked.
+// Callers must make the state ready() observes visible before notifying.
+class ConsumerParker {
+public:
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_one();
+    }
+
+    void notifyAll() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+
+    // Returns ready() as of the last check; ready() is evaluated under the mutex.
+    template <typename Pred>
+    bool waitFor(std::chrono::milliseconds timeout, Pred ready) {
+        if (ready()) return true;
+        if (timeout.count() <= 0) return false;
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool result = cv_.wait_for(lock, timeout, ready);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
@@ -6,7 +6,15 @@
 #include "event/Topic_table.hpp"
 #include "eventprocessor/realtime_processor.hpp"
 #include "storage_engine/storage_engine.hpp"
+#include "replay/replay_engine.hpp"
+#include "ingest/client_connection.hpp"
 #include "ingest/tcpingest_server.hpp"
+#ifdef __linux__
+#include "ingest/epoll_ingest_server.hpp"
+#endif
+#ifdef EVENTSTREAM_HAVE_IO_URING
+#include "ingest/uring_ingest_server.hpp"
+#endif
 #include "utils/thread_pool.hpp"
 
 #include <iostream>
@@ -52,19 +60,51 @@ int main( int argc, char* argv[] ) {
     try {
         // Create multi-queue event bus
         EventStream::EventBusMulti eventBus;
+        eventBus.setWatermarks(config.router.high_watermark, config.router.low_watermark);
         
-        // Create dispatcher for routing events
-        Dispatcher dispatcher(eventBus);
+        // Create dispatcher for routing events, one inbound queue + thread per shard
+        Dispatcher dispatcher(eventBus,
+                              static_cast<size_t>(config.router.shards),
+                              static_cast<size_t>(config.router.buffer_size));
+        dispatcher.setShardStrategy(Dispatcher::makeShardStrategy(config.router.strategy));
+        spdlog::info("Router: {} shard(s), strategy '{}', buffer size {}",
+                     config.router.shards, config.router.strategy, config.router.buffer_size);
         
         // Load topic priority overrides
         auto topicTable = std::make_shared<EventStream::TopicTable>();
-        if (!topicTable->LoadFileConfig("config/topics.conf")) {
+        if (!topicTable->LoadFileConfig(config.router.topics_file)) {
             spdlog::warn("Could not load topic configuration file, using defaults");
         }
+        if (config.router.watch_topics) topicTable->WatchFile(config.router.topics_file);
         dispatcher.setTopicTable(topicTable);
         
         // Initialize storage and thread pool
-        StorageEngine storageEngine(config.storage.path);
+        SegmentedLog::Options logOptions;
+        logOptions.segment_bytes = config.storage.segment_bytes;
+        logOptions.sync_policy = SegmentedLog::parseSyncPolicy(config.storage.sync_policy);
+        logOptions.sync_interval = std::chrono::milliseconds(config.storage.sync_interval_ms);
+        logOptions.sync_bytes = config.storage.sync_bytes;
+        logOptions.recovery_threads = config.storage.recovery_threads;
+        logOptions.direct_io = config.storage.direct_io;
+        logOptions.direct_buffers = config.storage.direct_io_buffers;
+        logOptions.direct_buffer_bytes = config.storage.direct_io_buffer_bytes;
+        ColumnarSegment::CompactionOptions compaction;
+        compaction.enable = config.storage.compaction;
+        compaction.hot_segments = config.storage.compaction_hot_segments;
+        compaction.interval = std::chrono::milliseconds(config.storage.compaction_interval_ms);
+        compaction.block_bytes = config.storage.compaction_block_bytes;
+        RetentionPolicy::Options retention;
+        retention.enable = config.storage.retention;
+        retention.max_age = std::chrono::seconds(config.storage.retention_max_age_s);
+        for (const auto& [topic, seconds] : config.storage.retention_topic_max_age_s) {
+            retention.topic_max_age[topic] = std::chrono::seconds(seconds);
+        }
+        retention.max_bytes = config.storage.retention_max_bytes;
+        retention.interval = std::chrono::milliseconds(config.storage.retention_interval_ms);
+        retention.delete_batch = config.storage.retention_delete_batch;
+        retention.batch_pause = std::chrono::milliseconds(config.storage.retention_batch_pause_ms);
+        StorageEngine storageEngine(config.storage.path, logOptions, config.storage.partitions, compaction,
+                                    std::move(retention), config.storage.tail_cache_bytes);
         size_t poolSize = static_cast<size_t>(config.thread_pool.max_threads);
         ThreadPool workerPool(poolSize);
         
@@ -72,7 +112,28 @@ int main( int argc, char* argv[] ) {
         RealtimeProcessor eventProcessor(eventBus, storageEngine, &workerPool);
         
         // Initialize TCP ingest server with dispatcher
-        TcpIngestServer tcpServer(dispatcher, config.ingestion.tcpConfig.port);
+        const auto& tcpConfig = config.ingestion.tcpConfig;
+        std::unique_ptr<IngestServer> tcpServer;
+        setClientTopicLimit(tcpConfig.maxTopics);
+#ifdef EVENTSTREAM_HAVE_IO_URING
+        if (tcpConfig.mode == "io_uring") {
+            if (UringIngestServer::isSupported()) {
+                tcpServer = std::make_unique<UringIngestServer>(dispatcher, tcpConfig.port,
+                                                                tcpConfig.ioThreads, tcpConfig.maxConnections);
+            } else {
+                spdlog::warn("io_uring not available on this kernel, falling back to epoll ingest");
+            }
+        }
+#endif
+#ifdef __linux__
+        if (!tcpServer && (tcpConfig.mode == "epoll" || tcpConfig.mode == "io_uring")) {
+            tcpServer = std::make_unique<EpollIngestServer>(dispatcher, tcpConfig.port,
+                                                            tcpConfig.ioThreads, tcpConfig.maxConnections);
+        }
+#endif
+        if (!tcpServer) {
+            tcpServer = std::make_unique<TcpIngestServer>(dispatcher, tcpConfig.port, tcpConfig.maxConnections);
+        }
         
         // Start all components
         spdlog::info("Starting dispatcher...");
@@ -81,8 +142,22 @@ int main( int argc, char* argv[] ) {
         spdlog::info("Starting event processor...");
         eventProcessor.start();
         
-        spdlog::info("Starting TCP ingest server on port {}...", config.ingestion.tcpConfig.port);
-        tcpServer.start();
+        spdlog::info("Starting TCP ingest server ({}) on port {}...", tcpConfig.mode, tcpConfig.port);
+        tcpServer->start();
+        
+        std::unique_ptr<ReplayEngine> replay;
+        if (config.replay.enable) {
+            ReplayEngine::Options replayOptions;
+            replayOptions.from_ts = config.replay.from_ts;
+            replayOptions.to_ts = config.replay.to_ts;
+            replayOptions.topic = config.replay.topic;
+            replayOptions.pace = ReplayEngine::parsePace(config.replay.pace);
+            replayOptions.speed = config.replay.speed;
+            replayOptions.readers = static_cast<size_t>(config.replay.readers);
+            replay = std::make_unique<ReplayEngine>(config.storage.path, dispatcher, eventBus, replayOptions);
+            spdlog::info("Starting replay ({} pace)...", config.replay.pace);
+            replay->start();
+        }
         
         spdlog::info("Initialization complete. Running main application...");
         spdlog::info("Press Ctrl+C to shutdown");
@@ -91,6 +166,12 @@ int main( int argc, char* argv[] ) {
         while (g_running.load(std::memory_order_acquire)) {
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
         }
+
+        if (config.storage.tail_cache_bytes > 0) {
+            auto cache = storageEngine.tailCacheStats();
+            spdlog::info("Tail cache: {} hits, {} misses, {} range hits, {} range misses, {} events in {} bytes",
+                         cache.hits, cache.misses, cache.range_hits, cache.range_misses, cache.events, cache.bytes);
+        }
         
     } catch (const std::exception& e) {
         spdlog::error("Application error: {}", e.what());
@@ -17,6 +17,9 @@ static AppConfig::TCPConfig parseTCPConfig(const YAML::Node& node) {
     config.port = node["port"].as<int>();
     config.enable = node["enable"].as<bool>(false);
     config.maxConnections = node["maxConnections"].as<int>();
+    config.mode = node["mode"].as<std::string>("threaded");
+    config.ioThreads = node["ioThreads"].as<int>(4);
+    config.maxTopics = node["maxTopics"].as<size_t>(65536);
     return config;
 }
 
@@ -81,6 +84,10 @@ AppConfig::AppConfiguration ConfigLoader::loadConfig(const std::string& filepath
     config.router.shards = root["router"]["shards"].as<int>();
     config.router.strategy = root["router"]["strategy"].as<std::string>();
     config.router.buffer_size = root["router"]["buffer_size"].as<int>();
+    config.router.high_watermark = root["router"]["high_watermark"].as<double>(0.8);
+    config.router.low_watermark = root["router"]["low_watermark"].as<double>(0.5);
+    config.router.topics_file = root["router"]["topics_file"].as<std::string>(config.router.topics_file);
+    config.router.watch_topics = root["router"]["watch_topics"].as<bool>(config.router.watch_topics);
 
     /* Rule Engine */ 
     ValidateNodeExists(root, "rule_engine");
@@ -92,7 +99,55 @@ AppConfig::AppConfiguration ConfigLoader::loadConfig(const std::string& filepath
     /* Storage Config */
     ValidateNodeExists(root, "storage");
     config.storage.backend = root["storage"]["backend"].as<std::string>();
-    config.storage.path = root["storage"]["sqlite_path"].as<std::string>();
+    config.storage.path = root["storage"]["path"]
+        ? root["storage"]["path"].as<std::string>()
+        : root["storage"]["sqlite_path"].as<std::string>();
+    config.storage.segment_bytes = root["storage"]["segment_bytes"].as<size_t>(config.storage.segment_bytes);
+    config.storage.sync_policy = root["storage"]["sync_policy"].as<std::string>(config.storage.sync_policy);
+    config.storage.sync_interval_ms = root["storage"]["sync_interval_ms"].as<int>(config.storage.sync_interval_ms);
+    config.storage.sync_bytes = root["storage"]["sync_bytes"].as<size_t>(config.storage.sync_bytes);
+    config.storage.partitions = root["storage"]["partitions"].as<size_t>(config.storage.partitions);
+    config.storage.recovery_threads = root["storage"]["recovery_threads"].as<size_t>(config.storage.recovery_threads);
+    config.storage.tail_cache_bytes = root["storage"]["tail_cache_bytes"].as<size_t>(config.storage.tail_cache_bytes);
+    if (root["storage"]["direct_io"]) {
+        const auto& node = root["storage"]["direct_io"];
+        config.storage.direct_io = node["enable"].as<bool>(false);
+        config.storage.direct_io_buffers = node["buffers"].as<size_t>(config.storage.direct_io_buffers);
+        config.storage.direct_io_buffer_bytes = node["buffer_bytes"].as<size_t>(config.storage.direct_io_buffer_bytes);
+    }
+    if (root["storage"]["compaction"]) {
+        const auto& node = root["storage"]["compaction"];
+        config.storage.compaction = node["enable"].as<bool>(false);
+        config.storage.compaction_hot_segments = node["hot_segments"].as<size_t>(config.storage.compaction_hot_segments);
+        config.storage.compaction_interval_ms = node["interval_ms"].as<int>(config.storage.compaction_interval_ms);
+        config.storage.compaction_block_bytes = node["block_bytes"].as<size_t>(config.storage.compaction_block_bytes);
+    }
+    if (root["storage"]["retention"]) {
+        const auto& node = root["storage"]["retention"];
+        config.storage.retention = node["enable"].as<bool>(false);
+        config.storage.retention_max_age_s = node["max_age_s"].as<uint64_t>(config.storage.retention_max_age_s);
+        config.storage.retention_max_bytes = node["max_bytes"].as<uint64_t>(config.storage.retention_max_bytes);
+        config.storage.retention_interval_ms = node["interval_ms"].as<int>(config.storage.retention_interval_ms);
+        config.storage.retention_delete_batch = node["delete_batch"].as<size_t>(config.storage.retention_delete_batch);
+        config.storage.retention_batch_pause_ms = node["batch_pause_ms"].as<int>(config.storage.retention_batch_pause_ms);
+        if (node["topics"]) {
+            for (const auto& topic : node["topics"]) {
+                config.storage.retention_topic_max_age_s[topic.first.as<std::string>()] = topic.second.as<uint64_t>();
+            }
+        }
+    }
+
+    /* Replay Config (optional) */
+    if (root["replay"]) {
+        const auto& node = root["replay"];
+        config.replay.enable = node["enable"].as<bool>(false);
+        config.replay.from_ts = node["from_ts"].as<uint64_t>(config.replay.from_ts);
+        config.replay.to_ts = node["to_ts"].as<uint64_t>(config.replay.to_ts);
+        config.replay.topic = node["topic"].as<std::string>("");
+        config.replay.pace = node["pace"].as<std::string>(config.replay.pace);
+        config.replay.speed = node["speed"].as<double>(config.replay.speed);
+        config.replay.readers = node["readers"].as<int>(config.replay.readers);
+    }
 
     /* Python Config */
     ValidateNodeExists(root, "python_integration");
@@ -126,6 +181,13 @@ AppConfig::AppConfiguration ConfigLoader::loadConfig(const std::string& filepath
         throw std::runtime_error("Invalid Port Number");
     }
 
+    const auto& tcp = config.ingestion.tcpConfig;
+    if ((tcp.mode != "threaded" && tcp.mode != "epoll" && tcp.mode != "io_uring") || tcp.ioThreads <= 0 || tcp.maxConnections < 0) {
+        spdlog::error("Invalid TCP ingest configuration: mode={}, ioThreads={}, maxConnections={}",
+                      tcp.mode, tcp.ioThreads, tcp.maxConnections);
+        throw std::runtime_error("Invalid TCP ingest configuration");
+    }
+
     if (config.ingestion.udpConfig.port <=0 || config.ingestion.udpConfig.port > 65535) {
         spdlog::error("Invalid UDP port number: {}", config.ingestion.udpConfig.port);
         throw std::runtime_error("Invalid Port Number");
@@ -141,6 +203,19 @@ AppConfig::AppConfiguration ConfigLoader::loadConfig(const std::string& filepath
         throw std::runtime_error("Invalid Info Router");
     }
 
+    if (!(config.router.low_watermark > 0.0 &&
+          config.router.low_watermark < config.router.high_watermark &&
+          config.router.high_watermark <= 1.0)) {
+        spdlog::error("Invalid router watermarks: high={}, low={}",
+                      config.router.high_watermark, config.router.low_watermark);
+        throw std::runtime_error("Invalid Info Router");
+    }
+
+    if (config.router.strategy != "hash_modulo" && config.router.strategy != "round_robin") {
+        spdlog::error("Unsupported router strategy: {}", config.router.strategy);
+        throw std::runtime_error("Unsupported router strategy");
+    }
+
     if (config.rule_engine.threads <= 0 || config.rule_engine.cache_size < 0) {
         spdlog::error("Invalid Rule Engine configuration: threads={}, cache_size={}", 
                       config.rule_engine.threads, config.rule_engine.cache_size);
@@ -152,6 +227,32 @@ AppConfig::AppConfiguration ConfigLoader::loadConfig(const std::string& filepath
         throw std::runtime_error("Unsupported storage backend");
     }
 
+    const auto& storage = config.storage;
+    if (storage.segment_bytes == 0 || storage.sync_interval_ms <= 0 || storage.sync_bytes == 0 ||
+        storage.partitions == 0 || storage.partitions > 256 ||
+        storage.compaction_interval_ms <= 0 || storage.compaction_block_bytes == 0 ||
+        storage.direct_io_buffers < 2 || storage.direct_io_buffer_bytes == 0 ||
+        storage.direct_io_buffer_bytes % 4096 != 0 ||
+        storage.retention_interval_ms <= 0 || storage.retention_delete_batch == 0 || storage.retention_batch_pause_ms < 0 ||
+        (storage.sync_policy != "batch" && storage.sync_policy != "interval" && storage.sync_policy != "bytes")) {
+        spdlog::error("Invalid storage configuration: segment_bytes={}, sync_policy={}, sync_interval_ms={}, sync_bytes={}, "
+                      "partitions={}, direct_io buffers={}, buffer_bytes={}, compaction interval_ms={}, block_bytes={}, "
+                      "retention interval_ms={}, delete_batch={}, batch_pause_ms={}",
+                      storage.segment_bytes, storage.sync_policy, storage.sync_interval_ms, storage.sync_bytes,
+                      storage.partitions, storage.direct_io_buffers, storage.direct_io_buffer_bytes,
+                      storage.compaction_interval_ms, storage.compaction_block_bytes,
+                      storage.retention_interval_ms, storage.retention_delete_batch, storage.retention_batch_pause_ms);
+        throw std::runtime_error("Invalid storage configuration");
+    }
+
+    const auto& replay = config.replay;
+    if (replay.enable && (replay.from_ts > replay.to_ts || replay.readers <= 0 || !(replay.speed > 0.0) ||
+                          (replay.pace != "max" && replay.pace != "realtime" && replay.pace != "scaled"))) {
+        spdlog::error("Invalid replay configuration: from_ts={}, to_ts={}, pace={}, speed={}, readers={}",
+                      replay.from_ts, replay.to_ts, replay.pace, replay.speed, replay.readers);
+        throw std::runtime_error("Invalid replay configuration");
+    }
+
     if (config.python.enable && config.python.script_path.empty()) {
         spdlog::error("Python integration enabled but script path is empty.");
         throw std::runtime_error("Invalid Python configuration");
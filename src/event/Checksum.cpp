@@ -0,0 +1,250 @@
+#include "event/Checksum.hpp"
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EVENTSTREAM_X86_CRC 1
+#include <cpuid.h>
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+namespace EventStream {
+
+    namespace {
+
+        constexpr uint32_t kCrc32cPoly = 0x82F63B78;  // reflected Castagnoli
+        constexpr uint32_t kCrc32Poly = 0xEDB88320;   // reflected IEEE
+
+        struct SlicingTables {
+            uint32_t crc32c[8][256];
+            uint32_t crc32[8][256];
+
+            SlicingTables() {
+                fill(crc32c, kCrc32cPoly);
+                fill(crc32, kCrc32Poly);
+            }
+
+            static void fill(uint32_t (&t)[8][256], uint32_t poly) {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t crc = i;
+                    for (int j = 0; j < 8; j++) {
+                        crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+                    }
+                    t[0][i] = crc;
+                }
+                for (int k = 1; k < 8; k++) {
+                    for (uint32_t i = 0; i < 256; i++) {
+                        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+                    }
+                }
+            }
+        };
+
+        // Built once, thread-safe (the old lazy flag in EventFactory was not)
+        const SlicingTables& tables() {
+            static const SlicingTables t;
+            return t;
+        }
+
+        uint64_t load64(const uint8_t* p) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        // Raw register in, raw register out (no pre/post inversion)
+        uint32_t bytewise(const uint32_t (&t)[256], const uint8_t* p, size_t len, uint32_t crc) {
+            while (len--) crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+            return crc;
+        }
+
+        uint32_t slicingBy8(const uint32_t (&t)[8][256], const uint8_t* p, size_t len, uint32_t crc) {
+            if constexpr (std::endian::native != std::endian::little) {
+                return bytewise(t[0], p, len, crc);
+            }
+            while (len >= 8) {
+                uint64_t v = load64(p) ^ crc;
+                crc = t[7][v & 0xFF] ^ t[6][(v >> 8) & 0xFF] ^
+                      t[5][(v >> 16) & 0xFF] ^ t[4][(v >> 24) & 0xFF] ^
+                      t[3][(v >> 32) & 0xFF] ^ t[2][(v >> 40) & 0xFF] ^
+                      t[1][(v >> 48) & 0xFF] ^ t[0][v >> 56];
+                p += 8;
+                len -= 8;
+            }
+            return bytewise(t[0], p, len, crc);
+        }
+
+#ifdef EVENTSTREAM_X86_CRC
+        // Bytes per stream in the 3-way interleaved kernel. crc32 has a latency
+        // of 3 cycles and a throughput of 1, so three independent streams keep
+        // the unit busy; the partial CRCs are then merged with carry-less multiplies.
+        constexpr size_t kLongBlock = 4096;
+        constexpr size_t kShortBlock = 256;
+
+        // x^n mod P in the reflected domain
+        uint32_t xnModP(size_t n) {
+            uint32_t p = 0x80000000u;  // x^0
+            while (n--) p = (p & 1) ? (p >> 1) ^ kCrc32cPoly : p >> 1;
+            return p;
+        }
+
+        // Multiplying a CRC by K = x^(8n-33) with pclmul and reducing with the
+        // crc32 instruction (which multiplies by x^32) shifts it over n zero
+        // bytes; the extra x comes from the reflected carry-less product.
+        struct ShiftConstants {
+            uint32_t long1 = xnModP(8 * kLongBlock - 33);
+            uint32_t long2 = xnModP(16 * kLongBlock - 33);
+            uint32_t short1 = xnModP(8 * kShortBlock - 33);
+            uint32_t short2 = xnModP(16 * kShortBlock - 33);
+        };
+
+        const ShiftConstants& shiftConstants() {
+            static const ShiftConstants k;
+            return k;
+        }
+
+        __attribute__((target("sse4.2")))
+        uint32_t sse42(const uint8_t* p, size_t len, uint32_t crc) {
+            while (len > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+                crc = _mm_crc32_u8(crc, *p++);
+                len--;
+            }
+            uint64_t c = crc;
+            while (len >= 8) {
+                c = _mm_crc32_u64(c, load64(p));
+                p += 8;
+                len -= 8;
+            }
+            crc = static_cast<uint32_t>(c);
+            while (len--) crc = _mm_crc32_u8(crc, *p++);
+            return crc;
+        }
+
+        __attribute__((target("sse4.2,pclmul")))
+        uint32_t shiftCrc(uint32_t crc, uint32_t k) {
+            __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)),
+                                                   _mm_cvtsi32_si128(static_cast<int>(k)), 0);
+            return static_cast<uint32_t>(_mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product))));
+        }
+
+        __attribute__((target("sse4.2,pclmul")))
+        uint32_t interleave3(const uint8_t*& p, size_t& len, uint32_t crc,
+                             size_t block, uint32_t k1, uint32_t k2) {
+            while (len >= 3 * block) {
+                uint64_t a = crc, b = 0, c = 0;
+                for (size_t i = 0; i < block; i += 8) {
+                    a = _mm_crc32_u64(a, load64(p + i));
+                    b = _mm_crc32_u64(b, load64(p + block + i));
+                    c = _mm_crc32_u64(c, load64(p + 2 * block + i));
+                }
+                // crc(A|B|C) = A shifted over |B|+|C|, B shifted over |C|, plus C
+                crc = shiftCrc(static_cast<uint32_t>(a), k2) ^
+                      shiftCrc(static_cast<uint32_t>(b), k1) ^ static_cast<uint32_t>(c);
+                p += 3 * block;
+                len -= 3 * block;
+            }
+            return crc;
+        }
+
+        __attribute__((target("sse4.2,pclmul")))
+        uint32_t sse42Pclmul(const uint8_t* p, size_t len, uint32_t crc) {
+            const ShiftConstants& k = shiftConstants();
+            crc = interleave3(p, len, crc, kLongBlock, k.long1, k.long2);
+            crc = interleave3(p, len, crc, kShortBlock, k.short1, k.short2);
+            return sse42(p, len, crc);
+        }
+
+        bool cpuHas(unsigned int ecxBit) {
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+            return (ecx & ecxBit) != 0;
+        }
+#endif
+
+        using Kernel = uint32_t (*)(const uint8_t*, size_t, uint32_t);
+
+        uint32_t portableKernel(const uint8_t* p, size_t len, uint32_t crc) {
+            return slicingBy8(tables().crc32c, p, len, crc);
+        }
+
+        struct Selected {
+            Kernel kernel = portableKernel;
+            const char* name = "slicing-by-8";
+
+            Selected() {
+#ifdef EVENTSTREAM_X86_CRC
+                if (Checksum::sse42Supported() && Checksum::pclmulSupported()) {
+                    kernel = sse42Pclmul;
+                    name = "sse4.2+pclmul";
+                } else if (Checksum::sse42Supported()) {
+                    kernel = sse42;
+                    name = "sse4.2";
+                }
+#endif
+            }
+        };
+
+        const Selected& selected() {
+            static const Selected s;
+            return s;
+        }
+
+    } // namespace
+
+    uint32_t Checksum::crc32c(std::span<const uint8_t> data, uint32_t crc) {
+        return ~selected().kernel(data.data(), data.size(), ~crc);
+    }
+
+    uint32_t Checksum::crc32(std::span<const uint8_t> data, uint32_t crc) {
+        return ~slicingBy8(tables().crc32, data.data(), data.size(), ~crc);
+    }
+
+    uint32_t Checksum::compute(ChecksumAlgorithm algo, std::span<const uint8_t> data) {
+        return algo == ChecksumAlgorithm::CRC32 ? crc32(data) : crc32c(data);
+    }
+
+    const char* Checksum::crc32cImplementation() {
+        return selected().name;
+    }
+
+    uint32_t Checksum::crc32cBytewise(std::span<const uint8_t> data, uint32_t crc) {
+        return ~bytewise(tables().crc32c[0], data.data(), data.size(), ~crc);
+    }
+
+    uint32_t Checksum::crc32cSlicingBy8(std::span<const uint8_t> data, uint32_t crc) {
+        return ~slicingBy8(tables().crc32c, data.data(), data.size(), ~crc);
+    }
+
+#ifdef EVENTSTREAM_X86_CRC
+    uint32_t Checksum::crc32cSse42(std::span<const uint8_t> data, uint32_t crc) {
+        return ~sse42(data.data(), data.size(), ~crc);
+    }
+
+    uint32_t Checksum::crc32cSse42Pclmul(std::span<const uint8_t> data, uint32_t crc) {
+        return ~sse42Pclmul(data.data(), data.size(), ~crc);
+    }
+
+    bool Checksum::sse42Supported() {
+        static const bool supported = cpuHas(bit_SSE4_2);
+        return supported;
+    }
+
+    bool Checksum::pclmulSupported() {
+        static const bool supported = cpuHas(bit_PCLMUL);
+        return supported;
+    }
+#else
+    uint32_t Checksum::crc32cSse42(std::span<const uint8_t> data, uint32_t crc) {
+        return crc32cSlicingBy8(data, crc);
+    }
+
+    uint32_t Checksum::crc32cSse42Pclmul(std::span<const uint8_t> data, uint32_t crc) {
+        return crc32cSlicingBy8(data, crc);
+    }
+
+    bool Checksum::sse42Supported() { return false; }
+    bool Checksum::pclmulSupported() { return false; }
+#endif
+
+} // namespace EventStream
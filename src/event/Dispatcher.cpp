@@ -1,42 +1,149 @@
 #include "event/Dispatcher.hpp"
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 using namespace EventStream;
 
+namespace {
+
+// Round up to the next power of two, as required by MpscRingBuffer
+size_t ringCapacity(size_t requested) {
+    size_t capacity = 2;
+    while (capacity < requested) capacity <<= 1;
+    return capacity;
+}
+
+} // namespace
+
+Dispatcher::Dispatcher(EventBusMulti& bus, size_t shard_count, size_t shard_capacity)
+    : event_bus_(bus), shard_strategy_(makeShardStrategy("hash_modulo")) {
+    if (shard_count == 0) shard_count = 1;
+    event_bus_.setResumeHandler([this] { capacity_parker_.notifyAll(); });
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(ringCapacity(shard_capacity)));
+    }
+}
+
+Dispatcher::~Dispatcher() {
+    stop();
+    event_bus_.setResumeHandler(nullptr);
+}
+
+Dispatcher::ShardStrategy Dispatcher::makeShardStrategy(const std::string& name) {
+    if (name == "hash_modulo") {
+        return [](const Event& evt, size_t shard_count) {
+            return evt.topic.hash() % shard_count;
+        };
+    }
+    if (name == "round_robin") {
+        auto next = std::make_shared<std::atomic<size_t>>(0);
+        return [next](const Event&, size_t shard_count) {
+            return next->fetch_add(1, std::memory_order_relaxed) % shard_count;
+        };
+    }
+    throw std::invalid_argument("Unknown dispatcher shard strategy: " + name);
+}
+
 void Dispatcher::start(){
     running_.store(true,std::memory_order_release);
-    worker_thread_ = std::thread(&Dispatcher::DispatchLoop,this);
-    spdlog::info("Dispatcher started.");
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->worker_thread = std::thread(&Dispatcher::DispatchLoop, this, i);
+    }
+    spdlog::info("Dispatcher started with {} shard(s).", shards_.size());
 }
 
 void Dispatcher::stop(){
     running_.store(false,std::memory_order_release);
-    inbound_cv_.notify_all();
-    if(worker_thread_.joinable()) {
-        worker_thread_.join();
+    for (auto& shard : shards_) {
+        shard->inbound_parker.notifyAll();
+    }
+    capacity_parker_.notifyAll();
+    for (auto& shard : shards_) {
+        if (shard->worker_thread.joinable()) {
+            shard->worker_thread.join();
+        }
+        if (shard->pending_count > 0) {
+            spdlog::warn("Dispatcher stopped with {} routed events still waiting for a full lane.",
+                         shard->pending_count);
+        }
     }
     spdlog::info("Dispatcher stopped.");
 }
 
 bool Dispatcher::tryPush(const EventPtr& evt){
-    std::unique_lock<std::mutex> lock(inbound_mutex_);
-    if (inbound_queue_.size() >= inbound_capacity_)  return false;
-    inbound_queue_.push_back(evt);
-    inbound_cv_.notify_one();
+    if (!evt) return false;
+    Shard& shard = *shards_[shardFor(*evt)];
+    if (!shard.inbound_queue.tryPush(evt)) return false;
+    shard.inbound_parker.notify();
     return true;
 }
 
-std::optional<EventPtr> Dispatcher::tryPop(std::chrono::milliseconds timeout){
-    std::unique_lock <std::mutex> lock(inbound_mutex_);
-    if(!inbound_cv_.wait_for(lock,timeout,[this]{ return !inbound_queue_.empty() || !running_.load(std::memory_order_acquire); })){
-        return std::nullopt;
-    }
-    if(!running_.load(std::memory_order_acquire) && inbound_queue_.empty()){
-        return std::nullopt;
+size_t Dispatcher::tryPushBatch(std::span<EventPtr> events){
+    size_t pushed = 0;
+    if (events.empty()) return 0;
+    // The strategy is evaluated once per event: round_robin advances a counter
+    size_t next_shard = shardFor(*events[0]);
+    while (pushed < events.size()) {
+        size_t shard_index = next_shard;
+        size_t end = pushed + 1;
+        if (shards_.size() == 1) {
+            end = events.size();
+        } else {
+            while (end < events.size()) {
+                next_shard = shardFor(*events[end]);
+                if (next_shard != shard_index) break;
+                ++end;
+            }
+        }
+        Shard& shard = *shards_[shard_index];
+        size_t taken = shard.inbound_queue.tryPushBatch(events.data() + pushed, end - pushed);
+        if (taken > 0) shard.inbound_parker.notify();
+        pushed += taken;
+        if (pushed < end) break;  // shard ring full; keep the rest in order
     }
-    EventPtr event = inbound_queue_.front();
-    inbound_queue_.pop_front();
+    return pushed;
+}
+
+bool Dispatcher::pushWithBackpressure(const EventPtr& evt, std::chrono::milliseconds timeout){
+    if (tryPush(evt)) return true;
+    bool pushed = false;
+    capacity_parker_.waitFor(timeout, [this, &evt, &pushed]{
+        pushed = tryPush(evt);
+        return pushed || !running_.load(std::memory_order_acquire);
+    });
+    return pushed;
+}
+
+size_t Dispatcher::pushBatchWithBackpressure(std::span<EventPtr> events, std::chrono::milliseconds timeout){
+    size_t pushed = tryPushBatch(events);
+    if (pushed == events.size()) return pushed;
+    capacity_parker_.waitFor(timeout, [this, events, &pushed]{
+        pushed += tryPushBatch(events.subspan(pushed));
+        return pushed == events.size() || !running_.load(std::memory_order_acquire);
+    });
+    return pushed;
+}
+
+bool Dispatcher::waitForCapacity(std::chrono::milliseconds timeout){
+    // The predicate runs under the parker's lock, which the resume handler
+    // takes too: only look there, and clear the pause once outside
+    bool ready = capacity_parker_.waitFor(timeout, [this]{
+        return !event_bus_.pauseHolds() || !running_.load(std::memory_order_acquire);
+    });
+    if (ready) event_bus_.isPaused();
+    return ready;
+}
+
+std::optional<EventPtr> Dispatcher::tryPop(std::chrono::milliseconds timeout, size_t shard_index){
+    if (shard_index >= shards_.size()) return std::nullopt;
+    Shard& shard = *shards_[shard_index];
+    EventPtr event;
+    shard.inbound_parker.waitFor(timeout, [this, &shard, &event]{
+        return shard.inbound_queue.tryPop(event) || !running_.load(std::memory_order_acquire);
+    });
+    if (!event) return std::nullopt;
     return event;
 }
 
@@ -51,8 +158,9 @@ EventBusMulti::QueueId Dispatcher::Route(const EventPtr& evt) {
 
     // If topic table exists and the topic is found, update priority from table
     if (topic_table_ && topic_table_->FoundTopic(evt->topic,priority) ) {
-        spdlog::info("Found topic {} with priority {}", evt->topic, static_cast<int>(priority));
+        spdlog::debug("Found topic {} with priority {}", evt->topic.name(), static_cast<int>(priority));
     }
+    routed_[evt->topic.id()].fetch_add(1, std::memory_order_relaxed);
 
     // Priority handling logic:
     // - If topic is found in table: only override if client priority is higher than table priority
@@ -75,30 +183,64 @@ EventBusMulti::QueueId Dispatcher::Route(const EventPtr& evt) {
     return queueId;
 }
 
-void Dispatcher::DispatchLoop(){
-    spdlog::info("Dispatcher DispatchLoop started.");
+uint64_t Dispatcher::routedEvents(Topic topic) const {
+    const auto* count = routed_.find(topic.id());
+    return count ? count->load(std::memory_order_relaxed) : 0;
+}
+
+void Dispatcher::dispatchOne(Shard& shard, EventPtr&& evt){
+    auto queueId = Route(evt);
+    auto& pending = shard.pending[static_cast<size_t>(queueId)];
+
+    // Anything already waiting for this lane goes first to keep lane order
+    if (pending.empty() && event_bus_.push(queueId, evt)) return;
+    pending.push_back(std::move(evt));
+    ++shard.pending_count;
+}
+
+void Dispatcher::flushPending(Shard& shard){
+    for (size_t lane = 0; lane < kLaneCount && shard.pending_count > 0; ++lane) {
+        auto& pending = shard.pending[lane];
+        auto queueId = static_cast<EventBusMulti::QueueId>(lane);
+        while (!pending.empty() && event_bus_.push(queueId, pending.front())) {
+            pending.pop_front();
+            --shard.pending_count;
+        }
+    }
+}
+
+void Dispatcher::DispatchLoop(size_t shard_index){
+    spdlog::info("Dispatcher DispatchLoop started for shard {}.", shard_index);
+    Shard& shard = *shards_[shard_index];
+    std::vector<EventPtr> batch(kDispatchBatch);
+
     while (running_.load(std::memory_order_acquire))
     {
-        auto event = tryPop(std::chrono::milliseconds(100));
-        if (!event.has_value()) continue;
-        
-        auto queueId = Route(event.value());
-        
-        // Try to push to target queue, with backoff retry
-        bool pushed = false;
-        for (int retry = 0; retry < 5; ++retry) {
-            pushed = event_bus_.push(queueId, event.value());
-            if (pushed) break;
-            
-            // Queue full - wait a bit before retry
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        flushPending(shard);
+        if (shard.pending_count >= kMaxPendingPerShard) {
+            // Lanes are backed up: leave inbound alone so it fills and ingest
+            // blocks, rather than sleeping on one event or dropping it.
+            waitForCapacity(std::chrono::milliseconds(100));
+            continue;
         }
-        
-        if (!pushed) {
-            spdlog::warn("Failed to push event {} to queue {} after retries. Dropping event.", 
-                        event.value()->header.id, static_cast<int>(queueId));
+
+        // With events parked, poll inbound briefly so pending lanes get retried soon
+        auto timeout = shard.pending_count > 0 ? std::chrono::milliseconds(1)
+                                               : std::chrono::milliseconds(100);
+        size_t count = 0;
+        shard.inbound_parker.waitFor(timeout, [this, &shard, &batch, &count]{
+            count = shard.inbound_queue.tryPopBatch(batch.data(), batch.size());
+            return count > 0 || !running_.load(std::memory_order_acquire);
+        });
+        if (count == 0) continue;
+
+        // Inbound space was freed for producers blocked in pushWithBackpressure
+        capacity_parker_.notifyAll();
+
+        for (size_t i = 0; i < count; ++i) {
+            dispatchOne(shard, std::move(batch[i]));
         }
     }
     
-    spdlog::info("Dispatcher DispatchLoop stopped.");
+    spdlog::info("Dispatcher DispatchLoop stopped for shard {}.", shard_index);
 }
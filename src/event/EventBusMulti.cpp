@@ -1,5 +1,7 @@
 #include "event/EventBusMulti.hpp"
+#include <algorithm>
 #include <chrono>
+#include <stdexcept>
 
 namespace EventStream {
 
@@ -20,36 +22,96 @@ EventBusMulti::Q* EventBusMulti::getQueue(QueueId q) const {
 size_t EventBusMulti::size(QueueId q) const {
     Q* queue = getQueue(q);
     if (queue == nullptr) return 0;
-    std::lock_guard<std::mutex> lock(queue->m);
-    return queue->dq.size();
+    return queue->ring.size();
+}
+
+void EventBusMulti::setWatermarks(double high_ratio, double low_ratio) {
+    if (!(low_ratio > 0.0 && low_ratio < high_ratio && high_ratio <= 1.0)) {
+        throw std::invalid_argument("EventBusMulti watermarks must satisfy 0 < low < high <= 1");
+    }
+    for (Q* queue : {&RealtimeBus_, &TransactionalBus_, &BatchBus_}) {
+        size_t capacity = queue->ring.capacity();
+        queue->high_mark = std::max<size_t>(1, static_cast<size_t>(capacity * high_ratio));
+        queue->low_mark = static_cast<size_t>(capacity * low_ratio);
+    }
+}
+
+void EventBusMulti::checkHighWatermark(const Q& queue) {
+    if (paused_.load(std::memory_order_relaxed)) return;
+    if (queue.ring.size() >= queue.high_mark) {
+        paused_.store(true, std::memory_order_release);
+    }
+}
+
+bool EventBusMulti::belowLowWatermarks() const {
+    for (const Q* queue : {&RealtimeBus_, &TransactionalBus_, &BatchBus_}) {
+        if (queue->ring.size() > queue->low_mark) return false;
+    }
+    return true;
+}
+
+void EventBusMulti::maybeResume() {
+    if (!belowLowWatermarks()) return;
+    if (paused_.exchange(false, std::memory_order_acq_rel) && resume_handler_) {
+        resume_handler_();
+    }
+}
+
+bool EventBusMulti::isPaused() {
+    if (!paused_.load(std::memory_order_acquire)) return false;
+    maybeResume();
+    return paused_.load(std::memory_order_acquire);
+}
+
+bool EventBusMulti::pauseHolds() const {
+    return paused_.load(std::memory_order_acquire) && !belowLowWatermarks();
 }
 
 bool EventBusMulti::push(QueueId q, const EventPtr& evt){
     Q* queue = getQueue(q);
     if(queue == nullptr) return false;
-    {
-        std::lock_guard<std::mutex> lock(queue->m);
-        if(queue->dq.size() >= queue->capacity){
-            return false; 
-        }
-        queue->dq.push_back(evt);
-    }
-    queue->cv.notify_one();
+    if (!queue->ring.tryPush(evt)) {
+        paused_.store(true, std::memory_order_release);
+        return false;
+    }
+    queue->parker.notify();
+    checkHighWatermark(*queue);
     return true;
 }
 
+size_t EventBusMulti::pushBatch(QueueId q, std::span<EventPtr> events){
+    Q* queue = getQueue(q);
+    if (queue == nullptr) return 0;
+    size_t pushed = queue->ring.tryPushBatch(events.data(), events.size());
+    if (pushed > 0) queue->parker.notify();
+    if (pushed < events.size()) paused_.store(true, std::memory_order_release);
+    else checkHighWatermark(*queue);
+    return pushed;
+}
+
 std::optional<EventPtr> EventBusMulti::pop(QueueId q, std::chrono::milliseconds timeout){
     Q* queue = getQueue(q);
     if (queue == nullptr) return std::nullopt;
 
-    std::unique_lock<std::mutex> lock(queue->m);
-    if (!queue->cv.wait_for(lock, timeout, [queue] { return !queue->dq.empty(); })) {
-        return std::nullopt; 
+    EventPtr event;
+    if (!queue->parker.waitFor(timeout, [queue, &event] { return queue->ring.tryPop(event); })) {
+        return std::nullopt;
     }
+    if (paused_.load(std::memory_order_relaxed)) maybeResume();
+    return event;
+}
+
+size_t EventBusMulti::popBatch(QueueId q, std::span<EventPtr> out, std::chrono::milliseconds timeout){
+    Q* queue = getQueue(q);
+    if (queue == nullptr || out.empty()) return 0;
 
-   EventPtr event = queue -> dq.front();
-   queue->dq.pop_front();
-   return event;
+    size_t count = 0;
+    queue->parker.waitFor(timeout, [queue, &out, &count] {
+        count = queue->ring.tryPopBatch(out.data(), out.size());
+        return count > 0;
+    });
+    if (count > 0 && paused_.load(std::memory_order_relaxed)) maybeResume();
+    return count;
 }
 
 } // namespace EventStream
@@ -0,0 +1,200 @@
+#include "event/EventClock.hpp"
+#include <atomic>
+#include <ctime>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EVENTSTREAM_X86_TSC 1
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace EventStream {
+
+    namespace {
+
+        constexpr uint64_t kNanosPerSecond = 1'000'000'000;
+        constexpr uint64_t kAnchorNanos = kNanosPerSecond;   // renew the anchor after this long
+        constexpr uint64_t kCalibrationNanos = 1'000'000;    // first TSC rate estimate
+
+#ifdef CLOCK_MONOTONIC_COARSE
+        constexpr clockid_t kCoarseClock = CLOCK_MONOTONIC_COARSE;
+#else
+        constexpr clockid_t kCoarseClock = CLOCK_MONOTONIC;
+#endif
+#ifdef CLOCK_MONOTONIC_RAW
+        constexpr clockid_t kRawClock = CLOCK_MONOTONIC_RAW;
+#else
+        constexpr clockid_t kRawClock = CLOCK_MONOTONIC;
+#endif
+
+        uint64_t readClock(clockid_t id) noexcept {
+            timespec ts;
+            clock_gettime(id, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * kNanosPerSecond + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        uint64_t readTsc() noexcept {
+#ifdef EVENTSTREAM_X86_TSC
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        }
+
+        bool invariantTsc() noexcept {
+#ifdef EVENTSTREAM_X86_TSC
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+            return (edx & (1u << 8)) != 0;
+#else
+            return false;
+#endif
+        }
+
+        uint64_t readCounter(EventClock::Source source) noexcept {
+            return source == EventClock::Source::TSC ? readTsc() : readClock(kCoarseClock);
+        }
+
+        uint64_t scale(uint64_t units, uint64_t mult) noexcept {
+            return static_cast<uint64_t>((static_cast<unsigned __int128>(units) * mult) >> 32);
+        }
+
+        // The anchor, published under a sequence lock: readers retry while
+        // seq is odd or changed under them, so they never block
+        struct Anchor {
+            std::atomic<uint32_t> seq{0};
+            std::atomic<uint8_t> source{0};
+            std::atomic<uint64_t> base{0};       // counter reading at the anchor
+            std::atomic<uint64_t> wall{0};       // CLOCK_REALTIME ns at base
+            std::atomic<uint64_t> mult{0};       // ns per counter unit, 32.32 fixed point
+            std::atomic<uint64_t> span{0};       // counter units after which to renew
+        };
+
+        class State {
+        public:
+            State() { reanchor(invariantTsc() ? EventClock::Source::TSC : EventClock::Source::COARSE); }
+
+            uint64_t read() noexcept {
+                EventClock::Source source;
+                uint64_t base, wall, mult, span;
+                while (true) {
+                    uint32_t seq = anchor_.seq.load(std::memory_order_acquire);
+                    source = static_cast<EventClock::Source>(anchor_.source.load(std::memory_order_relaxed));
+                    base = anchor_.base.load(std::memory_order_relaxed);
+                    wall = anchor_.wall.load(std::memory_order_relaxed);
+                    mult = anchor_.mult.load(std::memory_order_relaxed);
+                    span = anchor_.span.load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (!(seq & 1) && anchor_.seq.load(std::memory_order_relaxed) == seq) break;
+                }
+                if (source == EventClock::Source::SYSTEM) return readClock(CLOCK_REALTIME);
+
+                uint64_t counter = readCounter(source);
+                uint64_t elapsed = counter > base ? counter - base : 0;
+                if (elapsed > span && !renewing_.exchange(true, std::memory_order_acquire)) {
+                    // Others keep extrapolating from the old anchor meanwhile
+                    if (anchor_.base.load(std::memory_order_relaxed) == base) reanchor(source);
+                    renewing_.store(false, std::memory_order_release);
+                }
+                return wall + scale(elapsed, mult);
+            }
+
+            EventClock::Source source() const noexcept {
+                return static_cast<EventClock::Source>(anchor_.source.load(std::memory_order_relaxed));
+            }
+
+            EventClock::Source use(EventClock::Source source) {
+                if (source == EventClock::Source::TSC && !invariantTsc()) source = EventClock::Source::COARSE;
+                while (renewing_.exchange(true, std::memory_order_acquire)) {}
+                reanchor(source);
+                renewing_.store(false, std::memory_order_release);
+                return source;
+            }
+
+        private:
+            // Called by one thread at a time
+            void reanchor(EventClock::Source source) noexcept {
+                uint64_t base = 0, wall = 0, mult = uint64_t{1} << 32, span = kAnchorNanos;
+                if (source == EventClock::Source::TSC) {
+                    uint64_t raw;
+                    pairTsc(base, raw, wall);
+                    if (calibrated_tsc_ == 0 || base <= calibrated_tsc_) {
+                        // No baseline yet: spin briefly for a first rate
+                        calibrated_tsc_ = base;
+                        calibrated_raw_ = raw;
+                        do {
+                            pairTsc(base, raw, wall);
+                        } while (raw - calibrated_raw_ < kCalibrationNanos);
+                    }
+                    mult = static_cast<uint64_t>((static_cast<unsigned __int128>(raw - calibrated_raw_) << 32) /
+                                                 (base - calibrated_tsc_));
+                    span = static_cast<uint64_t>((static_cast<unsigned __int128>(kAnchorNanos) << 32) / mult);
+                } else if (source == EventClock::Source::COARSE) {
+                    base = readClock(kCoarseClock);
+                    wall = readClock(CLOCK_REALTIME);
+                }
+
+                uint32_t seq = anchor_.seq.load(std::memory_order_relaxed);
+                anchor_.seq.store(seq + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                anchor_.source.store(static_cast<uint8_t>(source), std::memory_order_relaxed);
+                anchor_.base.store(base, std::memory_order_relaxed);
+                anchor_.wall.store(wall, std::memory_order_relaxed);
+                anchor_.mult.store(mult, std::memory_order_relaxed);
+                anchor_.span.store(span, std::memory_order_relaxed);
+                anchor_.seq.store(seq + 2, std::memory_order_release);
+            }
+
+            // A TSC reading with the raw monotonic and wall clocks taken
+            // between its two halves
+            static void pairTsc(uint64_t& tsc, uint64_t& raw, uint64_t& wall) noexcept {
+                uint64_t before = readTsc();
+                raw = readClock(kRawClock);
+                wall = readClock(CLOCK_REALTIME);
+                uint64_t after = readTsc();
+                tsc = before + (after - before) / 2;
+            }
+
+            Anchor anchor_;
+            std::atomic<bool> renewing_{false};
+            uint64_t calibrated_tsc_ = 0;   // start of the calibration baseline
+            uint64_t calibrated_raw_ = 0;
+        };
+
+        State& state() {
+            static State instance;
+            return instance;
+        }
+
+    } // namespace
+
+    uint64_t EventClock::now() noexcept {
+        thread_local uint64_t last = 0;
+        uint64_t ns = state().read();
+        if (ns <= last) ns = last + 1;
+        last = ns;
+        return ns;
+    }
+
+    EventClock::Source EventClock::source() noexcept {
+        return state().source();
+    }
+
+    EventClock::Source EventClock::setSource(Source source) {
+        return state().use(source);
+    }
+
+    bool EventClock::tscSupported() noexcept {
+        return invariantTsc();
+    }
+
+    const char* EventClock::sourceName(Source source) noexcept {
+        switch (source) {
+            case Source::TSC: return "tsc";
+            case Source::COARSE: return "coarse";
+            case Source::SYSTEM: return "system";
+        }
+        return "unknown";
+    }
+
+} // namespace EventStream
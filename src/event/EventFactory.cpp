@@ -3,50 +3,87 @@
 
 namespace EventStream {
 
-    uint32_t EventFactory::calculateCRC32(const std::vector<uint8_t>& data) {
-        static uint32_t CRC32_TABLE[256];
-        static bool initialized = false;
-
-        if (!initialized) {
-            for (uint32_t i = 0; i < 256; i++) {
-                uint32_t crc = i;
-                for (int j = 0; j < 8; j++) {
-                    if (crc & 1)
-                        crc = (crc >> 1) ^ 0xEDB88320;
-                    else
-                        crc >>= 1;
-                }
-                CRC32_TABLE[i] = crc;
-            }
-            initialized = true;
-        }
-
-        uint32_t crc = 0xFFFFFFFF;
-        for (uint8_t byte : data) {
-            crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ byte) & 0xFF];
-        }
-        return crc ^ 0xFFFFFFFF;
-    }
-
     std::atomic<uint64_t> EventFactory::global_event_id{0};
     
     Event EventFactory::createEvent(EventSourceType sourceType,
                                     EventPriority priority,
                                     std::vector<uint8_t>&& payload,
                                     std::string&& topic,
-                                    std::unordered_map<std::string,std::string>&& metadata
+                                    Metadata&& metadata
                                     ) {
         EventHeader h;
         h.priority = priority;
-        h.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+        h.timestamp = nowNanos();
         h.sourceType = sourceType;
-        h.id = global_event_id.fetch_add(1, std::memory_order_relaxed);
+        h.id = reserveIds(1);
         h.topic_len = topic.size();
         h.body_len = payload.size();
-        h.crc32 = EventFactory::calculateCRC32(payload);
+        h.crc32 = Checksum::crc32c(payload);
+        h.checksumAlgo = ChecksumAlgorithm::CRC32C;
+
+        return Event(h, Topic(topic), std::move(payload), std::move(metadata));
+    }
 
-        return Event(h,std::move(topic),std::move(payload),std::move(metadata));
+    Event EventFactory::createEvent(EventSourceType sourceType,
+                                    EventPriority priority,
+                                    std::span<const uint8_t> payload,
+                                    std::string_view topic,
+                                    Metadata&& metadata
+                                    ) {
+        EventHeader h;
+        h.priority = priority;
+        h.timestamp = nowNanos();
+        h.sourceType = sourceType;
+        h.id = reserveIds(1);
+        h.topic_len = topic.size();
+        h.body_len = payload.size();
+        h.crc32 = Checksum::crc32c(payload);
+        h.checksumAlgo = ChecksumAlgorithm::CRC32C;
+        return Event(h, Topic(topic), payload, std::move(metadata));
+    }
+
+    uint64_t EventFactory::reserveIds(size_t count) {
+        struct Lease {
+            uint64_t next = 0;
+            uint64_t end = 0;
+        };
+        thread_local Lease lease;
+        if (lease.end - lease.next < count) {
+            if (count >= kIdLeaseSize) {
+                // Dropping the rest of the lease keeps this thread's ids increasing
+                lease.next = lease.end;
+                return global_event_id.fetch_add(count, std::memory_order_relaxed);
+            }
+            lease.next = global_event_id.fetch_add(kIdLeaseSize, std::memory_order_relaxed);
+            lease.end = lease.next + kIdLeaseSize;
+        }
+        uint64_t first = lease.next;
+        lease.next += count;
+        return first;
+    }
+
+    uint64_t EventFactory::nowNanos() {
+        return EventClock::now();
+    }
+
+    EventPtr EventFactory::createEvent(EventSourceType sourceType,
+                                       EventPriority priority,
+                                       std::span<const uint8_t> payload,
+                                       Topic topic,
+                                       Metadata&& metadata,
+                                       uint64_t id,
+                                       uint64_t timestamp
+                                       ) {
+        EventHeader h;
+        h.priority = priority;
+        h.timestamp = timestamp;
+        h.sourceType = sourceType;
+        h.id = id;
+        h.topic_len = topic.size();
+        h.body_len = payload.size();
+        h.crc32 = Checksum::crc32c(payload);
+        h.checksumAlgo = ChecksumAlgorithm::CRC32C;
+        return makeEvent(h, topic, payload, std::move(metadata));
     }
 
 } // namespace EventStream
@@ -0,0 +1,149 @@
+#include "event/EventPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace EventStream {
+
+    namespace {
+
+        constexpr size_t kClasses = std::countr_zero(EventPool::kMaxPooledBytes / EventPool::kMinBlockBytes) + 1;
+        constexpr size_t kChunkBytes = 256 * 1024;
+
+        std::atomic<size_t> reserved{0};
+
+        struct Cache;
+
+        // Precedes every block and stays valid while the block is free
+        struct alignas(16) BlockHeader {
+            Cache* owner;    // nullptr: straight from the heap
+            size_t bytes;    // usable size
+        };
+
+        // What a free block holds
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct Cache {
+            FreeBlock* free[kClasses] = {};                     // owning thread only
+            std::atomic<FreeBlock*> returned[kClasses] = {};    // pushed by other threads
+        };
+
+        size_t classOf(size_t bytes) {
+            if (bytes <= EventPool::kMinBlockBytes) return 0;
+            return std::bit_width(bytes - 1) - std::countr_zero(EventPool::kMinBlockBytes);
+        }
+
+        // Caches of exited threads, handed to the next new one; never freed,
+        // since blocks they own may still be in use anywhere
+        std::mutex& orphanMutex() {
+            static auto* mutex = new std::mutex;
+            return *mutex;
+        }
+
+        std::vector<Cache*>& orphans() {
+            static auto* caches = new std::vector<Cache*>;
+            return *caches;
+        }
+
+        // Trivially destructible, so still readable while the thread exits
+        thread_local Cache* t_cache = nullptr;
+        thread_local bool t_exited = false;
+
+        struct CacheRelease {
+            ~CacheRelease() {
+                if (!t_cache) return;
+                std::lock_guard lock(orphanMutex());
+                orphans().push_back(t_cache);
+                t_cache = nullptr;
+                t_exited = true;
+            }
+        };
+        thread_local CacheRelease t_release;
+
+        // nullptr once the thread is exiting
+        Cache* localCache() {
+            if (t_cache) return t_cache;
+            if (t_exited) return nullptr;
+            (void)&t_release;   // registers the hand-back at thread exit
+            {
+                std::lock_guard lock(orphanMutex());
+                if (!orphans().empty()) {
+                    t_cache = orphans().back();
+                    orphans().pop_back();
+                }
+            }
+            if (!t_cache) t_cache = new Cache();
+            return t_cache;
+        }
+
+        void* heapBlock(size_t bytes) {
+            auto* header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + bytes));
+            header->owner = nullptr;
+            header->bytes = bytes;
+            return header + 1;
+        }
+
+        // Carves a fresh chunk into blocks of one class; returns them linked
+        FreeBlock* refill(Cache& cache, size_t cls) {
+            size_t bytes = EventPool::kMinBlockBytes << cls;
+            size_t stride = sizeof(BlockHeader) + bytes;
+            size_t count = std::max<size_t>(1, kChunkBytes / stride);
+            auto* chunk = static_cast<unsigned char*>(::operator new(stride * count));
+            reserved.fetch_add(stride * count, std::memory_order_relaxed);
+            FreeBlock* head = nullptr;
+            for (size_t i = count; i-- > 0;) {
+                auto* header = new (chunk + i * stride) BlockHeader{&cache, bytes};
+                head = new (header + 1) FreeBlock{head};
+            }
+            return head;
+        }
+
+    } // namespace
+
+    void* EventPool::allocate(size_t bytes) {
+        if (bytes > kMaxPooledBytes) return heapBlock(bytes);
+        size_t cls = classOf(bytes);
+        Cache* cache = localCache();
+        if (!cache) return heapBlock(kMinBlockBytes << cls);
+
+        FreeBlock* block = cache->free[cls];
+        if (!block) block = cache->returned[cls].exchange(nullptr, std::memory_order_acquire);
+        if (!block) block = refill(*cache, cls);
+        cache->free[cls] = block->next;
+        return block;
+    }
+
+    void EventPool::deallocate(void* block) noexcept {
+        if (!block) return;
+        auto* header = static_cast<BlockHeader*>(block) - 1;
+        if (!header->owner) {
+            ::operator delete(header);
+            return;
+        }
+        size_t cls = classOf(header->bytes);
+        if (header->owner == t_cache) {
+            t_cache->free[cls] = new (block) FreeBlock{t_cache->free[cls]};
+            return;
+        }
+        // Only the owner ever takes from this stack, and it takes all of it, so
+        // a plain CAS push is ABA-free
+        auto& stack = header->owner->returned[cls];
+        auto* node = new (block) FreeBlock{stack.load(std::memory_order_relaxed)};
+        while (!stack.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    size_t EventPool::capacity(const void* block) noexcept {
+        return (static_cast<const BlockHeader*>(block) - 1)->bytes;
+    }
+
+    size_t EventPool::reservedBytes() noexcept {
+        return reserved.load(std::memory_order_relaxed);
+    }
+
+} // namespace EventStream
@@ -0,0 +1,114 @@
+#include "event/Metadata.hpp"
+#include "event/NameTable.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace EventStream {
+
+    namespace {
+
+        // Never destroyed: threads still running at exit may be reading it
+        NameTable& keys() {
+            static auto* instance = new NameTable("Metadata key", MetadataKey::kMaxKeys);
+            return *instance;
+        }
+
+    } // namespace
+
+    MetadataKey::MetadataKey(std::string_view name)
+        : id_(static_cast<uint16_t>(keys().intern(name))) {}
+
+    std::optional<MetadataKey> MetadataKey::find(std::string_view name) {
+        auto id = keys().find(name);
+        if (!id) return std::nullopt;
+        return fromId(static_cast<uint16_t>(*id));
+    }
+
+    std::string_view MetadataKey::name() const noexcept {
+        return keys().name(id_);
+    }
+
+    Metadata::Metadata(std::initializer_list<std::pair<std::string_view, std::string_view>> entries) {
+        for (const auto& [key, value] : entries) set(key, value);
+    }
+
+    Metadata::Metadata(const Metadata& other) : values_(other.values_) {
+        copySlots(other);
+    }
+
+    Metadata::Metadata(Metadata&& other) noexcept : values_(std::move(other.values_)) {
+        takeSlots(other);
+    }
+
+    Metadata& Metadata::operator=(const Metadata& other) {
+        if (this != &other) {
+            values_ = other.values_;
+            copySlots(other);
+        }
+        return *this;
+    }
+
+    Metadata& Metadata::operator=(Metadata&& other) noexcept {
+        if (this != &other) {
+            values_ = std::move(other.values_);
+            EventPool::deallocate(std::exchange(heap_slots_, nullptr));
+            takeSlots(other);
+        }
+        return *this;
+    }
+
+    void Metadata::copySlots(const Metadata& other) {
+        if (other.count_ > capacity_) {
+            auto* block = static_cast<Slot*>(EventPool::allocate(other.count_ * sizeof(Slot)));
+            EventPool::deallocate(heap_slots_);
+            heap_slots_ = block;
+            capacity_ = static_cast<uint16_t>(
+                std::min<size_t>(EventPool::capacity(block) / sizeof(Slot), UINT16_MAX));
+        }
+        std::memcpy(slots(), other.slots(), other.count_ * sizeof(Slot));
+        count_ = other.count_;
+    }
+
+    void Metadata::takeSlots(Metadata& other) noexcept {
+        heap_slots_ = std::exchange(other.heap_slots_, nullptr);
+        count_ = std::exchange(other.count_, 0);
+        capacity_ = std::exchange(other.capacity_, static_cast<uint16_t>(kInlineEntries));
+        if (!heap_slots_) {
+            capacity_ = kInlineEntries;
+            std::memcpy(inline_slots_, other.inline_slots_, count_ * sizeof(Slot));
+        }
+    }
+
+    void Metadata::set(MetadataKey key, std::string_view value) {
+        if (value.size() > kMaxValueBytes) {
+            throw std::length_error("Metadata value exceeds " + std::to_string(kMaxValueBytes) + " bytes");
+        }
+        auto* slot = const_cast<Slot*>(slotOf(key.id()));
+        if (slot && value.size() <= slot->length) {
+            if (!value.empty()) std::memcpy(values_.data() + slot->offset, value.data(), value.size());
+            slot->length = static_cast<uint16_t>(value.size());
+            return;
+        }
+        if (!slot) {
+            if (count_ == capacity_) {
+                if (capacity_ == UINT16_MAX) throw std::length_error("Too many metadata entries");
+                auto* block = static_cast<Slot*>(EventPool::allocate(2 * capacity_ * sizeof(Slot)));
+                std::memcpy(block, slots(), count_ * sizeof(Slot));
+                EventPool::deallocate(heap_slots_);
+                heap_slots_ = block;
+                capacity_ = static_cast<uint16_t>(
+                    std::min<size_t>(EventPool::capacity(block) / sizeof(Slot), UINT16_MAX));
+            }
+            slot = slots() + count_++;
+            slot->key = key.id();
+        }
+        size_t offset = values_.size();
+        values_.resize(offset + value.size());
+        if (!value.empty()) std::memcpy(values_.data() + offset, value.data(), value.size());
+        slot->offset = static_cast<uint32_t>(offset);
+        slot->length = static_cast<uint16_t>(value.size());
+    }
+
+} // namespace EventStream
@@ -0,0 +1,63 @@
+#include "event/NameTable.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace EventStream {
+
+    namespace {
+        std::atomic<size_t> tables{0};
+    }
+
+    NameTable::NameTable(std::string_view what, size_t max_names)
+        : what_(what), max_names_(std::min(max_names, TopicRegistry::kMaxTopics)),
+          index_(tables.fetch_add(1, std::memory_order_relaxed)) {}
+
+    NameTable::Known& NameTable::knownHere() const {
+        thread_local std::vector<Known> known;
+        if (index_ >= known.size()) known.resize(index_ + 1);
+        return known[index_];
+    }
+
+    uint32_t NameTable::intern(std::string_view name) {
+        auto id = tryIntern(name, max_names_);
+        if (!id) throw std::length_error(what_ + " table is full");
+        return *id;
+    }
+
+    std::optional<uint32_t> NameTable::tryIntern(std::string_view name, size_t limit) {
+        if (name.empty()) return 0;
+        Known& known = knownHere();
+        if (auto it = known.find(name); it != known.end()) return it->second;
+
+        uint32_t id;
+        std::string_view stored;
+        {
+            std::lock_guard lock(mutex_);
+            if (auto it = ids_.find(name); it != ids_.end()) {
+                id = it->second;
+                stored = it->first;
+            } else {
+                id = count_.load(std::memory_order_relaxed);
+                if (id >= std::min(limit, max_names_)) return std::nullopt;
+                stored = storage_.emplace_back(name);
+                slots_[id] = {stored, TopicRegistry::stableHash(stored)};
+                ids_.emplace(stored, id);
+                count_.store(id + 1, std::memory_order_release);
+            }
+        }
+        known.emplace(stored, id);
+        return id;
+    }
+
+    std::optional<uint32_t> NameTable::find(std::string_view name) {
+        if (name.empty()) return 0;
+        Known& known = knownHere();
+        if (auto it = known.find(name); it != known.end()) return it->second;
+        std::lock_guard lock(mutex_);
+        auto it = ids_.find(name);
+        if (it == ids_.end()) return std::nullopt;
+        return it->second;
+    }
+
+} // namespace EventStream
@@ -0,0 +1,40 @@
+#include "event/TopicRegistry.hpp"
+#include "event/NameTable.hpp"
+
+namespace EventStream {
+
+    namespace {
+
+        // Never destroyed: threads still running at exit may be reading it
+        NameTable& topics() {
+            static auto* instance = new NameTable("Topic", TopicRegistry::kMaxTopics);
+            return *instance;
+        }
+
+    } // namespace
+
+    uint32_t TopicRegistry::intern(std::string_view name) {
+        return topics().intern(name);
+    }
+
+    std::optional<uint32_t> TopicRegistry::tryIntern(std::string_view name, size_t limit) {
+        return topics().tryIntern(name, limit);
+    }
+
+    std::optional<uint32_t> TopicRegistry::find(std::string_view name) {
+        return topics().find(name);
+    }
+
+    std::string_view TopicRegistry::name(uint32_t id) noexcept {
+        return topics().name(id);
+    }
+
+    uint64_t TopicRegistry::hash(uint32_t id) noexcept {
+        return topics().hash(id);
+    }
+
+    uint32_t TopicRegistry::size() noexcept {
+        return topics().size();
+    }
+
+} // namespace EventStream
@@ -1,25 +1,44 @@
 #include "event/Topic_table.hpp"
+#include "utils/epoch.hpp"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <memory>
 #include <mutex>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 using namespace EventStream;
 
+TopicTable::~TopicTable() {
+    StopWatching();
+    if (const Snapshot* table = current_.exchange(nullptr, std::memory_order_acq_rel)) Epoch::retire(table);
+}
+
 bool TopicTable::LoadFileConfig(const std::string& path) {
-    std::unique_lock lock(share_mutex);
+    std::lock_guard lock(load_mutex_);
     std::ifstream ifs(path);
-    if (!ifs) return false;
+    if (!ifs) {
+        spdlog::error("Cannot read topic configuration {}", path);
+        return false;
+    }
+
+    auto table = std::make_unique<Snapshot>();
     std::string line;
+    size_t number = 0;
     while (std::getline(ifs, line)) {
-       
+        ++number;
         auto posc = line.find('#');
         if (posc != std::string::npos) line = line.substr(0, posc);
-        auto pos = line.find(':');
-        if (pos == std::string::npos) continue;
-        std::string topic = line.substr(0, pos);
-        std::string pr = line.substr(pos + 1);
-        
+
         auto trim = [](std::string &s){
             size_t a = s.find_first_not_of(" \t\r\n");
             size_t b = s.find_last_not_of(" \t\r\n");
@@ -27,27 +46,123 @@ bool TopicTable::LoadFileConfig(const std::string& path) {
             s = s.substr(a, b - a + 1);
         };
 
+        trim(line);
+        if (line.empty()) continue;
+        auto pos = line.find(':');
+        std::string topic = pos == std::string::npos ? line : line.substr(0, pos);
+        std::string pr = pos == std::string::npos ? "" : line.substr(pos + 1);
         trim(topic); trim(pr);
-        if (topic.empty() || pr.empty()) continue;
-        if (pr == "LOW")           Table[topic] = EventPriority::LOW;
-        else if (pr == "MEDIUM")   Table[topic] = EventPriority::MEDIUM;
-        else if (pr == "HIGH")     Table[topic] = EventPriority::HIGH;
-        else if (pr == "CRITICAL") Table[topic] = EventPriority::CRITICAL;
-        else  continue; 
-        
+
+        EventPriority priority;
+        if (pr == "LOW")           priority = EventPriority::LOW;
+        else if (pr == "MEDIUM")   priority = EventPriority::MEDIUM;
+        else if (pr == "HIGH")     priority = EventPriority::HIGH;
+        else if (pr == "CRITICAL") priority = EventPriority::CRITICAL;
+        else topic.clear();
+        if (topic.empty()) {
+            spdlog::error("{}:{}: expected 'topic: LOW|MEDIUM|HIGH|CRITICAL', got '{}'; keeping the current table",
+                          path, number, line);
+            return false;
+        }
+
+        uint32_t id = TopicRegistry::intern(topic);
+        auto& priorities = table->priorities;
+        if (id >= priorities.size()) priorities.resize(id + 1, kUnset);
+        if (priorities[id] == kUnset) ++table->configured;
+        priorities[id] = static_cast<int8_t>(priority);
     }
-    spdlog::info("Loaded {} topics from {}", Table.size(), path);
+
+    size_t configured = table->configured;
+    if (const Snapshot* old = current_.exchange(table.release(), std::memory_order_acq_rel)) Epoch::retire(old);
+    version_.fetch_add(1, std::memory_order_release);
+    spdlog::info("Loaded {} topics from {}", configured, path);
+    return true;
+}
+
+bool TopicTable::FoundTopic(Topic topic, EventPriority& priority) const {
+    Epoch::Guard guard;
+    const Snapshot* table = current_.load(std::memory_order_acquire);
+    if (!table || topic.id() >= table->priorities.size()) return false;
+    int8_t found = table->priorities[topic.id()];
+    if (found == kUnset) return false;
+    priority = static_cast<EventPriority>(found);
     return true;
 }
 
 bool TopicTable::FoundTopic(const std::string& topic, EventPriority& priority) const {
-    std::shared_lock lock(share_mutex);
-    auto it = Table.find(topic);
-    if (it != Table.end()) {
-        priority = it->second;
-        return true;
+    auto id = TopicRegistry::find(topic);
+    return id && FoundTopic(Topic::fromId(*id), priority);
+}
+
+#ifdef __linux__
+
+bool TopicTable::WatchFile(const std::string& path) {
+    StopWatching();
+    std::filesystem::path file(path);
+    std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    // Editors and config tools either rewrite the file or rename a new one
+    // over it; watching the directory catches both
+    if (inotify_fd_ < 0 || wake_fd_ < 0 ||
+        inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        spdlog::warn("Cannot watch {} for topic configuration changes", directory);
+        StopWatching();
+        return false;
+    }
+    watcher_ = std::thread(&TopicTable::WatchLoop, this, path);
+    spdlog::info("Watching {} for topic configuration changes", path);
+    return true;
+}
+
+void TopicTable::StopWatching() {
+    if (watcher_.joinable()) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+        watcher_.join();
     }
+    if (inotify_fd_ >= 0) close(inotify_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    inotify_fd_ = wake_fd_ = -1;
+}
+
+void TopicTable::WatchLoop(std::string path) {
+    std::string name = std::filesystem::path(path).filename().string();
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            spdlog::error("Topic configuration watch failed: {}", std::strerror(errno));
+            return;
+        }
+        if (fds[1].revents) return;
+
+        // Drain everything queued so a burst of writes reloads once
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t at = 0; at < n;) {
+                auto* event = reinterpret_cast<const inotify_event*>(buffer + at);
+                if (event->len > 0 && name == event->name) changed = true;
+                at += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+        if (changed) LoadFileConfig(path);
+        Epoch::reclaim();
+    }
+}
+
+#else
+
+bool TopicTable::WatchFile(const std::string& path) {
+    spdlog::warn("Watching {} for changes needs inotify; reload by restarting", path);
     return false;
 }
 
+void TopicTable::StopWatching() {}
+
+void TopicTable::WatchLoop(std::string) {}
 
+#endif
@@ -0,0 +1,138 @@
+#include "ingest/client_connection.hpp"
+#include "ingest/tcp_parser.hpp"
+#include "event/EventFactory.hpp"
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <chrono>
+#include <unistd.h>
+
+// Topics a client may bring into the registry, process-wide
+static std::atomic<size_t> topic_limit{DEFAULT_CLIENT_TOPIC_LIMIT};
+
+void setClientTopicLimit(size_t limit) {
+    topic_limit.store(limit, std::memory_order_relaxed);
+}
+
+void closeSocket(int fd){
+    if (fd == -1) return;
+    #ifdef _WIN32
+        shutdown(fd, SD_BOTH);
+        closesocket(fd);
+    #else
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+    #endif
+}
+
+// Parses complete frames from the front of data and emits them as one batch;
+// returns the bytes consumed, or -1 if the stream is broken.
+static long parseFrames(std::span<const uint8_t> data, const std::string& address,
+                        const EventBatchSink& sink) {
+    // Reused across reads by the calling I/O thread
+    thread_local std::vector<FrameView> frames;
+    thread_local std::vector<EventStream::EventPtr> batch;
+    frames.clear();
+
+    size_t offset = 0;
+    bool broken = false;
+    while (data.size() - offset >= 4) {
+        auto rest = data.subspan(offset);
+        uint32_t frame_len = peekFrameLength(rest);
+
+        if (frame_len == 0) {
+            spdlog::warn("Zero length frame from {} -- skipping 4 bytes", address);
+            offset += 4;
+            continue;
+        }
+
+        if (frame_len > MAX_FRAME_SIZE) {
+            spdlog::error("Frame from {} exceeds buffer size. Closing connection.", address);
+            broken = true;
+            break;
+        }
+
+        if (rest.size() < 4 + static_cast<size_t>(frame_len)) {
+            break; // wait for more data
+        }
+        offset += 4 + frame_len;
+
+        try {
+            frames.push_back(parseTCPFrameView(rest.first(4 + frame_len)));
+        } catch (const std::exception &e) {
+            spdlog::warn("Failed to parse frame from {}: {}", address, e.what());
+        }
+    }
+
+    if (!frames.empty()) {
+        static const EventStream::MetadataKey client_address("client_address");
+        uint64_t id = EventStream::EventFactory::reserveIds(frames.size());
+        uint64_t timestamp = EventStream::EventFactory::nowNanos();
+        size_t limit = topic_limit.load(std::memory_order_relaxed);
+        size_t unregistered = 0;
+        batch.clear();
+        batch.reserve(frames.size());
+        for (const auto& frame : frames) {
+            auto topic = EventStream::TopicRegistry::tryIntern(frame.topic, limit);
+            if (!topic) {
+                ++unregistered;
+                continue;
+            }
+            try {
+                EventStream::Metadata metadata;
+                metadata.set(client_address, address);
+                batch.push_back(EventStream::EventFactory::createEvent(
+                    EventStream::EventSourceType::TCP,
+                    frame.priority,
+                    frame.payload,
+                    EventStream::Topic::fromId(*topic),
+                    std::move(metadata),
+                    id++,
+                    timestamp
+                ));
+            } catch (const std::exception &e) {
+                spdlog::warn("Dropped frame from {}: {}", address, e.what());
+            }
+        }
+        if (unregistered > 0) {
+            spdlog::warn("Dropped {} frames from {}: topic registry holds {} topics, new ones are refused",
+                         unregistered, address, limit);
+        }
+        if (!batch.empty()) {
+            spdlog::debug("Received {} frames ({} bytes) from {}", batch.size(), offset, address);
+            sink(batch);
+            batch.clear();
+        }
+    }
+    return broken ? -1 : static_cast<long>(offset);
+}
+
+void pushWithBackpressure(Dispatcher& dispatcher, std::span<EventStream::EventPtr> events,
+                          const std::atomic<bool>& running, const std::string& address) {
+    size_t pushed = 0;
+    while (running.load(std::memory_order_acquire)) {
+        pushed += dispatcher.pushBatchWithBackpressure(events.subspan(pushed), std::chrono::milliseconds(100));
+        if (pushed == events.size()) return;
+        if (!dispatcher.isRunning()) break;
+    }
+    spdlog::warn("Dropping {} events from {}: server shutting down", events.size() - pushed, address);
+}
+
+bool consumeFrames(ClientConnection& conn, const EventBatchSink& sink) {
+    long consumed = parseFrames(conn.buffer.readable(), conn.address, sink);
+    if (consumed < 0) return false;
+    conn.buffer.consume(static_cast<size_t>(consumed));
+    return true;
+}
+
+bool consumeFrames(ClientConnection& conn, std::span<const uint8_t> incoming,
+                   const EventBatchSink& sink) {
+    if (!conn.buffer.empty()) {
+        // A partial frame is pending; the new bytes have to join it
+        conn.buffer.append(incoming);
+        return consumeFrames(conn, sink);
+    }
+    long consumed = parseFrames(incoming, conn.address, sink);
+    if (consumed < 0) return false;
+    conn.buffer.append(incoming.subspan(static_cast<size_t>(consumed)));
+    return true;
+}
@@ -0,0 +1,257 @@
+#include "ingest/epoll_ingest_server.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace {
+
+constexpr int kMaxEvents = 256;
+// Minimum free space per recv(); each connection buffer grows to at least this
+constexpr size_t kRecvChunk = 16 * 1024;
+// Bytes read from one connection per turn, so a busy client cannot starve the rest
+constexpr size_t kReadBudget = 256 * 1024;
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+EpollIngestServer::EpollIngestServer(Dispatcher& dispatcher, int port, int ioThreads, int maxConnections)
+    : IngestServer(dispatcher), serverPort(port), ioThreadCount(ioThreads > 0 ? ioThreads : 1),
+      maxConnections(maxConnections) {
+}
+
+EpollIngestServer::~EpollIngestServer() {
+    stop();
+}
+
+void EpollIngestServer::start() {
+    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        spdlog::error("Failed to create socket for epoll TCP Ingest Server");
+        return;
+    }
+
+    int reuse = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(serverPort);
+
+    if (bind(server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0 ||
+        listen(server_fd, SOMAXCONN) < 0) {
+        spdlog::error("Failed to bind/listen on port {}", serverPort);
+        closeSocket(server_fd);
+        server_fd = -1;
+        return;
+    }
+
+    isRunning.store(true, std::memory_order_release);
+    for (int i = 0; i < ioThreadCount; ++i) {
+        auto io = std::make_unique<IoThread>();
+        io->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        io->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;  // nullptr marks the wake fd
+        epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, io->wake_fd, &ev);
+        io->thread = std::thread(&EpollIngestServer::ioLoop, this, std::ref(*io));
+        ioThreads.push_back(std::move(io));
+    }
+
+    acceptThread = std::thread(&EpollIngestServer::acceptConnections, this);
+    spdlog::info("Epoll TCP Ingest Server started on port {} with {} I/O thread(s)",
+                 serverPort, ioThreadCount);
+}
+
+void EpollIngestServer::stop() {
+    if (!isRunning.exchange(false, std::memory_order_acq_rel)) return;
+
+    if (server_fd != -1) {
+        closeSocket(server_fd);
+        server_fd = -1;
+    }
+    if (acceptThread.joinable()) {
+        acceptThread.join();
+    }
+
+    for (auto& io : ioThreads) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t w = write(io->wake_fd, &one, sizeof(one));
+    }
+    for (auto& io : ioThreads) {
+        if (io->thread.joinable()) io->thread.join();
+        // Connections handed over after the loop exited
+        ClientConnection* conn = nullptr;
+        while (io->incoming.tryPop(conn)) {
+            closeSocket(conn->fd);
+            activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+            delete conn;
+        }
+        close(io->wake_fd);
+        close(io->epoll_fd);
+    }
+    ioThreads.clear();
+
+    spdlog::info("Epoll TCP Ingest Server stopped.");
+}
+
+void EpollIngestServer::acceptConnections() {
+    while (isRunning.load(std::memory_order_acquire)) {
+        sockaddr_in clientaddr{};
+        socklen_t clientlen = sizeof(clientaddr);
+        int client_fd = accept4(server_fd, (struct sockaddr*)&clientaddr, &clientlen, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (isRunning.load(std::memory_order_acquire) && errno != EINTR) {
+                spdlog::error("Failed to accept client connection");
+            }
+            continue;
+        }
+
+        std::string client_address = inet_ntoa(clientaddr.sin_addr);
+        if (maxConnections > 0 && activeConnections_.load(std::memory_order_acquire) >= maxConnections) {
+            spdlog::warn("Rejecting connection from {}: maxConnections ({}) reached",
+                         client_address, maxConnections);
+            closeSocket(client_fd);
+            continue;
+        }
+        if (!setNonBlocking(client_fd)) {
+            spdlog::error("Failed to make socket from {} non-blocking", client_address);
+            closeSocket(client_fd);
+            continue;
+        }
+
+        auto* conn = new ClientConnection(client_fd, client_address);
+        IoThread& io = *ioThreads[nextIoThread++ % ioThreads.size()];
+        if (!io.incoming.tryPush(conn)) {
+            spdlog::warn("I/O thread hand-off queue full, rejecting {}", client_address);
+            closeSocket(client_fd);
+            delete conn;
+            continue;
+        }
+        activeConnections_.fetch_add(1, std::memory_order_acq_rel);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t w = write(io.wake_fd, &one, sizeof(one));
+        spdlog::info("Accepted connection from {}", client_address);
+    }
+}
+
+void EpollIngestServer::adoptIncoming(IoThread& io,
+                                      std::unordered_map<int, std::unique_ptr<ClientConnection>>& connections) {
+    ClientConnection* raw = nullptr;
+    while (io.incoming.tryPop(raw)) {
+        std::unique_ptr<ClientConnection> conn(raw);
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn.get();
+        if (epoll_ctl(io.epoll_fd, EPOLL_CTL_ADD, conn->fd, &ev) < 0) {
+            spdlog::error("epoll_ctl failed for {}", conn->address);
+            closeSocket(conn->fd);
+            activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+            continue;
+        }
+        int fd = conn->fd;
+        connections.emplace(fd, std::move(conn));
+    }
+}
+
+bool EpollIngestServer::readConnection(ClientConnection& conn) {
+    // Blocks this I/O thread (and so every connection on it) while the
+    // dispatcher is full, which is the backpressure we want.
+    auto sink = [this, &conn](std::span<EventStream::EventPtr> events) {
+        pushWithBackpressure(dispatcher_, events, isRunning, conn.address);
+    };
+
+    size_t budget = kReadBudget;
+    while (budget > 0) {
+        auto space = conn.buffer.prepare(kRecvChunk);
+        ssize_t n = recv(conn.fd, space.data(), space.size(), 0);
+        if (n > 0) {
+            conn.buffer.commit(static_cast<size_t>(n));
+            if (!consumeFrames(conn, sink)) return false;
+            budget -= std::min(budget, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            spdlog::info("Client {} disconnected.", conn.address);
+            return false;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            conn.readable = false;  // drained: wait for the next edge
+            return true;
+        }
+        spdlog::warn("recv failed for {}: errno {}", conn.address, errno);
+        return false;
+    }
+    return true;  // budget spent, socket still readable
+}
+
+void EpollIngestServer::ioLoop(IoThread& io) {
+    std::unordered_map<int, std::unique_ptr<ClientConnection>> connections;
+    // Edge-triggered sockets with unread data; serviced round-robin so that
+    // pausing for backpressure never loses an edge.
+    std::deque<ClientConnection*> readable;
+    epoll_event events[kMaxEvents];
+
+    auto closeConnection = [&](ClientConnection* conn) {
+        epoll_ctl(io.epoll_fd, EPOLL_CTL_DEL, conn->fd, nullptr);
+        closeSocket(conn->fd);
+        spdlog::info("Closed connection with client {}", conn->address);
+        activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+        connections.erase(conn->fd);
+    };
+
+    while (isRunning.load(std::memory_order_acquire)) {
+        bool paused = dispatcher_.isBackpressured();
+        int timeout_ms = (!readable.empty() && !paused) ? 0 : (paused ? 10 : 100);
+        int n = epoll_wait(io.epoll_fd, events, kMaxEvents, timeout_ms);
+        if (n < 0 && errno != EINTR) {
+            spdlog::error("epoll_wait failed: errno {}", errno);
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            auto* conn = static_cast<ClientConnection*>(events[i].data.ptr);
+            if (conn == nullptr) {
+                uint64_t counter;
+                [[maybe_unused]] ssize_t r = read(io.wake_fd, &counter, sizeof(counter));
+                adoptIncoming(io, connections);
+                continue;
+            }
+            // Hang-ups are reported as readable so buffered bytes are still consumed
+            if (!conn->readable) {
+                conn->readable = true;
+                readable.push_back(conn);
+            }
+        }
+
+        // Above the high watermark: leave sockets unread so TCP pushes back
+        if (paused) continue;
+
+        for (size_t pending = readable.size(); pending > 0; --pending) {
+            ClientConnection* conn = readable.front();
+            readable.pop_front();
+            if (!readConnection(*conn)) {
+                closeConnection(conn);
+                continue;
+            }
+            if (conn->readable) readable.push_back(conn);
+        }
+    }
+
+    for (auto& [fd, conn] : connections) {
+        closeSocket(fd);
+        activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
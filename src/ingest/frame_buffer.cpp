@@ -0,0 +1,32 @@
+#include "ingest/frame_buffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+std::span<uint8_t> FrameBuffer::prepare(size_t minBytes) {
+    if (storage_.size() - write_ < minBytes) {
+        size_t live = write_ - read_;
+        if (read_ >= live && storage_.size() - live >= minBytes) {
+            // Non-overlapping move of the partial frame to the front
+            std::memcpy(storage_.data(), storage_.data() + read_, live);
+            read_ = 0;
+            write_ = live;
+        } else {
+            if (read_ > 0) {
+                std::memmove(storage_.data(), storage_.data() + read_, live);
+                read_ = 0;
+                write_ = live;
+            }
+            if (storage_.size() - write_ < minBytes) {
+                storage_.resize(std::max(storage_.size() * 2, write_ + minBytes));
+            }
+        }
+    }
+    return {storage_.data() + write_, storage_.size() - write_};
+}
+
+void FrameBuffer::append(std::span<const uint8_t> bytes) {
+    if (bytes.empty()) return;
+    auto dst = prepare(bytes.size());
+    std::memcpy(dst.data(), bytes.data(), bytes.size());
+    commit(bytes.size());
+}
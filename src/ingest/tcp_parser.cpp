@@ -20,7 +20,13 @@ static uint8_t read_uint8_be(const uint8_t* data) {
     return *data; 
 }
 
-ParsedResult parseFrame(const std::vector<uint8_t>& frame_body) {
+uint32_t peekFrameLength(std::span<const uint8_t> data) {
+    if (data.size() < 4)
+        throw std::runtime_error("Too small to contain frame length");
+    return read_uint32_be(data.data());
+}
+
+FrameView parseFrameView(std::span<const uint8_t> frame_body) {
     if (frame_body.size() < 3) 
         throw std::runtime_error("Too small body to contain priority + topic_len");
 
@@ -40,28 +46,29 @@ ParsedResult parseFrame(const std::vector<uint8_t>& frame_body) {
     if (topic_len == 0)
         throw std::runtime_error("Topic length cannot be zero");
 
-    ParsedResult r;
+    FrameView r;
     r.priority = static_cast<EventStream::EventPriority>(priority_val);
-    r.topic = std::string(reinterpret_cast<const char*>(data + 3), topic_len);
-
-    size_t payload_offset = 3 + topic_len;
-    if (payload_offset < len) 
-        r.payload.assign(frame_body.begin() + payload_offset, frame_body.end());
-    else 
-        r.payload.clear();
-
+    r.topic = std::string_view(reinterpret_cast<const char*>(data + 3), topic_len);
+    r.payload = frame_body.subspan(3 + topic_len);
     return r;
 }
 
-ParsedResult parseTCPFrame(const std::vector<uint8_t>& full_frame_include_length) {
-    if (full_frame_include_length.size() < 4) 
-        throw std::runtime_error("Too small to contain frame length");
-
-    const uint8_t* data = full_frame_include_length.data();
-    uint32_t frame_len = read_uint32_be(data);
+FrameView parseTCPFrameView(std::span<const uint8_t> full_frame_include_length) {
+    uint32_t frame_len = peekFrameLength(full_frame_include_length);
     if (frame_len != full_frame_include_length.size() - 4) 
         throw std::runtime_error("Frame length mismatch");
 
-    std::vector<uint8_t> frame_body(full_frame_include_length.begin() + 4, full_frame_include_length.end());
-    return parseFrame(frame_body);
+    return parseFrameView(full_frame_include_length.subspan(4));
+}
+
+ParsedResult parseFrame(const std::vector<uint8_t>& frame_body) {
+    FrameView view = parseFrameView(frame_body);
+    return ParsedResult{view.priority, std::string(view.topic),
+                        std::vector<uint8_t>(view.payload.begin(), view.payload.end())};
+}
+
+ParsedResult parseTCPFrame(const std::vector<uint8_t>& full_frame_include_length) {
+    FrameView view = parseTCPFrameView(full_frame_include_length);
+    return ParsedResult{view.priority, std::string(view.topic),
+                        std::vector<uint8_t>(view.payload.begin(), view.payload.end())};
 }
@@ -1,29 +1,17 @@
 #include "ingest/tcpingest_server.hpp"
 #include "event/EventFactory.hpp"
-#include "ingest/tcp_parser.hpp"
-#include <map>
+#include "ingest/client_connection.hpp"
 
 
   
-    TcpIngestServer::TcpIngestServer(Dispatcher& dispatcher, int port)
-        : IngestServer(dispatcher), serverPort(port), server_fd(-1) {
+    TcpIngestServer::TcpIngestServer(Dispatcher& dispatcher, int port, int maxConnections)
+        : IngestServer(dispatcher), serverPort(port), server_fd(-1), maxConnections(maxConnections) {
     }
 
     TcpIngestServer::~TcpIngestServer() {
         stop();
     }
 
-    void closeSocket(int fd){
-        if (fd == -1) return;
-        #ifdef _WIN32
-            shutdown(fd, SD_BOTH);
-            closesocket(fd);
-        #else
-            shutdown(fd, SHUT_RDWR);
-            close(fd);
-        #endif
-    }
-
     void TcpIngestServer::start() {
         #ifdef _WIN32 
         WSADATA wsaData;
@@ -40,6 +28,9 @@
             return;
         }
 
+        int reuse = 1;
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
         sockaddr_in server_addr{};
         server_addr.sin_family = AF_INET;
         server_addr.sin_addr.s_addr = INADDR_ANY;
@@ -75,12 +66,17 @@
             acceptThread.join();
         }
 
-        for (auto& t : clientThreads) {
+        std::vector<std::thread> clients;
+        {
+            std::lock_guard lock(clientsMutex);
+            clients.swap(clientThreads);
+            finishedClients.clear();
+        }
+        for (auto& t : clients) {
             if (t.joinable()) {
                 t.join();
             }
         }
-        clientThreads.clear();
 
         spdlog::info("TCP Ingest Server stopped.");
     }
@@ -97,78 +93,77 @@
                 continue;
             }
             std::string client_address = inet_ntoa(clientaddr.sin_addr);
+            reapClients();
+            if (maxConnections > 0 && activeConnections_.load(std::memory_order_acquire) >= maxConnections) {
+                spdlog::warn("Rejecting connection from {}: maxConnections ({}) reached",
+                             client_address, maxConnections);
+                closeSocket(client_fd);
+                continue;
+            }
+            activeConnections_.fetch_add(1, std::memory_order_acq_rel);
             spdlog::info("Accepted connection from {}", client_address); 
+            std::lock_guard lock(clientsMutex);
             clientThreads.emplace_back(&TcpIngestServer::handleClient , this ,client_fd , client_address);
         }
     }
     
     void TcpIngestServer::handleClient(int client_fd,std::string client_address) {
         constexpr size_t buffer_chunk = 4096;
-        constexpr uint32_t MAX_BUFFER_SIZE = 10 * 1024 * 1024;
-        std::vector<uint8_t> client_buf;
-        client_buf.reserve(8192);
-        char temp[buffer_chunk];
+        ClientConnection conn(client_fd, std::move(client_address));
+
+        // Blocks this connection (not drop) until the dispatcher has room
+        auto sink = [this, &conn](std::span<EventStream::EventPtr> events) {
+            pushWithBackpressure(dispatcher_, events, isRunning, conn.address);
+        };
 
         while (isRunning.load(std::memory_order_acquire)) {
-            ssize_t bytes_received = recv(client_fd, temp, buffer_chunk, 0);
+            // Pipeline is over its high watermark: stop reading so the socket
+            // buffer fills and TCP flow control pushes back on the producer.
+            if (dispatcher_.isBackpressured()) {
+                dispatcher_.waitForCapacity(std::chrono::milliseconds(100));
+                continue;
+            }
+
+            // Receive straight into the connection buffer, frames are parsed in place
+            auto space = conn.buffer.prepare(buffer_chunk);
+            ssize_t bytes_received = recv(client_fd, reinterpret_cast<char*>(space.data()), space.size(), 0);
             if (bytes_received <= 0) {
-                spdlog::info("Client {} disconnected.", client_address);
+                spdlog::info("Client {} disconnected.", conn.address);
                 break;
             }
 
-            client_buf.insert(client_buf.end(), temp, temp + bytes_received);
-            while (true) {
-                if (client_buf.size() < 4) break;
-
-                uint32_t frame_len = (static_cast<uint32_t>(client_buf[0]) << 24) |
-                                     (static_cast<uint32_t>(client_buf[1]) << 16) |
-                                     (static_cast<uint32_t>(client_buf[2]) << 8) |
-                                     (static_cast<uint32_t>(client_buf[3])); 
-
-                if (frame_len == 0) {
-                    spdlog::warn("Zero length frame from {} -- skipping 4 bytes", client_address);
-                    client_buf.erase(client_buf.begin(), client_buf.begin() + 4);
-                    continue;
-                }
-
-                if (frame_len > MAX_BUFFER_SIZE) {
-                    spdlog::error("Frame from {} exceeds buffer size. Closing connection.", client_address);
-                    closeSocket(client_fd);
-                    return; // break out of inner loop, then close socket below
-                }
-
-                if (client_buf.size() < 4 + frame_len) {
-                    break; // wait for more data
-                }
-
-                std::vector<uint8_t> full_frame(client_buf.begin(), client_buf.begin() + 4 + frame_len);
-                client_buf.erase(client_buf.begin(), client_buf.begin() + 4 + frame_len);
-
-                try {
-                    auto parsed = parseTCPFrame(full_frame);
-                    std::map<std::string,std::string> metadata;
-                    metadata["client_address"] = client_address;
-                    auto event = std::make_shared<EventStream::Event>(
-                        EventStream::EventFactory::createEvent(
-                            EventStream::EventSourceType::TCP,
-                            parsed.priority,
-                            std::move(parsed.payload),
-                            std::move(parsed.topic),
-                            std::move(std::unordered_map<std::string,std::string>(metadata.begin(), metadata.end()))
-                        )
-                    );
-                    dispatcher_.tryPush(event);
-                    spdlog::info("Received frame: {} bytes from {} with topic '{}' and eventID {}", 
-                                 4 + frame_len, client_address, event->topic, event->header.id);
-                } catch (const std::exception &e) {
-                    spdlog::warn("Failed to parse frame from {}: {}", client_address, e.what());
-                    continue;
-                }
-            }
+            conn.buffer.commit(static_cast<size_t>(bytes_received));
+            if (!consumeFrames(conn, sink)) break;
         }
 
         closeSocket(client_fd);
-        spdlog::info("Closed connection with client {}", client_address);
+        spdlog::info("Closed connection with client {}", conn.address);
+        {
+            std::lock_guard lock(clientsMutex);
+            finishedClients.push_back(std::this_thread::get_id());
+        }
+        activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
     }
 
+    void TcpIngestServer::reapClients() {
+        std::vector<std::thread> finished;
+        {
+            std::lock_guard lock(clientsMutex);
+            for (auto id : finishedClients) {
+                auto it = std::find_if(clientThreads.begin(), clientThreads.end(),
+                                       [id](const std::thread& t) { return t.get_id() == id; });
+                if (it == clientThreads.end()) continue;
+                finished.push_back(std::move(*it));
+                *it = std::move(clientThreads.back());
+                clientThreads.pop_back();
+            }
+            finishedClients.clear();
+        }
+        for (auto& t : finished) t.join();
+    }
+
+    size_t TcpIngestServer::clientThreadCount() {
+        std::lock_guard lock(clientsMutex);
+        return clientThreads.size();
+    }
 
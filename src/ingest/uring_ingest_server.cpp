@@ -0,0 +1,473 @@
+#include "ingest/uring_ingest_server.hpp"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr unsigned kRingEntries = 1024;
+constexpr unsigned kBufferCount = 1024;        // power of two, per worker
+constexpr unsigned kBufferSize = 16 * 1024;
+constexpr uint16_t kBufferGroup = 0;
+constexpr long long kTickNanos = 50'000'000;   // re-check shutdown/backpressure every 50ms
+
+constexpr uint64_t kTimeoutTag = 1;
+constexpr uint64_t kAcceptTag = 2;
+constexpr uint64_t kProvideTag = 3;
+constexpr uint64_t kCancelTag = 4;
+
+int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+unsigned loadAcquire(unsigned* p) { return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire); }
+void storeRelease(unsigned* p, unsigned v) { std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release); }
+
+// Minimal raw-syscall io_uring: SQ/CQ mmaps plus one provided buffer group.
+class Ring {
+public:
+    ~Ring() { destroy(); }
+
+    bool init() {
+        io_uring_params params{};
+        fd_ = uringSetup(kRingEntries, &params);
+        if (fd_ < 0) return false;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) { sqRing_ = nullptr; return false; }
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cqRing_ = sqRing_;
+        } else {
+            cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED) { cqRing_ = nullptr; return false; }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return false;
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<char*>(sqRing_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries_ = params.sq_entries;
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        localTail_ = *sqTail_;
+
+        auto* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        return initBuffers();
+    }
+
+    // Returns a zeroed SQE, submitting queued ones first if the SQ is full
+    io_uring_sqe* getSqe() {
+        if (localTail_ - loadAcquire(sqHead_) >= sqEntries_) {
+            submit(0);
+            if (localTail_ - loadAcquire(sqHead_) >= sqEntries_) return nullptr;
+        }
+        unsigned index = localTail_ & sqMask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray_[index] = index;
+        ++localTail_;
+        return sqe;
+    }
+
+    int submit(unsigned waitFor) {
+        unsigned toSubmit = localTail_ - *sqTail_;
+        storeRelease(sqTail_, localTail_);
+        if (toSubmit == 0 && waitFor == 0) return 0;
+        int ret;
+        do {
+            ret = uringEnter(fd_, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0);
+        } while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    template <typename F>
+    unsigned drainCompletions(F&& onCqe) {
+        unsigned head = *cqHead_;
+        unsigned tail = loadAcquire(cqTail_);
+        unsigned seen = 0;
+        for (; head != tail; ++head, ++seen) {
+            onCqe(cqes_[head & cqMask_]);
+        }
+        storeRelease(cqHead_, head);
+        return seen;
+    }
+
+    uint8_t* buffer(uint16_t bid) { return buffers_ + static_cast<size_t>(bid) * kBufferSize; }
+
+    // Hands a consumed buffer back to the kernel's group; goes out with the
+    // next submit and only posts a CQE if it fails. With the SQ full the
+    // buffer waits for returnBuffers().
+    void recycleBuffer(uint16_t bid) {
+        unreturned_.push_back(bid);
+        returnBuffers();
+    }
+
+    // Queues PROVIDE_BUFFERS for recycled buffers while the SQ has room;
+    // call again once a submit has made some
+    void returnBuffers() {
+        while (!unreturned_.empty()) {
+            io_uring_sqe* sqe = getSqe();
+            if (!sqe) return;
+            provideBuffers(sqe, unreturned_.back(), 1);
+            sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+            unreturned_.pop_back();
+        }
+    }
+
+private:
+    void provideBuffers(io_uring_sqe* sqe, uint16_t firstBid, unsigned count) {
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int>(count);
+        sqe->addr = reinterpret_cast<uint64_t>(buffer(firstBid));
+        sqe->len = kBufferSize;
+        sqe->off = firstBid;
+        sqe->buf_group = kBufferGroup;
+        sqe->user_data = kProvideTag;
+    }
+
+    bool initBuffers() {
+        void* buffers = mmap(nullptr, static_cast<size_t>(kBufferCount) * kBufferSize,
+                             PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (buffers == MAP_FAILED) return false;
+        buffers_ = static_cast<uint8_t*>(buffers);
+        unreturned_.reserve(kBufferCount);
+
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) return false;
+        provideBuffers(sqe, 0, kBufferCount);
+        if (submit(1) < 0) return false;
+        int res = -EIO;
+        drainCompletions([&res](const io_uring_cqe& cqe) {
+            if (cqe.user_data == kProvideTag) res = cqe.res;
+        });
+        if (res < 0) {
+            errno = -res;
+            return false;
+        }
+        return true;
+    }
+
+    void destroy() {
+        // The ring goes first: the kernel may still own provided buffers
+        if (fd_ >= 0) close(fd_);
+        if (sqes_) munmap(sqes_, sqesSize_);
+        if (cqRing_ && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+        if (sqRing_) munmap(sqRing_, sqRingSize_);
+        if (buffers_) munmap(buffers_, static_cast<size_t>(kBufferCount) * kBufferSize);
+    }
+
+    int fd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0, cqRingSize_ = 0, sqesSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned *sqHead_ = nullptr, *sqTail_ = nullptr, *sqArray_ = nullptr;
+    unsigned sqMask_ = 0, sqEntries_ = 0, localTail_ = 0;
+    unsigned *cqHead_ = nullptr, *cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    uint8_t* buffers_ = nullptr;
+    std::vector<uint16_t> unreturned_;   // consumed, not yet handed back
+};
+
+} // namespace
+
+// One ring + event loop per I/O thread. Connections stay on the worker whose
+// multishot accept produced them.
+class UringIngestServer::Worker {
+public:
+    Worker(UringIngestServer& server) : server_(server) {}
+
+    bool init() { return ring_.init(); }
+
+    void run() {
+        armAccept();
+        armTimeout();
+        while (server_.isRunning.load(std::memory_order_acquire)) {
+            if (ring_.submit(1) < 0) {
+                spdlog::error("io_uring_enter failed: errno {}", errno);
+                break;
+            }
+            ring_.returnBuffers();
+            ring_.drainCompletions([this](const io_uring_cqe& cqe) { onCompletion(cqe); });
+        }
+        for (auto& [fd, conn] : connections_) {
+            closeSocket(fd);
+            server_.activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        connections_.clear();
+    }
+
+private:
+    struct Connection {
+        Connection(int fd, std::string address) : state(fd, std::move(address)) {}
+        ClientConnection state;
+        bool closing = false;   // shut down, waiting for the final recv CQE
+        bool starved = false;   // no recv armed while backpressured
+        bool pausing = false;   // recv cancelled, waiting for its final CQE
+    };
+
+    void armAccept() {
+        io_uring_sqe* sqe = ring_.getSqe();
+        if (!sqe) return;
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = server_.server_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->user_data = kAcceptTag;
+    }
+
+    void armTimeout() {
+        io_uring_sqe* sqe = ring_.getSqe();
+        if (!sqe) return;
+        tick_.tv_sec = 0;
+        tick_.tv_nsec = kTickNanos;
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->addr = reinterpret_cast<uint64_t>(&tick_);
+        sqe->len = 1;
+        sqe->user_data = kTimeoutTag;
+    }
+
+    void armRecv(Connection& conn) {
+        io_uring_sqe* sqe = ring_.getSqe();
+        if (!sqe) {
+            conn.starved = true;  // retried on the next tick
+            return;
+        }
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = conn.state.fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+        sqe->user_data = reinterpret_cast<uint64_t>(&conn);
+        conn.starved = false;
+    }
+
+    // Stops a multishot recv; its final CQE arrives with -ECANCELED
+    void cancelRecv(Connection& conn) {
+        io_uring_sqe* sqe = ring_.getSqe();
+        if (!sqe) return;   // tried again on the next recv CQE
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = reinterpret_cast<uint64_t>(&conn);
+        sqe->user_data = kCancelTag;
+        conn.pausing = true;
+        // Right away: until it runs, the recv keeps filling buffers
+        ring_.submit(0);
+    }
+
+    void onCompletion(const io_uring_cqe& cqe) {
+        if (cqe.user_data == kProvideTag) {
+            spdlog::warn("io_uring failed to return a buffer to its group: errno {}", -cqe.res);
+        } else if (cqe.user_data == kCancelTag) {
+            // -ENOENT: the recv had already terminated on its own
+            if (cqe.res < 0 && cqe.res != -ENOENT && cqe.res != -EALREADY) {
+                spdlog::warn("io_uring failed to cancel a recv: errno {}", -cqe.res);
+            }
+        } else if (cqe.user_data == kTimeoutTag) {
+            onTick();
+        } else if (cqe.user_data == kAcceptTag) {
+            onAccept(cqe);
+        } else {
+            onRecv(*reinterpret_cast<Connection*>(cqe.user_data), cqe);
+        }
+    }
+
+    void onTick() {
+        if (!server_.dispatcher_.isBackpressured()) {
+            for (auto& [fd, conn] : connections_) {
+                if (conn->starved && !conn->closing) armRecv(*conn);
+            }
+        }
+        armTimeout();
+    }
+
+    void onAccept(const io_uring_cqe& cqe) {
+        if (!(cqe.flags & IORING_CQE_F_MORE) && server_.isRunning.load(std::memory_order_acquire)) {
+            armAccept();
+        }
+        if (cqe.res < 0) {
+            if (server_.isRunning.load(std::memory_order_acquire) && cqe.res != -ECANCELED) {
+                spdlog::error("io_uring accept failed: errno {}", -cqe.res);
+            }
+            return;
+        }
+
+        int client_fd = cqe.res;
+        sockaddr_in clientaddr{};
+        socklen_t clientlen = sizeof(clientaddr);
+        getpeername(client_fd, (struct sockaddr*)&clientaddr, &clientlen);
+        std::string client_address = inet_ntoa(clientaddr.sin_addr);
+
+        int limit = server_.maxConnections;
+        if (limit > 0 && server_.activeConnections_.fetch_add(1, std::memory_order_acq_rel) >= limit) {
+            server_.activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+            spdlog::warn("Rejecting connection from {}: maxConnections ({}) reached", client_address, limit);
+            closeSocket(client_fd);
+            return;
+        }
+        if (limit <= 0) server_.activeConnections_.fetch_add(1, std::memory_order_acq_rel);
+
+        auto conn = std::make_unique<Connection>(client_fd, client_address);
+        armRecv(*conn);
+        connections_.emplace(client_fd, std::move(conn));
+        spdlog::info("Accepted connection from {}", client_address);
+    }
+
+    void onRecv(Connection& conn, const io_uring_cqe& cqe) {
+        bool more = cqe.flags & IORING_CQE_F_MORE;
+
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+            uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            std::span<const uint8_t> data(ring_.buffer(bid), static_cast<size_t>(cqe.res));
+            if (!conn.closing) {
+                auto sink = [this, &conn](std::span<EventStream::EventPtr> events) {
+                    pushWithBackpressure(server_.dispatcher_, events, server_.isRunning, conn.state.address);
+                };
+                // Frames are parsed out of the kernel's buffer before it is recycled
+                if (!consumeFrames(conn.state, data, sink)) beginClose(conn);
+            }
+            ring_.recycleBuffer(bid);
+        }
+        if (more) {
+            // Over the high watermark: stop reading so the socket buffer fills
+            // and TCP flow control pushes back on the producer
+            if (!conn.closing && !conn.pausing && server_.dispatcher_.isBackpressured()) cancelRecv(conn);
+            return;
+        }
+
+        // Multishot recv terminated
+        conn.pausing = false;
+        if (!conn.closing && (cqe.res > 0 || cqe.res == -ENOBUFS || cqe.res == -ECANCELED)) {
+            // When backpressured, leave the socket unread; the tick re-arms after resume
+            if (server_.dispatcher_.isBackpressured()) conn.starved = true;
+            else armRecv(conn);
+            return;
+        }
+        if (cqe.res == 0) spdlog::info("Client {} disconnected.", conn.state.address);
+        else if (cqe.res < 0 && !conn.closing) spdlog::warn("recv failed for {}: errno {}", conn.state.address, -cqe.res);
+        finishClose(conn);
+    }
+
+    void beginClose(Connection& conn) {
+        // shutdown() completes the pending multishot recv with res == 0
+        conn.closing = true;
+        shutdown(conn.state.fd, SHUT_RDWR);
+    }
+
+    void finishClose(Connection& conn) {
+        int fd = conn.state.fd;
+        close(fd);
+        spdlog::info("Closed connection with client {}", conn.state.address);
+        server_.activeConnections_.fetch_sub(1, std::memory_order_acq_rel);
+        connections_.erase(fd);
+    }
+
+    UringIngestServer& server_;
+    Ring ring_;
+    __kernel_timespec tick_{};
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+};
+
+UringIngestServer::UringIngestServer(Dispatcher& dispatcher, int port, int ioThreads, int maxConnections)
+    : IngestServer(dispatcher), serverPort(port), ioThreadCount(ioThreads > 0 ? ioThreads : 1),
+      maxConnections(maxConnections) {
+}
+
+UringIngestServer::~UringIngestServer() {
+    stop();
+}
+
+bool UringIngestServer::isSupported() {
+    Ring probe;
+    return probe.init();
+}
+
+void UringIngestServer::start() {
+    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        spdlog::error("Failed to create socket for io_uring TCP Ingest Server");
+        return;
+    }
+
+    int reuse = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(serverPort);
+
+    if (bind(server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0 ||
+        listen(server_fd, SOMAXCONN) < 0) {
+        spdlog::error("Failed to bind/listen on port {}", serverPort);
+        closeSocket(server_fd);
+        server_fd = -1;
+        return;
+    }
+
+    for (int i = 0; i < ioThreadCount; ++i) {
+        auto worker = std::make_unique<Worker>(*this);
+        if (!worker->init()) {
+            spdlog::error("io_uring setup failed (errno {}); io_uring ingest unavailable", errno);
+            workers.clear();
+            closeSocket(server_fd);
+            server_fd = -1;
+            return;
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    isRunning.store(true, std::memory_order_release);
+    acceptConnections();
+    spdlog::info("io_uring TCP Ingest Server started on port {} with {} ring(s)", serverPort, ioThreadCount);
+}
+
+void UringIngestServer::stop() {
+    if (!isRunning.exchange(false, std::memory_order_acq_rel)) return;
+
+    // Workers notice within one tick; closing the listener ends the accepts
+    for (auto& t : workerThreads) {
+        if (t.joinable()) t.join();
+    }
+    workerThreads.clear();
+    workers.clear();
+    if (server_fd != -1) {
+        closeSocket(server_fd);
+        server_fd = -1;
+    }
+    spdlog::info("io_uring TCP Ingest Server stopped.");
+}
+
+void UringIngestServer::acceptConnections() {
+    // No accept thread: each worker arms a multishot accept on its own ring
+    for (auto& worker : workers) {
+        workerThreads.emplace_back(&Worker::run, worker.get());
+    }
+}
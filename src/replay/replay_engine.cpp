@@ -0,0 +1,237 @@
+#include "replay/replay_engine.hpp"
+#include "storage_engine/segmented_log.hpp"
+#include "storage_engine/storage_engine.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+
+using namespace EventStream;
+using QueueId = EventBusMulti::QueueId;
+
+ReplayEngine::ReplayEngine(std::string directory, Dispatcher& dispatcher, EventBusMulti& bus, Options options)
+    : directory_(std::move(directory)), dispatcher_(dispatcher), bus_(bus), options_(std::move(options)) {
+    if (options_.pace == Pace::Scaled && !(options_.speed > 0.0)) {
+        throw std::invalid_argument("ReplayEngine speed must be > 0");
+    }
+    if (options_.readers == 0) options_.readers = 1;
+    if (options_.batch_size == 0) options_.batch_size = 1;
+}
+
+ReplayEngine::~ReplayEngine() {
+    stop();
+}
+
+ReplayEngine::Pace ReplayEngine::parsePace(const std::string& name) {
+    if (name == "max") return Pace::MaxSpeed;
+    if (name == "realtime") return Pace::RealTime;
+    if (name == "scaled") return Pace::Scaled;
+    throw std::invalid_argument("Unknown replay pace: " + name);
+}
+
+void ReplayEngine::start() {
+    planTasks();
+    spdlog::info("Replay of {} [{}, {}] topic '{}': {} task(s) on {} reader(s)",
+                 directory_, options_.from_ts, options_.to_ts, options_.topic, tasks_.size(), options_.readers);
+
+    // Paced replays anchor the first matching record to now
+    if (options_.pace != Pace::MaxSpeed) {
+        // Partitions interleave in time: anchor to the earliest of their first matches
+        base_ts_ = UINT64_MAX;
+        std::vector<bool> anchored(partitions_.size(), false);
+        for (const auto& task : tasks_) {
+            if (anchored[task.partition]) continue;
+            StorageReader reader(partitions_[task.partition], task.begin, task.end);
+            RecordFormat::RecordView view;
+            while (reader.next(view)) {
+                if (matches(view)) {
+                    base_ts_ = std::min(base_ts_, view.timestamp);
+                    anchored[task.partition] = true;
+                    break;
+                }
+            }
+        }
+        if (base_ts_ == UINT64_MAX) base_ts_ = options_.from_ts;
+    }
+    start_ = std::chrono::steady_clock::now();
+
+    size_t count = std::min(options_.readers, std::max<size_t>(1, tasks_.size()));
+    remaining_readers_.store(count, std::memory_order_release);
+    for (size_t i = 0; i < count; ++i) {
+        readers_.emplace_back(&ReplayEngine::readerLoop, this);
+    }
+}
+
+void ReplayEngine::stop() {
+    stopping_.store(true, std::memory_order_release);
+    wait();
+}
+
+void ReplayEngine::wait() {
+    for (auto& reader : readers_) {
+        if (reader.joinable()) reader.join();
+    }
+}
+
+ReplayEngine::Stats ReplayEngine::stats() const {
+    return Stats{replayed_.load(std::memory_order_relaxed),
+                 matched_.load(std::memory_order_relaxed),
+                 scanned_.load(std::memory_order_relaxed)};
+}
+
+void ReplayEngine::planTasks() {
+    tasks_.clear();
+    partitions_ = StorageEngine::partitionDirectories(directory_);
+    for (size_t partition = 0; partition < partitions_.size(); ++partition) planPartition(partition);
+
+    // By time, not by partition: a paced reader that finished one
+    // partition's window first would find every other partition overdue
+    std::sort(tasks_.begin(), tasks_.end(), [](const Task& a, const Task& b) {
+        if (a.first_ts != b.first_ts) return a.first_ts < b.first_ts;
+        if (a.partition != b.partition) return a.partition < b.partition;
+        return a.begin.segment != b.begin.segment ? a.begin.segment < b.begin.segment
+                                                  : a.begin.offset < b.begin.offset;
+    });
+}
+
+void ReplayEngine::planPartition(size_t partition) {
+    const std::string& directory = partitions_[partition];
+    std::vector<uint64_t> segments = SegmentedLog::listSegments(directory);
+    if (segments.empty()) return;
+
+    // Snapshot the end of the log; the live pipeline keeps appending
+    uint64_t last = segments.back();
+    std::error_code ec;
+    uint64_t last_size = std::filesystem::file_size(
+        std::filesystem::path(directory) / SegmentedLog::segmentFileName(last), ec);
+    if (ec) last_size = 0;
+
+    // Sealed segments with a summary contribute only their candidate blocks
+    TimeTopicIndex summaries(directory);
+    for (uint64_t segment : segments) {
+        if (segment == last || !summaries.loadSealed(segment)) {
+            uint64_t end = segment == last ? last_size : UINT64_MAX;
+            // No summary to ask: go by the segment's first record
+            uint64_t first_ts = UINT64_MAX;
+            StorageReader reader(directory, {segment, 0}, {segment, end});
+            RecordFormat::RecordView view;
+            if (reader.next(view)) first_ts = view.timestamp;
+            tasks_.push_back({partition, {segment, 0}, {segment, end}, first_ts});
+        }
+    }
+    std::optional<uint64_t> topic_hash;
+    if (!options_.topic.empty()) topic_hash = RecordFormat::topicHash(options_.topic);
+    std::vector<TimeTopicIndex::Candidate> candidates;
+    summaries.candidates(topic_hash, options_.from_ts, options_.to_ts, candidates);
+    for (const auto& candidate : candidates) {
+        tasks_.push_back({partition, {candidate.segment, candidate.begin}, {candidate.segment, candidate.end},
+                          candidate.min_ts});
+    }
+}
+
+void ReplayEngine::readerLoop() {
+    std::vector<EventPtr> batch;
+    batch.reserve(options_.batch_size);
+    while (!stopping_.load(std::memory_order_acquire)) {
+        size_t index = next_task_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= tasks_.size()) break;
+        runTask(tasks_[index], batch);
+    }
+    flush(batch);
+    if (remaining_readers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        auto stats = this->stats();
+        spdlog::info("Replay of {} finished: {} replayed, {} matched, {} scanned",
+                     directory_, stats.replayed, stats.matched, stats.scanned);
+    }
+}
+
+void ReplayEngine::runTask(const Task& task, std::vector<EventPtr>& batch) {
+    StorageReader reader(partitions_[task.partition], task.begin, task.end);
+    RecordFormat::RecordView view;
+    while (!stopping_.load(std::memory_order_acquire) && reader.next(view)) {
+        scanned_.fetch_add(1, std::memory_order_relaxed);
+        if (!matches(view)) continue;
+        matched_.fetch_add(1, std::memory_order_relaxed);
+
+        if (options_.pace != Pace::MaxSpeed) {
+            auto due = dueTime(view.timestamp);
+            if (due > std::chrono::steady_clock::now()) {
+                // Nothing sits in the batch while we wait for the clock
+                if (!flush(batch)) return;
+                while (!stopping_.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < due) {
+                    std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() +
+                                                                    std::chrono::milliseconds(100)));
+                }
+            }
+        }
+
+        batch.push_back(toEvent(view));
+        if (batch.size() >= options_.batch_size && !flush(batch)) return;
+    }
+}
+
+bool ReplayEngine::matches(const RecordFormat::RecordView& view) const {
+    return view.timestamp >= options_.from_ts && view.timestamp <= options_.to_ts &&
+           (options_.topic.empty() || view.topic == options_.topic);
+}
+
+EventPtr ReplayEngine::toEvent(const RecordFormat::RecordView& view) const {
+    auto event = makeEvent();
+    event->header.sourceType = EventSourceType::INTERNAL;
+    event->header.priority = std::min(view.priority, options_.max_priority);
+    event->header.id = view.id;
+    event->header.timestamp = view.timestamp;
+    event->header.body_len = static_cast<uint32_t>(view.payload.size());
+    event->header.topic_len = static_cast<uint16_t>(view.topic.size());
+    event->header.crc32 = view.crc32;
+    event->header.checksumAlgo = view.checksumAlgo;
+    event->topic = view.topic;
+    event->body.assign(view.payload.begin(), view.payload.end());
+    return event;
+}
+
+std::chrono::steady_clock::time_point ReplayEngine::dueTime(uint64_t timestamp) const {
+    if (timestamp <= base_ts_) return start_;
+    double elapsed_ns = static_cast<double>(timestamp - base_ts_);
+    if (options_.pace == Pace::Scaled) elapsed_ns /= options_.speed;
+    return start_ + std::chrono::nanoseconds(static_cast<int64_t>(elapsed_ns));
+}
+
+bool ReplayEngine::hasLiveHeadroom() {
+    return !dispatcher_.isBackpressured() &&
+           bus_.size(QueueId::REALTIME) <= options_.realtime_backlog_limit &&
+           bus_.size(QueueId::TRANSACTIONAL) <= options_.lane_backlog_limit &&
+           bus_.size(QueueId::BATCH) <= options_.lane_backlog_limit;
+}
+
+bool ReplayEngine::waitForLiveHeadroom() {
+    while (!stopping_.load(std::memory_order_acquire) && dispatcher_.isRunning()) {
+        if (hasLiveHeadroom()) return true;
+        if (dispatcher_.isBackpressured()) {
+            dispatcher_.waitForCapacity(std::chrono::milliseconds(50));
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return false;
+}
+
+bool ReplayEngine::flush(std::vector<EventPtr>& batch) {
+    size_t pushed = 0;
+    while (pushed < batch.size()) {
+        if (!waitForLiveHeadroom()) break;
+        // Small slices so a filling lane is noticed between them
+        size_t slice = std::min<size_t>(batch.size() - pushed, 64);
+        pushed += dispatcher_.pushBatchWithBackpressure(
+            std::span<EventPtr>(batch).subspan(pushed, slice), std::chrono::milliseconds(100));
+    }
+    replayed_.fetch_add(pushed, std::memory_order_relaxed);
+    bool complete = pushed == batch.size();
+    if (!complete && !stopping_.load(std::memory_order_acquire)) {
+        spdlog::warn("Replay dropping {} events: dispatcher stopped", batch.size() - pushed);
+        stopping_.store(true, std::memory_order_release);
+    }
+    batch.clear();
+    return complete;
+}
@@ -0,0 +1,146 @@
+#include "storage_engine/block_codec.hpp"
+#include <cstring>
+
+namespace BlockCodec {
+
+    namespace {
+
+        constexpr size_t kMinMatch = 4;
+        constexpr size_t kMaxOffset = 65535;
+        constexpr unsigned kHashBits = 14;
+        // Trailing bytes always sent as literals, so match search never reads past the end
+        constexpr size_t kTailLiterals = 5;
+        constexpr size_t kMinInput = 12;
+
+        uint32_t read32(const uint8_t* p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - kHashBits);
+        }
+
+        void putLength(std::vector<uint8_t>& out, size_t length) {
+            while (length >= 255) {
+                out.push_back(255);
+                length -= 255;
+            }
+            out.push_back(static_cast<uint8_t>(length));
+        }
+
+        void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literal_count,
+                         size_t offset, size_t match_length) {
+            size_t match_code = match_length ? match_length - kMinMatch : 0;
+            uint8_t token = static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4 |
+                                                 (match_code < 15 ? match_code : 15));
+            out.push_back(token);
+            if (literal_count >= 15) putLength(out, literal_count - 15);
+            out.insert(out.end(), literals, literals + literal_count);
+            if (match_length == 0) return;
+            out.push_back(static_cast<uint8_t>(offset));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (match_code >= 15) putLength(out, match_code - 15);
+        }
+
+        bool getLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+            uint8_t byte;
+            do {
+                if (ip == end) return false;
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+    } // namespace
+
+    size_t maxCompressedSize(size_t n) {
+        return n + n / 255 + 16;
+    }
+
+    size_t compress(std::span<const uint8_t> in, std::vector<uint8_t>& out) {
+        size_t start = out.size();
+        out.reserve(start + maxCompressedSize(in.size()));
+        const uint8_t* base = in.data();
+        size_t n = in.size();
+        size_t anchor = 0;
+
+        if (n >= kMinInput) {
+            thread_local std::vector<uint32_t> table;
+            table.assign(size_t{1} << kHashBits, 0);
+            size_t match_limit = n - kTailLiterals;
+            size_t ip = 0;
+            while (ip + kMinMatch <= match_limit) {
+                uint32_t sequence = read32(base + ip);
+                uint32_t& slot = table[hash(sequence)];
+                size_t candidate = slot;
+                slot = static_cast<uint32_t>(ip);
+                if (candidate >= ip || ip - candidate > kMaxOffset || read32(base + candidate) != sequence) {
+                    // Skip faster through data that does not compress
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+                size_t length = kMinMatch;
+                while (ip + length < match_limit && base[candidate + length] == base[ip + length]) ++length;
+                putSequence(out, base + anchor, ip - anchor, ip - candidate, length);
+                ip += length;
+                anchor = ip;
+                if (ip >= 2 && ip + kMinMatch <= match_limit) {
+                    table[hash(read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2);
+                }
+            }
+        }
+        putSequence(out, base + anchor, n - anchor, 0, 0);
+        return out.size() - start;
+    }
+
+    bool decompress(std::span<const uint8_t> in, std::span<uint8_t> out) {
+        const uint8_t* ip = in.data();
+        const uint8_t* end = ip + in.size();
+        uint8_t* op = out.data();
+        uint8_t* out_end = op + out.size();
+
+        while (ip < end) {
+            uint8_t token = *ip++;
+            size_t literals = token >> 4;
+            if (literals == 15 && !getLength(ip, end, literals)) return false;
+            if (static_cast<size_t>(end - ip) < literals || static_cast<size_t>(out_end - op) < literals) return false;
+            // Short runs (the common case) copy a fixed 16 bytes when both sides have room
+            if (literals <= 16 && end - ip >= 16 && out_end - op >= 16) {
+                std::memcpy(op, ip, 16);
+            } else {
+                std::memcpy(op, ip, literals);
+            }
+            ip += literals;
+            op += literals;
+            if (ip == end) break;   // last sequence
+
+            if (end - ip < 2) return false;
+            size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+            ip += 2;
+            size_t length = token & 15;
+            if (length == 15 && !getLength(ip, end, length)) return false;
+            length += kMinMatch;
+            if (offset == 0 || offset > static_cast<size_t>(op - out.data()) ||
+                static_cast<size_t>(out_end - op) < length) {
+                return false;
+            }
+            const uint8_t* match = op - offset;
+            if (offset >= 8 && static_cast<size_t>(out_end - op) >= length + 8) {
+                // 8-byte steps never read bytes this copy has yet to write
+                for (size_t i = 0; i < length; i += 8) std::memcpy(op + i, match + i, 8);
+                op += length;
+            } else if (offset >= length) {
+                std::memcpy(op, match, length);
+                op += length;
+            } else {
+                // Overlapping copy repeats the last offset bytes
+                for (size_t i = 0; i < length; ++i) *op++ = match[i];
+            }
+        }
+        return op == out_end;
+    }
+
+} // namespace BlockCodec
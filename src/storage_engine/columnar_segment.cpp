@@ -0,0 +1,458 @@
+#include "storage_engine/columnar_segment.hpp"
+#include "storage_engine/block_codec.hpp"
+#include "event/Checksum.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+enum class PayloadCodec : uint8_t {
+    Raw = 0,
+    Lz = 1,
+};
+
+// [u32 records][u32 meta bytes][u32 payload bytes][u32 stored payload bytes][u8 codec]
+constexpr size_t kBlockHeaderSize = 17;
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(uint64_t delta) {
+    auto value = static_cast<int64_t>(delta);
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    bool synced = ::fsync(fd) == 0;
+    return ::close(fd) == 0 && synced;
+}
+
+// Builds one block from the records of rows[begin, end)
+class BlockWriter {
+public:
+    void add(const RecordFormat::RecordView& view, uint32_t topic) {
+        records_.push_back({view, topic});
+    }
+
+    bool empty() const { return records_.empty(); }
+
+    ColumnarSegment::Block finish(uint64_t logical_begin, uint64_t logical_end, std::vector<uint8_t>& file) {
+        meta_.clear();
+        payloads_.clear();
+        size_t n = records_.size();
+
+        uint64_t previous_ts = 0;
+        uint64_t previous_delta = 0;
+        uint64_t min_ts = UINT64_MAX;
+        uint64_t max_ts = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t ts = records_[i].view.timestamp;
+            min_ts = std::min(min_ts, ts);
+            max_ts = std::max(max_ts, ts);
+            if (i == 0) {
+                putVarint(meta_, ts);
+            } else {
+                uint64_t delta = ts - previous_ts;
+                putVarint(meta_, zigzag(delta - previous_delta));
+                previous_delta = delta;
+            }
+            previous_ts = ts;
+        }
+        uint64_t previous_id = 0;
+        for (const auto& record : records_) {
+            putVarint(meta_, zigzag(record.view.id - previous_id));
+            previous_id = record.view.id;
+        }
+        for (const auto& record : records_) putVarint(meta_, record.topic);
+        for (const auto& record : records_) meta_.push_back(static_cast<uint8_t>(record.view.sourceType));
+        for (const auto& record : records_) meta_.push_back(static_cast<uint8_t>(record.view.priority));
+        for (const auto& record : records_) meta_.push_back(static_cast<uint8_t>(record.view.checksumAlgo));
+        for (const auto& record : records_) put<uint32_t>(meta_, record.view.crc32);
+        for (const auto& record : records_) {
+            putVarint(meta_, record.view.payload.size());
+            payloads_.insert(payloads_.end(), record.view.payload.begin(), record.view.payload.end());
+        }
+
+        compressed_.clear();
+        BlockCodec::compress(payloads_, compressed_);
+        bool lz = compressed_.size() < payloads_.size();
+        const std::vector<uint8_t>& stored = lz ? compressed_ : payloads_;
+
+        ColumnarSegment::Block block{};
+        block.logical_begin = logical_begin;
+        block.logical_end = logical_end;
+        block.file_offset = file.size();
+        block.min_ts = min_ts;
+        block.max_ts = max_ts;
+        block.records = static_cast<uint32_t>(n);
+
+        put<uint32_t>(file, static_cast<uint32_t>(n));
+        put<uint32_t>(file, static_cast<uint32_t>(meta_.size()));
+        put<uint32_t>(file, static_cast<uint32_t>(payloads_.size()));
+        put<uint32_t>(file, static_cast<uint32_t>(stored.size()));
+        file.push_back(static_cast<uint8_t>(lz ? PayloadCodec::Lz : PayloadCodec::Raw));
+        file.insert(file.end(), meta_.begin(), meta_.end());
+        file.insert(file.end(), stored.begin(), stored.end());
+        block.file_size = static_cast<uint32_t>(file.size() - block.file_offset);
+        block.crc = EventStream::Checksum::crc32c({file.data() + block.file_offset, block.file_size});
+
+        records_.clear();
+        return block;
+    }
+
+    // A block of no records holding rows[begin, begin + frames.size()) as is
+    static ColumnarSegment::Block finishVerbatim(uint64_t logical_begin, std::span<const uint8_t> frames,
+                                                 std::vector<uint8_t>& file) {
+        ColumnarSegment::Block block{};
+        block.logical_begin = logical_begin;
+        block.logical_end = logical_begin + frames.size();
+        block.file_offset = file.size();
+        block.min_ts = UINT64_MAX;
+        block.max_ts = 0;
+        block.records = 0;
+
+        put<uint32_t>(file, 0);
+        put<uint32_t>(file, 0);
+        put<uint32_t>(file, static_cast<uint32_t>(frames.size()));
+        put<uint32_t>(file, static_cast<uint32_t>(frames.size()));
+        file.push_back(static_cast<uint8_t>(PayloadCodec::Raw));
+        file.insert(file.end(), frames.begin(), frames.end());
+        block.file_size = static_cast<uint32_t>(file.size() - block.file_offset);
+        block.crc = EventStream::Checksum::crc32c({file.data() + block.file_offset, block.file_size});
+        return block;
+    }
+
+private:
+    struct Pending {
+        RecordFormat::RecordView view;
+        uint32_t topic;
+    };
+
+    std::vector<Pending> records_;
+    std::vector<uint8_t> meta_;
+    std::vector<uint8_t> payloads_;
+    std::vector<uint8_t> compressed_;
+};
+
+} // namespace
+
+ColumnarSegment::~ColumnarSegment() {
+    if (map_) ::munmap(const_cast<uint8_t*>(map_), map_bytes_);
+}
+
+std::string ColumnarSegment::fileName(uint64_t segment) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06llu.col", static_cast<unsigned long long>(segment));
+    return name;
+}
+
+uint64_t ColumnarSegment::write(const std::string& path, std::span<const uint8_t> rows, size_t block_bytes) {
+    std::vector<uint8_t> file(sizeof(FileHeader));
+    std::vector<Block> blocks;
+    std::unordered_map<std::string_view, uint32_t> topic_ids;
+    std::vector<std::string_view> topics;
+    BlockWriter writer;
+
+    uint64_t offset = 0;
+    uint64_t block_begin = 0;
+    uint64_t records = 0;
+    size_t corrupt = 0;
+    while (offset < rows.size()) {
+        std::span<const uint8_t> rest = rows.subspan(offset);
+        size_t used = RecordFormat::validate(rest);
+        if (used == 0) {
+            // Skipped as scanSegment skips it, but kept byte for byte so the
+            // offsets after it stay valid and its CRC still fails
+            size_t framed = RecordFormat::requiredSize(rest);
+            if (framed <= RecordFormat::kFrameSize || framed > rest.size()) break;   // torn tail
+            if (!writer.empty()) blocks.push_back(writer.finish(block_begin, offset, file));
+            blocks.push_back(BlockWriter::finishVerbatim(offset, rest.first(framed), file));
+            offset += framed;
+            block_begin = offset;
+            ++corrupt;
+            continue;
+        }
+        RecordFormat::RecordView view;
+        RecordFormat::decodeView(rest, view);
+        auto [it, inserted] = topic_ids.emplace(view.topic, static_cast<uint32_t>(topics.size()));
+        if (inserted) topics.push_back(view.topic);
+        writer.add(view, it->second);
+        offset += used;
+        ++records;
+        if (offset - block_begin >= block_bytes) {
+            blocks.push_back(writer.finish(block_begin, offset, file));
+            block_begin = offset;
+        }
+    }
+    if (!writer.empty()) blocks.push_back(writer.finish(block_begin, offset, file));
+    if (corrupt > 0) spdlog::warn("Keeping {} corrupt record(s) of {} as they are", corrupt, path);
+
+    FileHeader header{kMagic, kVersion, offset, records, static_cast<uint32_t>(blocks.size()),
+                      static_cast<uint32_t>(topics.size()), file.size(), 0};
+    for (std::string_view topic : topics) {
+        put<uint32_t>(file, static_cast<uint32_t>(topic.size()));
+        file.insert(file.end(), topic.begin(), topic.end());
+    }
+    file.resize((file.size() + alignof(Block) - 1) / alignof(Block) * alignof(Block));
+    header.directory_offset = file.size();
+    const auto* directory = reinterpret_cast<const uint8_t*>(blocks.data());
+    file.insert(file.end(), directory, directory + blocks.size() * sizeof(Block));
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    // Synced before the rename: the caller deletes the row segment next
+    std::string tmp = path + ".tmp";
+    if (!writeFile(tmp, file)) {
+        spdlog::error("Failed to write {}: {}", tmp, std::strerror(errno));
+        fs::remove(tmp);
+        return 0;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        spdlog::error("Failed to rename {}: {}", tmp, ec.message());
+        fs::remove(tmp);
+        return 0;
+    }
+    return offset;
+}
+
+std::shared_ptr<const ColumnarSegment> ColumnarSegment::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        spdlog::error("mmap of {} failed: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    std::shared_ptr<ColumnarSegment> segment(new ColumnarSegment());
+    segment->map_ = static_cast<const uint8_t*>(map);
+    segment->map_bytes_ = bytes;
+
+    FileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion || header.directory_offset % alignof(Block) != 0 ||
+        header.directory_offset > bytes || bytes - header.directory_offset != header.blocks * sizeof(Block) ||
+        header.dictionary_offset > header.directory_offset) {
+        spdlog::error("Ignoring malformed compacted segment {}", path);
+        return nullptr;
+    }
+    segment->logical_size_ = header.logical_size;
+    segment->records_ = header.records;
+    segment->blocks_ = {reinterpret_cast<const Block*>(segment->map_ + header.directory_offset), header.blocks};
+
+    const uint8_t* p = segment->map_ + header.dictionary_offset;
+    const uint8_t* end = segment->map_ + header.directory_offset;
+    segment->topics_.reserve(header.topics);
+    for (uint32_t i = 0; i < header.topics; ++i) {
+        if (end - p < 4 || static_cast<size_t>(end - p - 4) < get<uint32_t>(p)) {
+            spdlog::error("Ignoring compacted segment {} with a truncated topic dictionary", path);
+            return nullptr;
+        }
+        uint32_t length = get<uint32_t>(p);
+        segment->topics_.emplace_back(reinterpret_cast<const char*>(p + 4), length);
+        p += 4 + length;
+    }
+    return segment;
+}
+
+size_t ColumnarSegment::blockAt(uint64_t offset) const {
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), offset,
+                               [](uint64_t value, const Block& block) { return value < block.logical_end; });
+    if (it == blocks_.end() || offset < it->logical_begin) return blocks_.size();
+    return static_cast<size_t>(it - blocks_.begin());
+}
+
+bool ColumnarSegment::decodeBlock(size_t block, std::vector<uint8_t>& rows) const {
+    rows.clear();
+    return appendBlock(block, rows);
+}
+
+bool ColumnarSegment::read(uint64_t begin, uint64_t end, std::vector<uint8_t>& rows) const {
+    rows.clear();
+    if (begin >= end) return true;
+    size_t first = blockAt(begin);
+    if (first == blocks_.size()) return false;
+    uint64_t skip = begin - blocks_[first].logical_begin;
+    for (size_t block = first; block < blocks_.size() && blocks_[block].logical_begin < end; ++block) {
+        if (!appendBlock(block, rows)) return false;
+    }
+    // Trim to the requested range
+    uint64_t decoded_end = blocks_[first].logical_begin + rows.size();
+    if (decoded_end > end) rows.resize(rows.size() - (decoded_end - end));
+    rows.erase(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(skip));
+    return true;
+}
+
+bool ColumnarSegment::appendBlock(size_t index, std::vector<uint8_t>& rows) const {
+    if (index >= blocks_.size()) return false;
+    const Block& block = blocks_[index];
+    if (block.file_offset + block.file_size > map_bytes_ || block.file_size < kBlockHeaderSize ||
+        EventStream::Checksum::crc32c({map_ + block.file_offset, block.file_size}) != block.crc) {
+        spdlog::error("Compacted block {} at offset {} is corrupt", index, block.file_offset);
+        return false;
+    }
+
+    const uint8_t* p = map_ + block.file_offset;
+    const uint8_t* block_end = p + block.file_size;
+    uint32_t n = get<uint32_t>(p);
+    uint32_t meta_bytes = get<uint32_t>(p + 4);
+    uint32_t payload_bytes = get<uint32_t>(p + 8);
+    uint32_t stored_bytes = get<uint32_t>(p + 12);
+    auto codec = static_cast<PayloadCodec>(p[16]);
+    p += kBlockHeaderSize;
+    if (static_cast<uint64_t>(meta_bytes) + stored_bytes != static_cast<uint64_t>(block_end - p)) return false;
+    const uint8_t* meta_end = p + meta_bytes;
+    const uint8_t* stored = meta_end;
+    if (n == 0) {
+        // Frames that failed their CRC on compaction, left for the reader to reject
+        if (codec != PayloadCodec::Raw || meta_bytes != 0 || stored_bytes != payload_bytes ||
+            stored_bytes != block.logical_end - block.logical_begin) {
+            return false;
+        }
+        rows.insert(rows.end(), stored, stored + stored_bytes);
+        return true;
+    }
+
+    // Payloads first: records are rebuilt straight from this buffer
+    thread_local std::vector<uint8_t> payloads;
+    const uint8_t* payload = stored;
+    if (codec == PayloadCodec::Lz) {
+        payloads.resize(payload_bytes);
+        if (!BlockCodec::decompress({stored, stored_bytes}, payloads)) return false;
+        payload = payloads.data();
+    } else if (codec != PayloadCodec::Raw || stored_bytes != payload_bytes) {
+        return false;
+    }
+
+    thread_local std::vector<uint64_t> timestamps, ids, topics, sizes;
+    timestamps.resize(n);
+    ids.resize(n);
+    topics.resize(n);
+    sizes.resize(n);
+    uint64_t value = 0;
+    uint64_t delta = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!getVarint(p, meta_end, value)) return false;
+        if (i == 0) {
+            timestamps[i] = value;
+        } else {
+            delta += unzigzag(value);
+            timestamps[i] = timestamps[i - 1] + delta;
+        }
+    }
+    uint64_t id = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!getVarint(p, meta_end, value)) return false;
+        id += unzigzag(value);
+        ids[i] = id;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!getVarint(p, meta_end, topics[i]) || topics[i] >= topics_.size()) return false;
+    }
+    if (static_cast<size_t>(meta_end - p) < size_t{n} * 7) return false;
+    const uint8_t* sources = p;
+    const uint8_t* priorities = sources + n;
+    const uint8_t* algorithms = priorities + n;
+    const uint8_t* crcs = algorithms + n;
+    p = crcs + size_t{n} * 4;
+    uint64_t payload_total = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!getVarint(p, meta_end, sizes[i])) return false;
+        payload_total += sizes[i];
+    }
+    if (payload_total != payload_bytes) return false;
+
+    size_t start = rows.size();
+    rows.resize(start + (block.logical_end - block.logical_begin));
+    uint8_t* out = rows.data() + start;
+    uint8_t* out_end = rows.data() + rows.size();
+    for (uint32_t i = 0; i < n; ++i) {
+        std::string_view topic = topics_[topics[i]];
+        size_t body = RecordFormat::kFixedHeaderSize + topic.size() + 8 + sizes[i];
+        if (static_cast<size_t>(out_end - out) < RecordFormat::kFrameSize + body) return false;
+        uint8_t* frame = out;
+        out += RecordFormat::kFrameSize;
+        std::memcpy(out, &timestamps[i], 8);
+        out[8] = sources[i];
+        out[9] = priorities[i];
+        out[10] = algorithms[i];
+        std::memcpy(out + 11, &ids[i], 8);
+        std::memcpy(out + 19, crcs + size_t{i} * 4, 4);
+        auto topic_len = static_cast<uint32_t>(topic.size());
+        std::memcpy(out + 23, &topic_len, 4);
+        out += RecordFormat::kFixedHeaderSize;
+        std::memcpy(out, topic.data(), topic.size());
+        out += topic.size();
+        std::memcpy(out, &sizes[i], 8);
+        out += 8;
+        std::memcpy(out, payload, sizes[i]);
+        out += sizes[i];
+        payload += sizes[i];
+        RecordFormat::sealFrame(frame, body);
+    }
+    return out == out_end;
+}
@@ -0,0 +1,258 @@
+#include "storage_engine/offset_index.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool byId(const OffsetIndex::Entry& a, const OffsetIndex::Entry& b) {
+    return a.id < b.id;
+}
+
+} // namespace
+
+OffsetIndex::OffsetIndex(std::string directory) : directory_(std::move(directory)) {
+}
+
+OffsetIndex::~OffsetIndex() {
+    for (auto& sealed : sealed_) ::munmap(sealed.map, sealed.map_bytes);
+}
+
+std::string OffsetIndex::indexFileName(uint64_t segment) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06llu.idx", static_cast<unsigned long long>(segment));
+    return name;
+}
+
+std::string OffsetIndex::pathFor(uint64_t segment, const char* suffix) const {
+    return (fs::path(directory_) / (indexFileName(segment) + suffix)).string();
+}
+
+bool OffsetIndex::loadSealed(uint64_t segment) {
+    std::optional<SealedSegment> sealed = mapIndexFile(segment);
+    if (!sealed) return false;
+    std::unique_lock lock(mutex_);
+    insertSealed(*sealed);
+    return true;
+}
+
+void OffsetIndex::buildSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    std::vector<Entry> entries;
+    entries.reserve(records.size());
+    for (const auto& record : records) entries.push_back({record.id, record.offset});
+    SealedSegment sealed = persist(segment, entries);
+    std::unique_lock lock(mutex_);
+    insertSealed(sealed);
+}
+
+void OffsetIndex::dropSealed(uint64_t segment) {
+    std::optional<SealedSegment> removed;
+    {
+        std::unique_lock lock(mutex_);
+        removed = removeSealed(segment);
+    }
+    if (removed) ::munmap(removed->map, removed->map_bytes);
+    std::error_code ec;
+    fs::remove(pathFor(segment, ""), ec);
+}
+
+void OffsetIndex::replaceSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    std::vector<Entry> entries;
+    entries.reserve(records.size());
+    for (const auto& record : records) entries.push_back({record.id, record.offset});
+    // The old mapping stays valid after the rename, so lookups see either version whole
+    SealedSegment sealed = persist(segment, entries);
+    std::optional<SealedSegment> removed;
+    {
+        std::unique_lock lock(mutex_);
+        removed = removeSealed(segment);
+        insertSealed(sealed);
+    }
+    if (removed) ::munmap(removed->map, removed->map_bytes);
+}
+
+void OffsetIndex::discardFile(uint64_t segment) {
+    std::error_code ec;
+    fs::remove(pathFor(segment, ""), ec);
+}
+
+OffsetIndex::SealedSegment OffsetIndex::persist(uint64_t segment, std::vector<Entry>& entries) const {
+    std::optional<SealedSegment> sealed;
+    if (writeIndexFile(segment, entries)) sealed = mapIndexFile(segment);
+    if (!sealed) sealed = anonymousCopy(segment, entries);
+    return *sealed;
+}
+
+void OffsetIndex::loadActive(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    std::unique_lock lock(mutex_);
+    active_segment_ = segment;
+    active_.clear();
+    for (const auto& record : records) active_[record.id] = record.offset;
+}
+
+void OffsetIndex::add(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    std::unique_lock lock(mutex_);
+    active_segment_ = segment;
+    for (const auto& record : records) active_[record.id] = record.offset;
+}
+
+void OffsetIndex::seal(uint64_t segment) {
+    std::vector<Entry> entries;
+    {
+        std::shared_lock lock(mutex_);
+        entries.reserve(active_.size());
+        for (const auto& [id, offset] : active_) entries.push_back({id, offset});
+    }
+    // The in-memory entries keep serving lookups until the mapping replaces them
+    std::optional<SealedSegment> sealed;
+    if (writeIndexFile(segment, entries)) sealed = mapIndexFile(segment);
+    if (!sealed) {
+        spdlog::error("Failed to persist index for segment {} in {}; it will be rebuilt on restart",
+                      segment, directory_);
+        sealed = anonymousCopy(segment, entries);
+    }
+    std::unique_lock lock(mutex_);
+    insertSealed(*sealed);
+    active_.clear();
+    active_segment_ = segment + 1;
+}
+
+bool OffsetIndex::writeIndexFile(uint64_t segment, std::vector<Entry>& entries) const {
+    // Later duplicates of an id replace earlier ones, as in the active map
+    std::stable_sort(entries.begin(), entries.end(), byId);
+    auto last = std::unique(entries.rbegin(), entries.rend(),
+                            [](const Entry& a, const Entry& b) { return a.id == b.id; });
+    entries.erase(entries.begin(), last.base());
+
+    FileHeader header{kMagic, kVersion, entries.size(),
+                      entries.empty() ? 0 : entries.front().id,
+                      entries.empty() ? 0 : entries.back().id};
+
+    // Write to a temporary name and rename, so a crash never leaves a torn index
+    std::string tmp = pathFor(segment, ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()),
+                  static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+        if (!out) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, pathFor(segment, ""), ec);
+    return !ec;
+}
+
+std::optional<OffsetIndex::SealedSegment> OffsetIndex::mapIndexFile(uint64_t segment) const {
+    std::string path = pathFor(segment, "");
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        return std::nullopt;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        spdlog::error("mmap of {} failed: {}", path, std::strerror(errno));
+        return std::nullopt;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion ||
+        bytes != sizeof(FileHeader) + header.count * sizeof(Entry)) {
+        spdlog::warn("Ignoring malformed index file {}", path);
+        ::munmap(map, bytes);
+        return std::nullopt;
+    }
+    // Lookups fault in only the pages a binary search touches
+    ::madvise(map, bytes, MADV_RANDOM);
+
+    return SealedSegment{segment,
+                         reinterpret_cast<const Entry*>(static_cast<const uint8_t*>(map) + sizeof(FileHeader)),
+                         header.count, header.min_id, header.max_id, map, bytes};
+}
+
+OffsetIndex::SealedSegment OffsetIndex::anonymousCopy(uint64_t segment, const std::vector<Entry>& entries) {
+    // Keeps a segment searchable when its index file cannot be written
+    size_t bytes = std::max<size_t>(1, entries.size() * sizeof(Entry));
+    void* map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) throw std::bad_alloc();
+    std::memcpy(map, entries.data(), entries.size() * sizeof(Entry));
+    return SealedSegment{segment, static_cast<const Entry*>(map), entries.size(),
+                         entries.empty() ? 0 : entries.front().id,
+                         entries.empty() ? 0 : entries.back().id, map, bytes};
+}
+
+void OffsetIndex::insertSealed(const SealedSegment& sealed) {
+    auto at = std::lower_bound(sealed_.begin(), sealed_.end(), sealed.segment,
+                               [](const SealedSegment& s, uint64_t seg) { return s.segment < seg; });
+    sealed_.insert(at, sealed);
+}
+
+std::optional<OffsetIndex::SealedSegment> OffsetIndex::removeSealed(uint64_t segment) {
+    auto at = std::lower_bound(sealed_.begin(), sealed_.end(), segment,
+                               [](const SealedSegment& s, uint64_t seg) { return s.segment < seg; });
+    if (at == sealed_.end() || at->segment != segment) return std::nullopt;
+    SealedSegment removed = *at;
+    sealed_.erase(at);
+    return removed;
+}
+
+std::optional<OffsetIndex::Location> OffsetIndex::find(uint64_t id) const {
+    std::shared_lock lock(mutex_);
+    if (auto it = active_.find(id); it != active_.end()) {
+        return Location{active_segment_, it->second};
+    }
+    for (auto s = sealed_.rbegin(); s != sealed_.rend(); ++s) {
+        if (s->count == 0 || id < s->min_id || id > s->max_id) continue;
+        const Entry* end = s->entries + s->count;
+        const Entry* it = std::lower_bound(s->entries, end, Entry{id, 0}, byId);
+        if (it != end && it->id == id) return Location{s->segment, it->offset};
+    }
+    return std::nullopt;
+}
+
+void OffsetIndex::findRange(uint64_t first, uint64_t last, std::vector<Location>& out) const {
+    if (first > last) return;
+    std::vector<std::pair<uint64_t, Location>> found;
+    {
+        std::shared_lock lock(mutex_);
+        for (const auto& s : sealed_) {
+            if (s.count == 0 || last < s.min_id || first > s.max_id) continue;
+            const Entry* end = s.entries + s.count;
+            for (const Entry* it = std::lower_bound(s.entries, end, Entry{first, 0}, byId);
+                 it != end && it->id <= last; ++it) {
+                found.push_back({it->id, {s.segment, it->offset}});
+            }
+        }
+        for (auto it = active_.lower_bound(first); it != active_.end() && it->first <= last; ++it) {
+            found.push_back({it->first, {active_segment_, it->second}});
+        }
+    }
+    // Per-segment runs are already sorted; merge them by id
+    std::stable_sort(found.begin(), found.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    out.reserve(out.size() + found.size());
+    for (const auto& [id, location] : found) out.push_back(location);
+}
+
+size_t OffsetIndex::size() const {
+    std::shared_lock lock(mutex_);
+    size_t total = active_.size();
+    for (const auto& s : sealed_) total += s.count;
+    return total;
+}
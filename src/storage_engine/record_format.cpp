@@ -0,0 +1,153 @@
+#include "storage_engine/record_format.hpp"
+#include "event/Checksum.hpp"
+#include <cstring>
+
+namespace RecordFormat {
+
+    namespace {
+
+        template <typename T>
+        void put(std::vector<uint8_t>& out, T value) {
+            size_t at = out.size();
+            out.resize(at + sizeof(T));
+            std::memcpy(out.data() + at, &value, sizeof(T));
+        }
+
+        template <typename T>
+        T get(const uint8_t* p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        // Total size of the framed record at the front of data; 0 unless it is
+        // all there and its body holds exactly the fields it announces
+        size_t bodyOf(std::span<const uint8_t> data, const uint8_t*& body, uint32_t& topicLen,
+                      uint64_t& payloadSize) {
+            if (data.size() < kFrameSize) return 0;
+            uint32_t length = get<uint32_t>(data.data());
+            if (length < kFixedHeaderSize + 8 || data.size() - kFrameSize < length) return 0;
+            body = data.data() + kFrameSize;
+            topicLen = get<uint32_t>(body + 23);
+            if (topicLen > length - kFixedHeaderSize - 8) return 0;
+            payloadSize = get<uint64_t>(body + kFixedHeaderSize + topicLen);
+            if (payloadSize != length - kFixedHeaderSize - 8 - topicLen) return 0;
+            return kFrameSize + length;
+        }
+
+    } // namespace
+
+    size_t encodedSize(const EventStream::Event& event) {
+        return kFrameSize + kFixedHeaderSize + event.topic.size() + 8 + event.body.size();
+    }
+
+    void sealFrame(uint8_t* frame, size_t body_size) {
+        auto length = static_cast<uint32_t>(body_size);
+        uint32_t crc = EventStream::Checksum::crc32c(std::span<const uint8_t>(frame + kFrameSize, body_size));
+        std::memcpy(frame, &length, 4);
+        std::memcpy(frame + 4, &crc, 4);
+    }
+
+    void encode(const EventStream::Event& event, std::vector<uint8_t>& out) {
+        out.reserve(out.size() + encodedSize(event));
+        size_t frame = out.size();
+        out.resize(frame + kFrameSize);
+        put<uint64_t>(out, event.header.timestamp);
+        put<uint8_t>(out, static_cast<uint8_t>(event.header.sourceType));
+        put<uint8_t>(out, static_cast<uint8_t>(event.header.priority));
+        put<uint8_t>(out, static_cast<uint8_t>(event.header.checksumAlgo));
+        put<uint64_t>(out, event.header.id);
+        put<uint32_t>(out, event.header.crc32);
+        std::string_view topic = event.topic.name();
+        put<uint32_t>(out, static_cast<uint32_t>(topic.size()));
+        out.insert(out.end(), topic.begin(), topic.end());
+        put<uint64_t>(out, event.body.size());
+        out.insert(out.end(), event.body.begin(), event.body.end());
+        sealFrame(out.data() + frame, out.size() - frame - kFrameSize);
+    }
+
+    void encode(const RecordView& view, std::vector<uint8_t>& out) {
+        out.reserve(out.size() + kFrameSize + kFixedHeaderSize + view.topic.size() + 8 + view.payload.size());
+        size_t frame = out.size();
+        out.resize(frame + kFrameSize);
+        put<uint64_t>(out, view.timestamp);
+        put<uint8_t>(out, static_cast<uint8_t>(view.sourceType));
+        put<uint8_t>(out, static_cast<uint8_t>(view.priority));
+        put<uint8_t>(out, static_cast<uint8_t>(view.checksumAlgo));
+        put<uint64_t>(out, view.id);
+        put<uint32_t>(out, view.crc32);
+        put<uint32_t>(out, static_cast<uint32_t>(view.topic.size()));
+        out.insert(out.end(), view.topic.begin(), view.topic.end());
+        put<uint64_t>(out, view.payload.size());
+        out.insert(out.end(), view.payload.begin(), view.payload.end());
+        sealFrame(out.data() + frame, out.size() - frame - kFrameSize);
+    }
+
+    size_t peek(std::span<const uint8_t> data, RecordKey& key) {
+        const uint8_t* body;
+        uint32_t topicLen;
+        uint64_t payloadSize;
+        size_t total = bodyOf(data, body, topicLen, payloadSize);
+        if (total == 0) return 0;
+        key.id = get<uint64_t>(body + 11);
+        key.timestamp = get<uint64_t>(body);
+        key.topic = std::string_view(reinterpret_cast<const char*>(body + kFixedHeaderSize), topicLen);
+        return total;
+    }
+
+    uint64_t topicHash(std::string_view topic) {
+        return EventStream::TopicRegistry::stableHash(topic);
+    }
+
+    size_t requiredSize(std::span<const uint8_t> prefix) {
+        if (prefix.size() < kFrameSize) return kFrameSize;
+        return kFrameSize + get<uint32_t>(prefix.data());
+    }
+
+    size_t validate(std::span<const uint8_t> data) {
+        const uint8_t* body;
+        uint32_t topicLen;
+        uint64_t payloadSize;
+        size_t total = bodyOf(data, body, topicLen, payloadSize);
+        if (total == 0) return 0;
+        uint32_t crc = EventStream::Checksum::crc32c(std::span<const uint8_t>(body, total - kFrameSize));
+        return crc == get<uint32_t>(data.data() + 4) ? total : 0;
+    }
+
+    size_t decodeView(std::span<const uint8_t> data, RecordView& view) {
+        const uint8_t* p;
+        uint32_t topicLen;
+        uint64_t payloadSize;
+        size_t total = bodyOf(data, p, topicLen, payloadSize);
+        if (total == 0) return 0;
+
+        view.timestamp = get<uint64_t>(p);
+        view.sourceType = static_cast<EventStream::EventSourceType>(p[8]);
+        view.priority = static_cast<EventStream::EventPriority>(p[9]);
+        view.checksumAlgo = static_cast<EventStream::ChecksumAlgorithm>(p[10]);
+        view.id = get<uint64_t>(p + 11);
+        view.crc32 = get<uint32_t>(p + 19);
+        view.topic = std::string_view(reinterpret_cast<const char*>(p + kFixedHeaderSize), topicLen);
+        view.payload = std::span<const uint8_t>(p + kFixedHeaderSize + topicLen + 8, payloadSize);
+        return total;
+    }
+
+    size_t decode(std::span<const uint8_t> data, EventStream::Event& event) {
+        RecordView view;
+        size_t total = decodeView(data, view);
+        if (total == 0) return 0;
+
+        event.header.timestamp = view.timestamp;
+        event.header.sourceType = view.sourceType;
+        event.header.priority = view.priority;
+        event.header.checksumAlgo = view.checksumAlgo;
+        event.header.id = view.id;
+        event.header.crc32 = view.crc32;
+        event.header.topic_len = static_cast<uint16_t>(view.topic.size());
+        event.header.body_len = static_cast<uint32_t>(view.payload.size());
+        event.topic = view.topic;
+        event.body.assign(view.payload.begin(), view.payload.end());
+        return total;
+    }
+
+} // namespace RecordFormat
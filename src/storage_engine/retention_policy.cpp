@@ -0,0 +1,44 @@
+#include "storage_engine/retention_policy.hpp"
+#include <algorithm>
+
+RetentionPolicy::RetentionPolicy(Options options) : options_(std::move(options)) {
+    auto consider = [this](std::chrono::seconds age) {
+        if (age.count() > 0) shortest_age_ = shortest_age_ ? std::min(*shortest_age_, age) : age;
+    };
+    consider(options_.max_age);
+    for (const auto& [topic, age] : options_.topic_max_age) consider(age);
+
+    // Unknown topics follow max_age, so with no global limit some record may live forever
+    bool forever = options_.max_age.count() == 0;
+    std::chrono::seconds longest = options_.max_age;
+    for (const auto& [topic, age] : options_.topic_max_age) {
+        if (age.count() == 0) forever = true;
+        longest = std::max(longest, age);
+    }
+    if (!forever) longest_age_ = longest;
+}
+
+std::optional<uint64_t> RetentionPolicy::cutoffFor(std::chrono::seconds age, uint64_t now_ns) {
+    if (age.count() <= 0) return std::nullopt;
+    uint64_t span = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(age).count());
+    return now_ns > span ? now_ns - span : 0;
+}
+
+std::optional<uint64_t> RetentionPolicy::cutoff(std::string_view topic, uint64_t now_ns) const {
+    if (!options_.topic_max_age.empty()) {
+        if (auto it = options_.topic_max_age.find(std::string(topic)); it != options_.topic_max_age.end()) {
+            return cutoffFor(it->second, now_ns);
+        }
+    }
+    return cutoffFor(options_.max_age, now_ns);
+}
+
+std::optional<uint64_t> RetentionPolicy::cutoffForAll(uint64_t now_ns) const {
+    if (!longest_age_) return std::nullopt;
+    return cutoffFor(*longest_age_, now_ns);
+}
+
+std::optional<uint64_t> RetentionPolicy::cutoffForAny(uint64_t now_ns) const {
+    if (!shortest_age_) return std::nullopt;
+    return cutoffFor(*shortest_age_, now_ns);
+}
@@ -0,0 +1,754 @@
+#include "storage_engine/segmented_log.hpp"
+#include "storage_engine/columnar_segment.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int syncData(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd);
+#else
+    return ::fsync(fd);
+#endif
+}
+
+// Makes a newly created segment file's directory entry durable
+void syncDirectory(const std::string& directory) {
+    int dfd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) return;
+    ::fsync(dfd);
+    ::close(dfd);
+}
+
+// Whole file in one read; false if it cannot be opened
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    bytes.clear();
+    if (::fstat(fd, &st) == 0) bytes.resize(static_cast<size_t>(st.st_size));
+    size_t have = 0;
+    while (have < bytes.size()) {
+        ssize_t n = ::pread(fd, bytes.data() + have, bytes.size() - have, static_cast<off_t>(have));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        have += static_cast<size_t>(n);
+    }
+    bytes.resize(have);
+    ::close(fd);
+    return true;
+}
+
+std::exception_ptr ioError(const std::string& what) {
+    return std::make_exception_ptr(std::runtime_error(what + ": " + std::strerror(errno)));
+}
+
+} // namespace
+
+SegmentedLog::SegmentedLog(std::string directory, Options options)
+    : directory_(std::move(directory)), options_(options), index_(directory_), time_index_(directory_, options.summary_block_bytes),
+      staging_(options.staging_capacity) {
+    if (options_.segment_bytes == 0) {
+        throw std::invalid_argument("SegmentedLog segment_bytes must be > 0");
+    }
+    if (options_.direct_io && (options_.direct_buffers < 2 || options_.direct_buffer_bytes == 0 ||
+                               options_.direct_buffer_bytes % kDirectAlignment != 0)) {
+        throw std::invalid_argument("SegmentedLog direct_io needs 2+ buffers of a multiple of 4096 bytes");
+    }
+    fs::create_directories(directory_);
+
+    // Copies of a retention rewrite that stopped before its rename
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory_, ec)) {
+        if (entry.path().filename().string().find(kReplacementSuffix) != std::string::npos) {
+            fs::remove(entry.path(), ec);
+        }
+    }
+
+    // Continue appending to the newest existing segment, unless it was compacted
+    std::vector<uint64_t> segments = listSegments(directory_);
+    uint64_t last = segments.empty() ? 0 : segments.back();
+    if (!segments.empty() && !fs::exists(fs::path(directory_) / segmentFileName(last))) ++last;
+    for (uint64_t segment : segments) {
+        if (segment == last) continue;
+        // A compaction that stopped between the rename and the unlink
+        fs::path row = fs::path(directory_) / segmentFileName(segment);
+        std::error_code ec;
+        if (fs::exists(fs::path(directory_) / ColumnarSegment::fileName(segment), ec) && fs::remove(row, ec)) {
+            spdlog::info("Removed row segment {} in {}: its compacted copy is complete", segment, directory_);
+        }
+        bool haveIndex = index_.loadSealed(segment);
+        bool haveSummary = time_index_.loadSealed(segment);
+        if (!haveIndex || !haveSummary) rebuilds_.push_back({segment, !haveIndex, !haveSummary});
+    }
+    auto active = recoverActive(last);
+    index_.loadActive(last, active);
+    time_index_.loadActive(last, active);
+    for (const auto& range : time_index_.sealedRanges()) {
+        if (range.records > 0) noteRecovered(range.max_ts);
+    }
+    noteRecovered(active);
+    if (options_.direct_io) {
+        direct_ = true;
+        for (size_t i = 0; i < options_.direct_buffers; ++i) {
+            auto buffer = std::make_unique<DirectBuffer>();
+            buffer->data.reset(static_cast<uint8_t*>(std::aligned_alloc(kDirectAlignment, options_.direct_buffer_bytes)));
+            if (!buffer->data) throw std::bad_alloc();
+            direct_free_.push_back(std::move(buffer));
+        }
+        filling_ = std::move(direct_free_.back());
+        direct_free_.pop_back();
+    }
+    if (!openSegment(last)) {
+        spdlog::error("Failed to open log segment in {}", directory_);
+        throw std::runtime_error("Failed to open storage log segment");
+    }
+    if (!direct_) {
+        filling_.reset();
+        direct_free_.clear();
+    }
+    last_sync_ = std::chrono::steady_clock::now();
+    if (direct_) direct_thread_ = std::thread(&SegmentedLog::directLoop, this);
+    writer_ = std::thread(&SegmentedLog::writerLoop, this);
+
+    if (!rebuilds_.empty()) {
+        size_t threads = options_.recovery_threads ? options_.recovery_threads
+                                                   : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, rebuilds_.size());
+        spdlog::info("Rebuilding indexes of {} segment(s) in {} on {} thread(s)", rebuilds_.size(), directory_,
+                     threads);
+        indexes_ready_.store(false, std::memory_order_release);
+        rebuilders_.store(threads, std::memory_order_relaxed);
+        for (size_t i = 0; i < threads; ++i) recovery_.emplace_back(&SegmentedLog::recoveryLoop, this);
+    }
+}
+
+SegmentedLog::~SegmentedLog() {
+    close();
+}
+
+std::string SegmentedLog::segmentFileName(uint64_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06llu.log", static_cast<unsigned long long>(index));
+    return name;
+}
+
+std::vector<uint64_t> SegmentedLog::listSegments(const std::string& directory) {
+    std::vector<uint64_t> segments;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        unsigned long long index;
+        char suffix[4] = {};
+        if (std::sscanf(entry.path().filename().c_str(), "segment-%llu.%3s", &index, suffix) == 2 &&
+            (std::strcmp(suffix, "log") == 0 || std::strcmp(suffix, "col") == 0)) {
+            segments.push_back(index);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    segments.erase(std::unique(segments.begin(), segments.end()), segments.end());
+    return segments;
+}
+
+SegmentedLog::SyncPolicy SegmentedLog::parseSyncPolicy(const std::string& name) {
+    if (name == "batch") return SyncPolicy::EveryBatch;
+    if (name == "interval") return SyncPolicy::Interval;
+    if (name == "bytes") return SyncPolicy::Bytes;
+    throw std::invalid_argument("Unknown storage sync policy: " + name);
+}
+
+std::future<void> SegmentedLog::append(std::vector<uint8_t>&& bytes,
+                                       std::vector<RecordFormat::IndexedRecord>&& records) {
+    PendingWrite write{std::move(bytes), std::move(records), {}};
+    std::future<void> result = write.done.get_future();
+
+    appenders_.fetch_add(1, std::memory_order_seq_cst);
+    bool pushed = false;
+    while (accepting_.load(std::memory_order_seq_cst)) {
+        if (staging_.tryPush(std::move(write))) {
+            pushed = true;
+            break;
+        }
+        space_parker_.waitFor(std::chrono::milliseconds(100), [this] {
+            return !staging_.full() || !accepting_.load(std::memory_order_acquire);
+        });
+    }
+    appenders_.fetch_sub(1, std::memory_order_seq_cst);
+
+    if (pushed) {
+        data_parker_.notify();
+    } else {
+        write.done.set_exception(std::make_exception_ptr(std::runtime_error("SegmentedLog is closed")));
+    }
+    return result;
+}
+
+void SegmentedLog::close() {
+    if (!accepting_.exchange(false, std::memory_order_seq_cst)) return;
+    space_parker_.notifyAll();
+    // Appends that got past the accepting_ check finish pushing first, so the
+    // writer's final drain sees them
+    while (appenders_.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    stopping_.store(true, std::memory_order_release);
+    data_parker_.notifyAll();
+    if (writer_.joinable()) writer_.join();
+    // Rebuilds not yet started are left to the next open
+    for (auto& thread : recovery_) thread.join();
+    recovery_.clear();
+}
+
+void SegmentedLog::waitForIndexes() const {
+    if (indexesReady()) return;
+    std::unique_lock lock(rebuild_mutex_);
+    rebuild_cv_.wait(lock, [this] { return indexesReady(); });
+}
+
+void SegmentedLog::recoveryLoop() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        size_t next = next_rebuild_.fetch_add(1, std::memory_order_relaxed);
+        if (next >= rebuilds_.size()) break;
+        const PendingRebuild& rebuild = rebuilds_[next];
+        auto records = scanSegment(rebuild.segment);
+        if (rebuild.index) index_.buildSealed(rebuild.segment, records);
+        if (rebuild.summary) {
+            time_index_.buildSealed(rebuild.segment, records);
+            noteRecovered(records);
+        }
+    }
+    if (rebuilders_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        {
+            std::lock_guard lock(rebuild_mutex_);
+            indexes_ready_.store(true, std::memory_order_release);
+        }
+        rebuild_cv_.notify_all();
+    }
+}
+
+std::optional<uint64_t> SegmentedLog::recoveredMaxTimestamp() const {
+    if (!recovered_any_.load(std::memory_order_acquire)) return std::nullopt;
+    return recovered_max_ts_.load(std::memory_order_acquire);
+}
+
+void SegmentedLog::noteRecovered(std::span<const RecordFormat::IndexedRecord> records) {
+    if (records.empty()) return;
+    uint64_t newest = 0;
+    for (const auto& record : records) newest = std::max(newest, record.timestamp);
+    noteRecovered(newest);
+}
+
+void SegmentedLog::noteRecovered(uint64_t timestamp) {
+    uint64_t seen = recovered_max_ts_.load(std::memory_order_relaxed);
+    while (seen < timestamp &&
+           !recovered_max_ts_.compare_exchange_weak(seen, timestamp, std::memory_order_acq_rel)) {
+    }
+    recovered_any_.store(true, std::memory_order_release);
+}
+
+void SegmentedLog::forgetSegment(uint64_t segment) {
+    if (segment >= activeSegment()) throw std::invalid_argument("Only sealed segments can be forgotten");
+    index_.dropSealed(segment);
+    time_index_.dropSealed(segment);
+}
+
+void SegmentedLog::replaceSegment(uint64_t segment, const std::string& target,
+                                  std::span<const RecordFormat::IndexedRecord> records) {
+    if (segment >= activeSegment()) throw std::invalid_argument("Only sealed segments can be replaced");
+    index_.discardFile(segment);
+    time_index_.discardFile(segment);
+    fs::rename(target + std::string(kReplacementSuffix), target);
+    index_.replaceSealed(segment, records);
+    time_index_.replaceSealed(segment, records);
+}
+
+std::vector<RecordFormat::IndexedRecord> SegmentedLog::scanSegment(uint64_t index) const {
+    std::vector<RecordFormat::IndexedRecord> records;
+    std::vector<uint8_t> bytes;
+    if (!readFile((fs::path(directory_) / segmentFileName(index)).string(), bytes)) {
+        auto columnar = ColumnarSegment::open((fs::path(directory_) / ColumnarSegment::fileName(index)).string());
+        if (!columnar || !columnar->read(0, columnar->logicalSize(), bytes)) return records;
+    }
+
+    std::span<const uint8_t> rest(bytes);
+    uint64_t offset = 0;
+    size_t corrupt = 0;
+    while (!rest.empty()) {
+        size_t used = RecordFormat::validate(rest);
+        if (used == 0) {
+            // A record whose frame still fits is skipped; anything else ends the scan
+            size_t framed = RecordFormat::requiredSize(rest);
+            if (framed <= RecordFormat::kFrameSize || framed > rest.size()) {
+                spdlog::warn("Segment {} in {} ends with {} unreadable bytes", index, directory_, rest.size());
+                break;
+            }
+            ++corrupt;
+            offset += framed;
+            rest = rest.subspan(framed);
+            continue;
+        }
+        RecordFormat::RecordKey key;
+        RecordFormat::peek(rest, key);
+        records.push_back({key.id, offset, used, key.timestamp, RecordFormat::topicHash(key.topic)});
+        offset += used;
+        rest = rest.subspan(used);
+    }
+    if (corrupt > 0) spdlog::error("Skipped {} corrupt record(s) in segment {} in {}", corrupt, index, directory_);
+    return records;
+}
+
+std::vector<RecordFormat::IndexedRecord> SegmentedLog::recoverActive(uint64_t index) {
+    std::vector<RecordFormat::IndexedRecord> records;
+    std::string path = (fs::path(directory_) / segmentFileName(index)).string();
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) return records;
+
+    std::span<const uint8_t> rest(bytes);
+    uint64_t offset = 0;
+    while (size_t used = RecordFormat::validate(rest)) {
+        RecordFormat::RecordKey key;
+        RecordFormat::peek(rest, key);
+        records.push_back({key.id, offset, used, key.timestamp, RecordFormat::topicHash(key.topic)});
+        offset += used;
+        rest = rest.subspan(used);
+    }
+    if (!rest.empty()) {
+        // Everything past the last intact record was written after the last sync
+        spdlog::warn("Truncating {} torn byte(s) at the end of segment {} in {}", rest.size(), index, directory_);
+        if (::truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+            spdlog::error("Failed to truncate {}: {}", path, std::strerror(errno));
+            throw std::runtime_error("Failed to truncate torn log segment");
+        }
+    }
+    return records;
+}
+
+bool SegmentedLog::openSegment(uint64_t index) {
+    std::string path = (fs::path(directory_) / segmentFileName(index)).string();
+    int fd = -1;
+    if (direct_) {
+        // Positioned writes: O_APPEND would ignore the offsets
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT | O_DSYNC, 0644);
+        if (fd < 0 && errno == EINVAL && fd_ < 0) {
+            spdlog::warn("{} does not support O_DIRECT; using buffered writes", directory_);
+            direct_ = false;
+        }
+    }
+    if (!direct_) fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        spdlog::error("Failed to open segment {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    struct stat st{};
+    ::fstat(fd, &st);
+    size_t size = static_cast<size_t>(st.st_size);
+    if (direct_) {
+        // Continue from the last whole block, rewriting the partial one after it
+        filling_->segment = index;
+        filling_->fd = fd;
+        filling_->file_offset = size & ~(kDirectAlignment - 1);
+        filling_->used = size - filling_->file_offset;
+        filling_->records.clear();
+        {
+            std::lock_guard lock(direct_mutex_);
+            durable_end_ = size;
+        }
+        if (filling_->used > 0 &&
+            ::pread(fd, filling_->data.get(), kDirectAlignment, static_cast<off_t>(filling_->file_offset)) <
+                static_cast<ssize_t>(filling_->used)) {
+            spdlog::error("Failed to read the tail of segment {}: {}", path, std::strerror(errno));
+            ::close(fd);
+            return false;
+        }
+    }
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = fd;
+    segment_size_ = size;
+    active_segment_.store(index, std::memory_order_release);
+    if (segment_size_ == 0) syncDirectory(directory_);
+    return true;
+}
+
+void SegmentedLog::writerLoop() {
+    std::vector<PendingWrite> batch(kMaxBatch);
+    while (true) {
+        size_t n = staging_.tryPopBatch(batch.data(), batch.size());
+        if (n > 0) {
+            space_parker_.notifyAll();
+            if (direct_) {
+                writeDirect(batch.data(), n);
+            } else {
+                writeBatch(batch.data(), n);
+            }
+            for (size_t i = 0; i < n; ++i) batch[i] = PendingWrite{};
+            if (!direct_) maybeSync();
+            continue;
+        }
+
+        if (direct_) {
+            if (direct_failed_.load(std::memory_order_acquire)) recoverDirect();
+            // What piled up during the last write goes out as one
+            if (!filling_->done.empty() && directIdle()) {
+                submitDirect();
+                continue;
+            }
+        } else if (!awaiting_sync_.empty() &&
+                   std::chrono::steady_clock::now() - last_sync_ >= options_.sync_interval) {
+            sync();
+        }
+        if (stopping_.load(std::memory_order_acquire) && staging_.empty()) break;
+
+        auto timeout = awaiting_sync_.empty() ? std::chrono::milliseconds(100) : options_.sync_interval;
+        data_parker_.waitFor(timeout, [this] {
+            return !staging_.empty() || stopping_.load(std::memory_order_acquire) ||
+                   (direct_ && !filling_->done.empty() && directIdle());
+        });
+    }
+    if (direct_) {
+        if (!filling_->done.empty()) submitDirect();
+        drainDirect();
+        if (direct_failed_.load(std::memory_order_acquire)) recoverDirect();
+        {
+            std::lock_guard lock(direct_mutex_);
+            direct_stopping_ = true;
+        }
+        direct_cv_.notify_all();
+        direct_thread_.join();
+        // Drop the padding of the last block
+        if (::ftruncate(fd_, static_cast<off_t>(segment_size_)) != 0) {
+            spdlog::error("Failed to trim segment {} in {}: {}", active_segment_.load(std::memory_order_relaxed),
+                          directory_, std::strerror(errno));
+        }
+    }
+    sync();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void SegmentedLog::writeBatch(PendingWrite* batch, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        // Seal the segment when the next append would overflow it; an append
+        // larger than a whole segment gets a segment of its own
+        if (segment_size_ > 0 && segment_size_ + batch[i].bytes.size() > options_.segment_bytes) {
+            sync();
+            uint64_t sealed = active_segment_.load(std::memory_order_relaxed);
+            if (!openSegment(sealed + 1)) {
+                failAll(ioError("Failed to roll log segment"), batch + i, count - i);
+                return;
+            }
+            index_.seal(sealed);
+            time_index_.seal(sealed);
+        }
+        size_t j = i;
+        size_t run_bytes = 0;
+        while (j < count && (j == i || segment_size_ + run_bytes + batch[j].bytes.size() <= options_.segment_bytes)) {
+            run_bytes += batch[j].bytes.size();
+            ++j;
+        }
+        writeRun(batch + i, j - i);
+        i = j;
+    }
+}
+
+void SegmentedLog::writeDirect(PendingWrite* batch, size_t count) {
+    const size_t capacity = options_.direct_buffer_bytes;
+    for (size_t i = 0; i < count; ++i) {
+        PendingWrite& write = batch[i];
+        if (direct_failed_.load(std::memory_order_acquire)) recoverDirect();
+        if (segment_size_ > 0 && segment_size_ + write.bytes.size() > options_.segment_bytes) {
+            if (!filling_->done.empty()) submitDirect();
+            drainDirect();
+            // Only the active segment can have failed writes to cut off
+            if (direct_failed_.load(std::memory_order_acquire)) {
+                recoverDirect();
+                if (segment_size_ == 0 || segment_size_ + write.bytes.size() <= options_.segment_bytes) {
+                    --i;
+                    continue;
+                }
+            }
+            if (::ftruncate(fd_, static_cast<off_t>(segment_size_)) != 0) {
+                spdlog::error("Failed to trim sealed segment {} in {}: {}",
+                              active_segment_.load(std::memory_order_relaxed), directory_, std::strerror(errno));
+            }
+            uint64_t sealed = active_segment_.load(std::memory_order_relaxed);
+            if (!openSegment(sealed + 1)) {
+                failAll(ioError("Failed to roll log segment"), batch + i, count - i);
+                return;
+            }
+            index_.seal(sealed);
+            time_index_.seal(sealed);
+        }
+
+        std::span<const uint8_t> rest(write.bytes);
+        while (!rest.empty()) {
+            if (filling_->used == capacity) submitDirect();
+            size_t n = std::min(rest.size(), capacity - filling_->used);
+            std::memcpy(filling_->data.get() + filling_->used, rest.data(), n);
+            filling_->used += n;
+            rest = rest.subspan(n);
+        }
+        // Visible and complete once the buffer holding the append's last byte is written
+        for (auto record : write.records) {
+            record.offset += segment_size_;
+            filling_->records.push_back(record);
+        }
+        filling_->done.push_back(std::move(write.done));
+        segment_size_ += write.bytes.size();
+        filling_->appends_end = segment_size_;
+        if (options_.on_written) filling_->appends.emplace_back(std::move(write.bytes), std::move(write.records));
+    }
+    if (!filling_->done.empty() && directIdle()) submitDirect();
+}
+
+void SegmentedLog::submitDirect() {
+    std::unique_ptr<DirectBuffer> next;
+    {
+        std::unique_lock lock(direct_mutex_);
+        direct_cv_.wait(lock, [this] { return !direct_free_.empty(); });
+        next = std::move(direct_free_.back());
+        direct_free_.pop_back();
+    }
+    // The next buffer starts over the partial last block
+    DirectBuffer& full = *filling_;
+    size_t whole = full.used & ~(kDirectAlignment - 1);
+    size_t padded = (full.used + kDirectAlignment - 1) & ~(kDirectAlignment - 1);
+    next->segment = full.segment;
+    next->fd = full.fd;
+    next->file_offset = full.file_offset + whole;
+    next->used = full.used - whole;
+    std::memcpy(next->data.get(), full.data.get() + whole, next->used);
+    std::memset(full.data.get() + full.used, 0, padded - full.used);
+    {
+        std::lock_guard lock(direct_mutex_);
+        direct_queue_.push_back(std::move(filling_));
+    }
+    direct_cv_.notify_all();
+    filling_ = std::move(next);
+}
+
+void SegmentedLog::drainDirect() {
+    std::unique_lock lock(direct_mutex_);
+    direct_cv_.wait(lock, [this] { return direct_queue_.empty(); });
+}
+
+bool SegmentedLog::directIdle() {
+    std::lock_guard lock(direct_mutex_);
+    return direct_queue_.empty();
+}
+
+void SegmentedLog::recoverDirect() {
+    // The I/O thread fails whatever is still queued without writing it
+    drainDirect();
+    std::exception_ptr error;
+    uint64_t good;
+    {
+        std::lock_guard lock(direct_mutex_);
+        error = direct_error_;
+        good = durable_end_;
+    }
+    for (auto& done : filling_->done) done.set_exception(error);
+    filling_->done.clear();
+    filling_->records.clear();
+    filling_->appends.clear();
+
+    uint64_t segment = active_segment_.load(std::memory_order_relaxed);
+    if (::ftruncate(fd_, static_cast<off_t>(good)) != 0) {
+        spdlog::error("Failed to cut failed writes off segment {} in {}: {}", segment, directory_,
+                      std::strerror(errno));
+    }
+    segment_size_ = good;
+    filling_->file_offset = good & ~(kDirectAlignment - 1);
+    filling_->used = good - filling_->file_offset;
+    if (filling_->used > 0 &&
+        ::pread(fd_, filling_->data.get(), kDirectAlignment, static_cast<off_t>(filling_->file_offset)) <
+            static_cast<ssize_t>(filling_->used)) {
+        spdlog::error("Failed to reread the tail of segment {} in {}: {}", segment, directory_,
+                      std::strerror(errno));
+    }
+    spdlog::warn("Segment {} in {} cut back to {} bytes after a failed write", segment, directory_, good);
+
+    std::lock_guard lock(direct_mutex_);
+    direct_error_ = nullptr;
+    direct_failed_.store(false, std::memory_order_release);
+}
+
+void SegmentedLog::directLoop() {
+    while (true) {
+        DirectBuffer* buffer;
+        {
+            std::unique_lock lock(direct_mutex_);
+            direct_cv_.wait(lock, [this] { return !direct_queue_.empty() || direct_stopping_; });
+            if (direct_queue_.empty()) return;
+            buffer = direct_queue_.front().get();
+        }
+
+        size_t length = (buffer->used + kDirectAlignment - 1) & ~(kDirectAlignment - 1);
+        size_t written = 0;
+        std::exception_ptr error;
+        if (direct_failed_.load(std::memory_order_acquire)) {
+            // Continues past bytes that never made it; the writer starts over
+            std::lock_guard lock(direct_mutex_);
+            error = direct_error_;
+            length = 0;
+        }
+        while (written < length) {
+            ssize_t n = ::pwrite(buffer->fd, buffer->data.get() + written, length - written,
+                                 static_cast<off_t>(buffer->file_offset + written));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                spdlog::error("O_DIRECT write to segment {} in {} failed: {}", buffer->segment, directory_,
+                              std::strerror(errno));
+                error = ioError("Log write failed");
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        if (error && !direct_failed_.load(std::memory_order_acquire)) {
+            // Raised before any future fails, so a retry is never written behind the gap
+            std::lock_guard lock(direct_mutex_);
+            direct_error_ = error;
+            direct_failed_.store(true, std::memory_order_release);
+        }
+        if (!error && options_.on_written) {
+            for (const auto& [bytes, records] : buffer->appends) options_.on_written(bytes, records);
+        }
+        if (!error && !buffer->records.empty()) {
+            index_.add(buffer->segment, buffer->records);
+            time_index_.add(buffer->segment, buffer->records);
+        }
+        for (auto& done : buffer->done) {
+            if (error) {
+                done.set_exception(error);
+            } else {
+                done.set_value();
+            }
+        }
+        bool completed = !error && !buffer->done.empty();
+        buffer->records.clear();
+        buffer->done.clear();
+        buffer->appends.clear();
+        buffer->used = 0;
+
+        {
+            std::lock_guard lock(direct_mutex_);
+            if (completed) durable_end_ = buffer->appends_end;
+            direct_free_.push_back(std::move(direct_queue_.front()));
+            direct_queue_.pop_front();
+        }
+        direct_cv_.notify_all();
+        data_parker_.notify();
+    }
+}
+
+void SegmentedLog::writeRun(PendingWrite* batch, size_t count) {
+    std::vector<iovec> iov;
+    iov.reserve(count);
+    size_t total = 0;
+    for (size_t k = 0; k < count; ++k) {
+        if (batch[k].bytes.empty()) continue;
+        iov.push_back({batch[k].bytes.data(), batch[k].bytes.size()});
+        total += batch[k].bytes.size();
+    }
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        ssize_t written = ::writev(fd_, iov.data() + first, static_cast<int>(iov.size() - first));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            uint64_t segment = active_segment_.load(std::memory_order_relaxed);
+            spdlog::error("writev to segment {} in {} failed: {}", segment, directory_, std::strerror(errno));
+            // Whatever part of the run did reach the file belongs to appends
+            // reported as failed; recovery must not find half of them
+            if (::ftruncate(fd_, static_cast<off_t>(segment_size_)) != 0) {
+                spdlog::error("Failed to cut failed write off segment {} in {}: {}",
+                              segment, directory_, std::strerror(errno));
+            }
+            failAll(ioError("Log write failed"), batch, count);
+            return;
+        }
+        // Skip fully written buffers and advance into a partially written one
+        size_t left = static_cast<size_t>(written);
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+
+    if (options_.on_written) {
+        for (size_t k = 0; k < count; ++k) options_.on_written(batch[k].bytes, batch[k].records);
+    }
+    index_scratch_.clear();
+    uint64_t base = segment_size_;
+    for (size_t k = 0; k < count; ++k) {
+        for (auto record : batch[k].records) {
+            record.offset += base;
+            index_scratch_.push_back(record);
+        }
+        base += batch[k].bytes.size();
+    }
+    if (!index_scratch_.empty()) {
+        uint64_t segment = active_segment_.load(std::memory_order_relaxed);
+        index_.add(segment, index_scratch_);
+        time_index_.add(segment, index_scratch_);
+    }
+
+    segment_size_ += total;
+    unsynced_bytes_ += total;
+    for (size_t k = 0; k < count; ++k) {
+        awaiting_sync_.push_back(std::move(batch[k].done));
+    }
+}
+
+void SegmentedLog::maybeSync() {
+    auto since = std::chrono::steady_clock::now() - last_sync_;
+    switch (options_.sync_policy) {
+    case SyncPolicy::EveryBatch:
+        sync();
+        break;
+    case SyncPolicy::Interval:
+        if (since >= options_.sync_interval) sync();
+        break;
+    case SyncPolicy::Bytes:
+        if (unsynced_bytes_ >= options_.sync_bytes || since >= options_.sync_interval) sync();
+        break;
+    }
+}
+
+void SegmentedLog::sync() {
+    if (awaiting_sync_.empty() && unsynced_bytes_ == 0) return;
+    if (syncData(fd_) != 0) {
+        spdlog::error("fdatasync of segment {} in {} failed: {}",
+                      active_segment_.load(std::memory_order_relaxed), directory_, std::strerror(errno));
+        auto error = ioError("Log sync failed");
+        for (auto& done : awaiting_sync_) done.set_exception(error);
+    } else {
+        for (auto& done : awaiting_sync_) done.set_value();
+    }
+    awaiting_sync_.clear();
+    unsynced_bytes_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+}
+
+void SegmentedLog::failAll(std::exception_ptr error, PendingWrite* batch, size_t count) {
+    for (size_t k = 0; k < count; ++k) {
+        batch[k].done.set_exception(error);
+    }
+}
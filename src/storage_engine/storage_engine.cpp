@@ -1,45 +1,676 @@
 #include "storage_engine/storage_engine.hpp"
+#include "storage_engine/record_format.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
 #include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-StorageEngine::StorageEngine(const std::string& storagePath) {
-    storageFile.open(storagePath, std::ios::binary | std::ios::app);
-    if (!storageFile.is_open()) {
-        spdlog::error("Failed to open storage file at {}", storagePath);
-        throw std::runtime_error("Failed to open storage file");
+namespace {
+
+RecordFormat::IndexedRecord indexedRecord(const EventStream::Event& event, uint64_t offset, uint64_t size) {
+    return {event.header.id, offset, size, event.header.timestamp, RecordFormat::topicHash(event.topic)};
+}
+
+// Size of whichever file holds the segment, row or compacted
+uint64_t segmentBytes(const std::filesystem::path& directory, uint64_t segment) {
+    std::error_code ec;
+    uint64_t bytes = std::filesystem::file_size(directory / SegmentedLog::segmentFileName(segment), ec);
+    if (ec) bytes = std::filesystem::file_size(directory / ColumnarSegment::fileName(segment), ec);
+    return ec ? 0 : bytes;
+}
+
+bool writeSynced(const std::string& path, std::span<const uint8_t> bytes) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += static_cast<size_t>(n);
+    }
+    bool ok = written == bytes.size() && ::fdatasync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+} // namespace
+
+StorageEngine::StorageEngine(const std::string& storagePath, SegmentedLog::Options options, size_t partitionCount,
+                             ColumnarSegment::CompactionOptions compaction, RetentionPolicy::Options retention,
+                             size_t tailCacheBytes)
+    : storagePath(storagePath), cached(tailCacheBytes > 0), compaction(compaction), retention(std::move(retention)) {
+    if (partitionCount == 0) throw std::invalid_argument("StorageEngine needs at least one partition");
+
+    // Topics must stay in the partition they were first written to
+    std::vector<std::string> existing = partitionDirectories(storagePath);
+    bool populated = existing.size() > 1 || !SegmentedLog::listSegments(existing.front()).empty();
+    if (populated && existing.size() != partitionCount) {
+        spdlog::warn("Storage {} already holds {} partition(s); ignoring the configured {}",
+                     storagePath, existing.size(), partitionCount);
+        partitionCount = existing.size();
+    }
+
+    // Each partition validates its active segment while opening
+    size_t cacheBytes = tailCacheBytes / partitionCount;
+    std::vector<std::future<std::unique_ptr<Partition>>> opening;
+    for (size_t i = 0; i < partitionCount; ++i) {
+        std::string directory = partitionCount == 1
+            ? storagePath
+            : (std::filesystem::path(storagePath) / partitionDirectoryName(i)).string();
+        opening.push_back(std::async(partitionCount == 1 ? std::launch::deferred : std::launch::async,
+                                     [directory, options, cacheBytes] {
+                                         return std::make_unique<Partition>(directory, options, cacheBytes);
+                                     }));
+    }
+    partitions.reserve(partitionCount);
+    for (auto& partition : opening) partitions.push_back(partition.get());
+    if (compaction.enable || this->retention.options().enable) {
+        maintenance = std::thread(&StorageEngine::maintenanceLoop, this);
     }
 }
 
+StorageEngine::Partition::Partition(const std::string& directory, const SegmentedLog::Options& options,
+                                    size_t cacheBytes)
+    : cache(cacheBytes), log(directory, [&] {
+          SegmentedLog::Options withCache = options;
+          if (cache.enabled()) {
+              withCache.on_written = [this](std::span<const uint8_t> bytes,
+                                            std::span<const RecordFormat::IndexedRecord> records) {
+                  for (const auto& record : records) {
+                      cache.insert(record, bytes.subspan(record.offset, record.size));
+                  }
+              };
+          }
+          return withCache;
+      }()) {}
+
 StorageEngine::~StorageEngine() {
-    if (storageFile.is_open()) {
-        storageFile.close();
+    {
+        std::lock_guard lock(maintenance_mutex);
+        maintenance_stopping = true;
     }
+    maintenance_cv.notify_all();
+    if (maintenance.joinable()) maintenance.join();
+    for (auto& partition : partitions) partition->log.close();
+}
+
+StorageEngine::SegmentFile::~SegmentFile() {
+    if (fd >= 0) ::close(fd);
+}
+
+std::string StorageEngine::partitionDirectoryName(size_t partition) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "partition-%02zu", partition);
+    return name;
+}
+
+std::vector<std::string> StorageEngine::partitionDirectories(const std::string& storagePath) {
+    std::vector<std::string> directories;
+    std::error_code ec;
+    for (size_t i = 0;; ++i) {
+        auto directory = std::filesystem::path(storagePath) / partitionDirectoryName(i);
+        if (!std::filesystem::is_directory(directory, ec)) break;
+        directories.push_back(directory.string());
+    }
+    if (directories.empty()) directories.push_back(storagePath);
+    return directories;
+}
+
+size_t StorageEngine::partitionOf(std::string_view topic) const {
+    return partitions.size() == 1 ? 0 : RecordFormat::topicHash(topic) % partitions.size();
+}
+
+size_t StorageEngine::partitionOf(EventStream::Topic topic) const {
+    return partitions.size() == 1 ? 0 : topic.hash() % partitions.size();
 }
 
 void StorageEngine::storeEvent(const EventStream::Event& event) {
-    std::lock_guard<std::mutex> lock(storageMutex);
-    
-    // Simple binary serialization 
-    uint64_t ts = static_cast<uint64_t>(event.header.timestamp);
-    storageFile.write(reinterpret_cast<const char*>(&ts), sizeof(ts));
-    uint8_t source = static_cast<uint8_t>(event.header.sourceType);
-    storageFile.write(reinterpret_cast<const char*>(&source), sizeof(source));
-    storageFile.write(reinterpret_cast<const char*>(&event.header.id), sizeof(event.header.id));
-    // write topic length and topic bytes so topic is persisted
-    uint32_t topicLen = static_cast<uint32_t>(event.topic.size());
-    storageFile.write(reinterpret_cast<const char*>(&topicLen), sizeof(topicLen));
-    if (topicLen > 0) {
-        storageFile.write(event.topic.data(), topicLen);
-    }
-
-    uint64_t payloadSize = event.body.size();
-    storageFile.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
-    storageFile.write(reinterpret_cast<const char*>(event.body.data()), payloadSize);
-    
-    storageFile.flush();
-    if (!storageFile.good()) {
-        spdlog::error("Failed to write event {} to storage", event.header.id);
+    try {
+        appendEvent(event).get();
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to write event {} to storage: {}", event.header.id, e.what());
         throw std::runtime_error("Failed to write event to storage");
     }
-}
\ No newline at end of file
+}
+
+std::future<void> StorageEngine::appendEvent(const EventStream::Event& event) {
+    std::vector<uint8_t> record;
+    RecordFormat::encode(event, record);
+    auto key = indexedRecord(event, 0, record.size());
+    return partitions[partitionOf(event.topic)]->log.append(std::move(record), {key});
+}
+
+std::future<void> StorageEngine::appendBatch(std::span<const EventStream::EventPtr> events) {
+    // One staged append per partition touched: never split across segments
+    struct Staged {
+        std::vector<uint8_t> records;
+        std::vector<RecordFormat::IndexedRecord> index;
+    };
+    std::vector<Staged> staged(partitions.size());
+    std::vector<size_t> target(events.size());
+    std::vector<size_t> bytes(partitions.size(), 0);
+    for (size_t i = 0; i < events.size(); ++i) {
+        target[i] = partitionOf(events[i]->topic);
+        bytes[target[i]] += RecordFormat::encodedSize(*events[i]);
+    }
+    for (size_t i = 0; i < partitions.size(); ++i) staged[i].records.reserve(bytes[i]);
+    for (size_t i = 0; i < events.size(); ++i) {
+        const auto& event = events[i];
+        Staged& into = staged[target[i]];
+        size_t offset = into.records.size();
+        RecordFormat::encode(*event, into.records);
+        into.index.push_back(indexedRecord(*event, offset, into.records.size() - offset));
+    }
+
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        if (staged[i].index.empty()) continue;
+        pending.push_back(partitions[i]->log.append(std::move(staged[i].records), std::move(staged[i].index)));
+    }
+    if (pending.size() == 1) return std::move(pending.front());
+    return std::async(std::launch::deferred, [pending = std::move(pending)]() mutable {
+        for (auto& future : pending) future.get();
+    });
+}
+
+bool StorageEngine::retrieveEvent(uint64_t eventId, EventStream::Event& event) {
+    if (cached) {
+        for (auto& partition : partitions) {
+            if (partition->cache.find(eventId, event)) {
+                cache_hits.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        cache_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (auto& partition : partitions) {
+        partition->log.waitForIndexes();
+        std::shared_lock lock(partition->segments_mutex);
+        if (auto location = partition->log.index().find(eventId)) return readRecord(*partition, *location, event);
+    }
+    return false;
+}
+
+size_t StorageEngine::retrieveRange(uint64_t firstId, uint64_t lastId, std::vector<EventStream::Event>& out) {
+    size_t first = out.size();
+    std::vector<OffsetIndex::Location> locations;
+    for (auto& partition : partitions) {
+        partition->log.waitForIndexes();
+        std::shared_lock lock(partition->segments_mutex);
+        locations.clear();
+        partition->log.index().findRange(firstId, lastId, locations);
+        for (const auto& location : locations) {
+            EventStream::Event event;
+            if (readRecord(*partition, location, event)) out.push_back(std::move(event));
+        }
+    }
+    // Each partition comes back in id order; interleave them
+    if (partitions.size() > 1) {
+        std::stable_sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+                         [](const EventStream::Event& a, const EventStream::Event& b) {
+                             return a.header.id < b.header.id;
+                         });
+    }
+    return out.size() - first;
+}
+
+size_t StorageEngine::queryRange(std::string_view topic, uint64_t fromTs, uint64_t toTs,
+                                 std::vector<EventStream::Event>& out, TimeTopicIndex::QueryStats* stats) {
+    if (!topic.empty()) return queryPartition(*partitions[partitionOf(topic)], topic, fromTs, toTs, out, stats);
+
+    TimeTopicIndex::QueryStats total;
+    size_t count = 0;
+    for (auto& partition : partitions) {
+        TimeTopicIndex::QueryStats local;
+        count += queryPartition(*partition, topic, fromTs, toTs, out, &local);
+        total.segments += local.segments;
+        total.segments_skipped += local.segments_skipped;
+        total.blocks += local.blocks;
+        total.blocks_skipped += local.blocks_skipped;
+    }
+    if (stats) *stats = total;
+    return count;
+}
+
+size_t StorageEngine::queryPartition(Partition& partition, std::string_view topic, uint64_t fromTs, uint64_t toTs,
+                                     std::vector<EventStream::Event>& out, TimeTopicIndex::QueryStats* stats) {
+    std::optional<uint64_t> hash;
+    if (!topic.empty()) hash = RecordFormat::topicHash(topic);
+    std::vector<TimeTopicIndex::Candidate> candidates;
+    partition.log.waitForIndexes();
+    if (cached) {
+        // Recovery is complete, so the newest timestamp it found is final
+        auto served = partition.cache.query(hash, topic, fromTs, toTs, partition.log.recoveredMaxTimestamp(), out);
+        if (served) {
+            cache_range_hits.fetch_add(1, std::memory_order_relaxed);
+            if (stats) *stats = {};
+            return *served;
+        }
+        cache_range_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::shared_lock lock(partition.segments_mutex);
+    partition.log.timeIndex().candidates(hash, fromTs, toTs, candidates, stats);
+
+    size_t count = 0;
+    thread_local std::vector<uint8_t> buffer;
+    for (const auto& candidate : candidates) {
+        auto file = segmentReader(partition, candidate.segment);
+        if (!file) continue;
+        size_t have = 0;
+        if (file->columnar) {
+            if (!file->columnar->read(candidate.begin, candidate.end, buffer)) continue;
+            have = buffer.size();
+        } else {
+            buffer.resize(candidate.end - candidate.begin);
+            while (have < buffer.size()) {
+                ssize_t n = ::pread(file->fd, buffer.data() + have, buffer.size() - have,
+                                    static_cast<off_t>(candidate.begin + have));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) break;
+                have += static_cast<size_t>(n);
+            }
+        }
+
+        // Filter on the key fields; only matches are decoded
+        std::span<const uint8_t> rest(buffer.data(), have);
+        while (!rest.empty()) {
+            RecordFormat::RecordKey key;
+            size_t used = RecordFormat::peek(rest, key);
+            if (used == 0) break;
+            if (key.timestamp >= fromTs && key.timestamp <= toTs && (topic.empty() || key.topic == topic)) {
+                EventStream::Event event;
+                RecordFormat::decode(rest, event);
+                out.push_back(std::move(event));
+                ++count;
+            }
+            rest = rest.subspan(used);
+        }
+    }
+    return count;
+}
+
+std::shared_ptr<const StorageEngine::SegmentFile> StorageEngine::segmentReader(Partition& partition,
+                                                                               uint64_t segment) {
+    {
+        std::shared_lock lock(partition.readers_mutex);
+        if (auto it = partition.readers.find(segment); it != partition.readers.end()) return it->second;
+    }
+    std::unique_lock lock(partition.readers_mutex);
+    if (auto it = partition.readers.find(segment); it != partition.readers.end()) return it->second;
+    auto directory = std::filesystem::path(partition.log.directory());
+    auto file = std::make_shared<SegmentFile>();
+    std::string row = (directory / SegmentedLog::segmentFileName(segment)).string();
+    file->fd = ::open(row.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) {
+        int error = errno;
+        file->columnar = ColumnarSegment::open((directory / ColumnarSegment::fileName(segment)).string());
+        if (!file->columnar) {
+            spdlog::error("Failed to open segment {} for reading: {}", row, std::strerror(error));
+            return nullptr;
+        }
+    }
+    partition.readers.emplace(segment, file);
+    return file;
+}
+
+bool StorageEngine::readRecord(Partition& partition, const OffsetIndex::Location& location,
+                               EventStream::Event& event) {
+    auto file = segmentReader(partition, location.segment);
+    if (!file) return false;
+
+    thread_local std::vector<uint8_t> buffer;
+    if (file->columnar) {
+        size_t block = file->columnar->blockAt(location.offset);
+        if (block == file->columnar->blocks().size() || !file->columnar->decodeBlock(block, buffer)) {
+            spdlog::error("No readable block for offset {} of segment {}", location.offset, location.segment);
+            return false;
+        }
+        size_t at = location.offset - file->columnar->blocks()[block].logical_begin;
+        return RecordFormat::decode(std::span<const uint8_t>(buffer).subspan(at), event) > 0;
+    }
+
+    // Most records fit the first read; a larger one gets a second, exact read
+    size_t want = 512;
+    while (true) {
+        buffer.resize(want);
+        ssize_t n = ::pread(file->fd, buffer.data(), want, static_cast<off_t>(location.offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            spdlog::error("pread of segment {} failed: {}", location.segment, std::strerror(errno));
+            return false;
+        }
+        std::span<const uint8_t> data(buffer.data(), static_cast<size_t>(n));
+        if (RecordFormat::decode(data, event) > 0) return true;
+        size_t needed = RecordFormat::requiredSize(data);
+        if (static_cast<size_t>(n) < want || needed <= want) {
+            spdlog::error("Truncated record at offset {} of segment {}", location.offset, location.segment);
+            return false;
+        }
+        want = needed;
+    }
+}
+
+StorageEngine::TailCacheStats StorageEngine::tailCacheStats() const {
+    TailCacheStats stats;
+    stats.hits = cache_hits.load(std::memory_order_relaxed);
+    stats.misses = cache_misses.load(std::memory_order_relaxed);
+    stats.range_hits = cache_range_hits.load(std::memory_order_relaxed);
+    stats.range_misses = cache_range_misses.load(std::memory_order_relaxed);
+    for (const auto& partition : partitions) {
+        stats.events += partition->cache.events();
+        stats.bytes += partition->cache.bytes();
+    }
+    return stats;
+}
+
+size_t StorageEngine::compact() {
+    std::lock_guard lock(pass_mutex);
+    size_t compacted = 0;
+    for (auto& partition : partitions) compacted += compactPartition(*partition);
+    return compacted;
+}
+
+size_t StorageEngine::compactPartition(Partition& partition) {
+    namespace fs = std::filesystem;
+    fs::path directory(partition.log.directory());
+    uint64_t active = partition.log.activeSegment();
+    std::vector<uint64_t> sealed;
+    for (uint64_t segment : SegmentedLog::listSegments(directory.string())) {
+        if (segment < active && fs::exists(directory / SegmentedLog::segmentFileName(segment))) {
+            sealed.push_back(segment);
+        }
+    }
+    if (sealed.size() <= compaction.hot_segments) return 0;
+    sealed.resize(sealed.size() - compaction.hot_segments);
+
+    // What recovery or the writer indexed: a compacted copy must hold the same
+    partition.log.waitForIndexes();
+    std::unordered_map<uint64_t, uint64_t> indexed;
+    for (const auto& range : partition.log.timeIndex().sealedRanges()) indexed.emplace(range.segment, range.records);
+
+    size_t compacted = 0;
+    std::vector<uint8_t> rows;
+    for (uint64_t segment : sealed) {
+        auto expected = indexed.find(segment);
+        if (expected == indexed.end()) continue;
+        fs::path row = directory / SegmentedLog::segmentFileName(segment);
+        fs::path packed = directory / ColumnarSegment::fileName(segment);
+        {
+            std::ifstream in(row, std::ios::binary);
+            if (!in) continue;
+            rows.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        if (ColumnarSegment::write(packed.string(), rows, compaction.block_bytes) == 0) continue;
+        auto file = std::make_shared<SegmentFile>();
+        file->columnar = ColumnarSegment::open(packed.string());
+        if (!file->columnar) {
+            fs::remove(packed);
+            continue;
+        }
+        if (file->columnar->recordCount() != expected->second) {
+            spdlog::error("Compacted segment {} in {} holds {} record(s) where {} are indexed; keeping it row-format",
+                          segment, directory.string(), file->columnar->recordCount(), expected->second);
+            file->columnar.reset();
+            fs::remove(packed);
+            continue;
+        }
+
+        // Lookups already holding the row descriptor finish on it
+        {
+            std::unique_lock lock(partition.readers_mutex);
+            partition.readers[segment] = file;
+        }
+        std::error_code ec;
+        fs::remove(row, ec);
+        spdlog::info("Compacted segment {} in {}: {} -> {} bytes", segment, directory.string(), rows.size(),
+                     file->columnar->storedSize());
+        ++compacted;
+    }
+    return compacted;
+}
+
+StorageEngine::RetentionStats StorageEngine::enforceRetention(uint64_t now_ns) {
+    std::lock_guard lock(pass_mutex);
+    for (auto& partition : partitions) partition->log.waitForIndexes();
+    RetentionStats stats;
+    const RetentionPolicy::Options& options = retention.options();
+    size_t batch = std::max<size_t>(options.delete_batch, 1);
+    size_t done = 0;
+    // Between batches: false once the engine is shutting down
+    auto paced = [&] { return ++done % batch != 0 || pauseMaintenance(options.batch_pause); };
+
+    // By age: expired segments go whole, partly expired ones are filtered
+    if (retention.limitsAge()) {
+        std::optional<uint64_t> all = retention.cutoffForAll(now_ns);
+        std::optional<uint64_t> any = retention.cutoffForAny(now_ns);
+        for (auto& partition : partitions) {
+            for (const auto& range : partition->log.timeIndex().sealedRanges()) {
+                if (range.records == 0) continue;
+                if (all && range.max_ts < *all) {
+                    deleteSegment(*partition, range, stats);
+                } else if (any && range.min_ts < *any) {
+                    auto recheck = partition->retention_recheck.find(range.segment);
+                    if (recheck != partition->retention_recheck.end() && recheck->second > now_ns) continue;
+                    filterSegment(*partition, range, now_ns, stats);
+                } else {
+                    continue;
+                }
+                if (!paced()) return stats;
+            }
+        }
+    }
+
+    // By size: the sealed segments with the oldest newest record go first
+    if (options.max_bytes > 0) {
+        struct Sealed {
+            Partition* partition;
+            TimeTopicIndex::SegmentRange range;
+            uint64_t bytes;
+        };
+        std::vector<Sealed> sealed;
+        uint64_t total = 0;
+        for (auto& partition : partitions) {
+            std::filesystem::path directory(partition->log.directory());
+            uint64_t active = partition->log.activeSegment();
+            std::unordered_map<uint64_t, TimeTopicIndex::SegmentRange> ranges;
+            for (const auto& range : partition->log.timeIndex().sealedRanges()) ranges.emplace(range.segment, range);
+            for (uint64_t segment : SegmentedLog::listSegments(directory.string())) {
+                uint64_t bytes = segmentBytes(directory, segment);
+                total += bytes;
+                if (segment >= active) continue;
+                // A segment without a summary sorts first: nothing says it is recent
+                auto range = ranges.find(segment);
+                sealed.push_back({partition.get(),
+                                  range != ranges.end() ? range->second
+                                                        : TimeTopicIndex::SegmentRange{segment, 0, 0, 0},
+                                  bytes});
+            }
+        }
+        std::sort(sealed.begin(), sealed.end(), [](const Sealed& a, const Sealed& b) {
+            return std::tie(a.range.max_ts, a.range.segment) < std::tie(b.range.max_ts, b.range.segment);
+        });
+        for (const auto& victim : sealed) {
+            if (total <= options.max_bytes) break;
+            deleteSegment(*victim.partition, victim.range, stats);
+            total -= std::min(total, victim.bytes);
+            if (!paced()) return stats;
+        }
+    }
+
+    if (stats.segments_deleted + stats.segments_rewritten > 0) {
+        spdlog::info("Retention in {}: deleted {} and rewrote {} segment(s), dropped {} records, freed {} bytes",
+                     storagePath, stats.segments_deleted, stats.segments_rewritten, stats.records_dropped,
+                     stats.bytes_freed);
+    }
+    return stats;
+}
+
+void StorageEngine::deleteSegment(Partition& partition, const TimeTopicIndex::SegmentRange& range,
+                                  RetentionStats& stats) {
+    uint64_t segment = range.segment;
+    std::filesystem::path directory(partition.log.directory());
+    uint64_t bytes = segmentBytes(directory, segment);
+    {
+        std::unique_lock lock(partition.segments_mutex);
+        partition.log.forgetSegment(segment);
+        std::unique_lock readers(partition.readers_mutex);
+        partition.readers.erase(segment);
+    }
+    // The cache cannot tell which segment a record is in; dropping everything
+    // as old keeps range queries over those timestamps on disk
+    if (range.records > 0) {
+        partition.cache.dropIf([&](std::string_view, uint64_t timestamp) { return timestamp <= range.max_ts; });
+    }
+    // Nothing can find it any more; a crash before the unlink only rebuilds its indexes
+    std::error_code ec;
+    std::filesystem::remove(directory / SegmentedLog::segmentFileName(segment), ec);
+    std::filesystem::remove(directory / ColumnarSegment::fileName(segment), ec);
+    partition.retention_recheck.erase(segment);
+    ++stats.segments_deleted;
+    stats.records_dropped += range.records;
+    stats.bytes_freed += bytes;
+}
+
+void StorageEngine::filterSegment(Partition& partition, const TimeTopicIndex::SegmentRange& range, uint64_t now_ns,
+                                  RetentionStats& stats) {
+    uint64_t segment = range.segment;
+    std::vector<uint8_t> rows;
+    if (!readSegment(partition, segment, rows)) return;
+
+    std::vector<uint8_t> kept;
+    kept.reserve(rows.size());
+    std::vector<RecordFormat::IndexedRecord> index;
+    std::unordered_map<std::string_view, std::optional<uint64_t>> cutoffs;   // topics point into rows
+    uint64_t recheck = UINT64_MAX;
+    uint64_t dropped = 0;
+    std::span<const uint8_t> rest(rows);
+    while (!rest.empty()) {
+        RecordFormat::RecordKey key;
+        size_t used = RecordFormat::peek(rest, key);
+        if (used == 0) break;
+        auto cutoff = cutoffs.find(key.topic);
+        if (cutoff == cutoffs.end()) cutoff = cutoffs.emplace(key.topic, retention.cutoff(key.topic, now_ns)).first;
+        if (cutoff->second && key.timestamp < *cutoff->second) {
+            ++dropped;
+        } else {
+            // The record expires once the cutoff passes its timestamp
+            if (cutoff->second) recheck = std::min(recheck, key.timestamp + (now_ns - *cutoff->second) + 1);
+            index.push_back({key.id, kept.size(), used, key.timestamp, RecordFormat::topicHash(key.topic)});
+            kept.insert(kept.end(), rest.begin(), rest.begin() + static_cast<std::ptrdiff_t>(used));
+        }
+        rest = rest.subspan(used);
+    }
+    if (dropped == 0) {
+        partition.retention_recheck[segment] = recheck;
+        return;
+    }
+    if (index.empty()) {
+        deleteSegment(partition, range, stats);
+        return;
+    }
+
+    // Rewrite in the segment's own format, then swap file, indexes and reader together
+    namespace fs = std::filesystem;
+    fs::path directory(partition.log.directory());
+    fs::path row = directory / SegmentedLog::segmentFileName(segment);
+    bool columnar = !fs::exists(row);
+    std::string target = columnar ? (directory / ColumnarSegment::fileName(segment)).string() : row.string();
+    std::string replacement = target + std::string(SegmentedLog::kReplacementSuffix);
+    uint64_t before = segmentBytes(directory, segment);
+    auto file = std::make_shared<SegmentFile>();
+    if (columnar) {
+        if (ColumnarSegment::write(replacement, kept, compaction.block_bytes) != 0) {
+            file->columnar = ColumnarSegment::open(replacement);
+        }
+    } else if (writeSynced(replacement, kept)) {
+        file->fd = ::open(replacement.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    std::error_code ec;
+    if (!file->columnar && file->fd < 0) {
+        spdlog::error("Failed to rewrite segment {} in {} for retention", segment, directory.string());
+        fs::remove(replacement, ec);
+        return;
+    }
+    {
+        std::unique_lock lock(partition.segments_mutex);
+        try {
+            partition.log.replaceSegment(segment, target, index);
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to replace segment {} in {}: {}", segment, directory.string(), e.what());
+            fs::remove(replacement, ec);
+            return;
+        }
+        std::unique_lock readers(partition.readers_mutex);
+        partition.readers[segment] = file;
+    }
+    partition.cache.dropIf([&](std::string_view topic, uint64_t timestamp) {
+        auto cutoff = retention.cutoff(topic, now_ns);
+        return cutoff && timestamp < *cutoff;
+    });
+    partition.retention_recheck[segment] = recheck;
+    ++stats.segments_rewritten;
+    stats.records_dropped += dropped;
+    stats.bytes_freed += before - std::min(before, segmentBytes(directory, segment));
+}
+
+bool StorageEngine::readSegment(Partition& partition, uint64_t segment, std::vector<uint8_t>& rows) {
+    auto file = segmentReader(partition, segment);
+    if (!file) return false;
+    if (file->columnar) return file->columnar->read(0, file->columnar->logicalSize(), rows);
+    struct stat st{};
+    if (::fstat(file->fd, &st) != 0) return false;
+    rows.resize(static_cast<size_t>(st.st_size));
+    size_t have = 0;
+    while (have < rows.size()) {
+        ssize_t n = ::pread(file->fd, rows.data() + have, rows.size() - have, static_cast<off_t>(have));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        have += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool StorageEngine::pauseMaintenance(std::chrono::milliseconds pause) {
+    std::unique_lock lock(maintenance_mutex);
+    if (pause.count() <= 0) return !maintenance_stopping;
+    return !maintenance_cv.wait_for(lock, pause, [this] { return maintenance_stopping; });
+}
+
+void StorageEngine::maintenanceLoop() {
+    using Clock = std::chrono::steady_clock;
+    const bool retain = retention.options().enable;
+    auto nextCompaction = Clock::now() + compaction.interval;
+    auto nextRetention = Clock::now() + retention.options().interval;
+    std::unique_lock lock(maintenance_mutex);
+    while (true) {
+        auto due = Clock::time_point::max();
+        if (compaction.enable) due = std::min(due, nextCompaction);
+        if (retain) due = std::min(due, nextRetention);
+        if (maintenance_cv.wait_until(lock, due, [this] { return maintenance_stopping; })) return;
+        lock.unlock();
+        // Retention first, so compaction never rewrites what is about to expire
+        if (retain && Clock::now() >= nextRetention) {
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            enforceRetention(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()));
+            nextRetention = Clock::now() + retention.options().interval;
+        }
+        if (compaction.enable && Clock::now() >= nextCompaction) {
+            compact();
+            nextCompaction = Clock::now() + compaction.interval;
+        }
+        lock.lock();
+    }
+}
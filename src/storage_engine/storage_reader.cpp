@@ -0,0 +1,171 @@
+#include "storage_engine/storage_reader.hpp"
+#include "storage_engine/segmented_log.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+StorageReader::StorageReader(std::string directory) : StorageReader(std::move(directory), Position{}) {
+}
+
+StorageReader::StorageReader(std::string directory, Position start)
+    : StorageReader(std::move(directory), start, Position{UINT64_MAX, UINT64_MAX}) {
+}
+
+StorageReader::StorageReader(std::string directory, Position start, Position end)
+    : directory_(std::move(directory)), end_(end) {
+    std::vector<uint64_t> segments = SegmentedLog::listSegments(directory_);
+    auto first = std::lower_bound(segments.begin(), segments.end(), start.segment);
+    if (first != segments.end() && *first == start.segment) {
+        current_ = map(start.segment);
+        offset_ = start.offset;
+    } else if (first != segments.end()) {
+        current_ = map(*first);
+    } else {
+        // Nothing to read yet; next() keeps looking for this segment
+        current_.segment = start.segment;
+        offset_ = start.offset;
+    }
+}
+
+StorageReader::~StorageReader() {
+    unmap(current_);
+    unmap(next_);
+}
+
+bool StorageReader::next(RecordFormat::RecordView& view) {
+    while (true) {
+        if (atEnd()) return false;
+        if (offset_ < current_.size && window()) {
+            size_t used = RecordFormat::decodeView(
+                {current_.data + (offset_ - current_.base), current_.limit - offset_}, view);
+            if (used > 0) {
+                offset_ += used;
+                if (!prefetched_ && current_.size - offset_ < kPrefetchBytes) prefetchNext();
+                return true;
+            }
+        }
+        if (!advance()) return false;
+    }
+}
+
+bool StorageReader::window() {
+    if (offset_ >= current_.base && offset_ < current_.limit) return true;
+    if (!current_.columnar) return false;
+    size_t block = current_.columnar->blockAt(offset_);
+    if (block == current_.columnar->blocks().size() || !current_.columnar->decodeBlock(block, current_.rows)) {
+        return false;
+    }
+    const auto& range = current_.columnar->blocks()[block];
+    current_.data = current_.rows.data();
+    current_.base = range.logical_begin;
+    current_.limit = range.logical_end;
+    return true;
+}
+
+bool StorageReader::advance() {
+    // Records appended since the segment was mapped come first
+    struct stat st{};
+    std::string path = (fs::path(directory_) / SegmentedLog::segmentFileName(current_.segment)).string();
+    if (!current_.columnar && ::stat(path.c_str(), &st) == 0 && static_cast<size_t>(st.st_size) > current_.size) {
+        Mapping grown = map(current_.segment);
+        if (grown.valid && grown.size > current_.size) {
+            unmap(current_);
+            current_ = std::move(grown);
+            return true;
+        }
+        unmap(grown);
+    }
+
+    std::optional<uint64_t> later = nextSegmentAfter(current_.segment);
+    if (!later || *later > end_.segment) return false;
+    if (offset_ < current_.size) {
+        spdlog::warn("Skipping {} unreadable bytes at the end of segment {} in {}",
+                     current_.size - offset_, current_.segment, directory_);
+    }
+
+    Mapping following;
+    if (next_.valid && next_.segment == *later) {
+        following = std::move(next_);
+        next_ = Mapping{};
+    } else {
+        unmap(next_);
+        following = map(*later);
+    }
+    unmap(current_);
+    current_ = std::move(following);
+    current_.segment = *later;
+    offset_ = 0;
+    prefetched_ = false;
+    return true;
+}
+
+void StorageReader::prefetchNext() {
+    prefetched_ = true;
+    std::optional<uint64_t> later = nextSegmentAfter(current_.segment);
+    if (!later || *later > end_.segment) return;
+    next_ = map(*later);
+    if (next_.data && !next_.columnar) {
+        ::madvise(const_cast<uint8_t*>(next_.data), std::min(next_.size, kPrefetchBytes), MADV_WILLNEED);
+    }
+}
+
+bool StorageReader::atEnd() const {
+    return current_.segment > end_.segment || (current_.segment == end_.segment && offset_ >= end_.offset);
+}
+
+StorageReader::Mapping StorageReader::map(uint64_t segment) const {
+    Mapping mapping;
+    mapping.segment = segment;
+    std::string path = (fs::path(directory_) / SegmentedLog::segmentFileName(segment)).string();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        // Compacted: the segment's own mapping is shared, blocks decode on demand
+        mapping.columnar = ColumnarSegment::open((fs::path(directory_) / ColumnarSegment::fileName(segment)).string());
+        if (mapping.columnar) {
+            mapping.valid = true;
+            mapping.size = mapping.columnar->logicalSize();
+        }
+        return mapping;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return mapping;
+    }
+    mapping.valid = true;
+    mapping.size = static_cast<size_t>(st.st_size);
+    if (mapping.size > 0) {
+        void* data = ::mmap(nullptr, mapping.size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            spdlog::error("mmap of {} failed: {}", path, std::strerror(errno));
+            mapping = Mapping{};
+            mapping.segment = segment;
+        } else {
+            ::madvise(data, mapping.size, MADV_SEQUENTIAL);
+            mapping.data = static_cast<const uint8_t*>(data);
+            mapping.limit = mapping.size;
+        }
+    }
+    ::close(fd);
+    return mapping;
+}
+
+void StorageReader::unmap(Mapping& mapping) {
+    if (mapping.data && !mapping.columnar) ::munmap(const_cast<uint8_t*>(mapping.data), mapping.size);
+    mapping = Mapping{};
+}
+
+std::optional<uint64_t> StorageReader::nextSegmentAfter(uint64_t segment) const {
+    std::vector<uint64_t> segments = SegmentedLog::listSegments(directory_);
+    auto it = std::upper_bound(segments.begin(), segments.end(), segment);
+    if (it == segments.end()) return std::nullopt;
+    return *it;
+}
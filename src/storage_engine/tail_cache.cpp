@@ -0,0 +1,108 @@
+#include "storage_engine/tail_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+TailCache::TailCache(size_t capacity_bytes) : ring_(capacity_bytes) {}
+
+void TailCache::insert(const RecordFormat::IndexedRecord& key, std::span<const uint8_t> record) {
+    if (!enabled()) return;
+    size_t size = record.size();
+    std::unique_lock lock(mutex_);
+    if (size > ring_.size()) {
+        lose(key.timestamp);
+        return;
+    }
+    if (head_ + size > ring_.size()) {
+        // Wrap: whatever still lies between head_ and the end is the oldest
+        while (!entries_.empty() && entries_.front().offset >= head_) evictFront();
+        head_ = 0;
+    }
+    while (!entries_.empty() && entries_.front().offset >= head_ && entries_.front().offset < head_ + size) {
+        evictFront();
+    }
+    std::memcpy(ring_.data() + head_, record.data(), size);
+    uint64_t newest = entries_.empty() ? key.timestamp : std::max(entries_.back().newest, key.timestamp);
+    entries_.push_back({key.id, key.timestamp, newest, key.topicHash, head_, size, true});
+    // A repeated id resolves to its newest copy; older ones still serve queries
+    by_id_[key.id] = first_seq_ + entries_.size() - 1;
+    head_ += size;
+    ++live_events_;
+    live_bytes_ += size;
+}
+
+bool TailCache::find(uint64_t id, EventStream::Event& event) const {
+    if (!enabled()) return false;
+    std::shared_lock lock(mutex_);
+    auto it = by_id_.find(id);
+    if (it == by_id_.end()) return false;
+    return RecordFormat::decode(recordOf(entries_[it->second - first_seq_]), event) > 0;
+}
+
+std::optional<size_t> TailCache::query(std::optional<uint64_t> topicHash, std::string_view topic, uint64_t fromTs,
+                                       uint64_t toTs, std::optional<uint64_t> storedFloor,
+                                       std::vector<EventStream::Event>& out) const {
+    if (!enabled()) return std::nullopt;
+    if (storedFloor && fromTs <= *storedFloor) return std::nullopt;
+    std::shared_lock lock(mutex_);
+    if (floor_ && fromTs <= *floor_) return std::nullopt;
+    size_t count = 0;
+    auto first = std::partition_point(entries_.begin(), entries_.end(),
+                                      [fromTs](const Entry& entry) { return entry.newest < fromTs; });
+    for (auto it = first; it != entries_.end(); ++it) {
+        const Entry& entry = *it;
+        if (!entry.live || entry.timestamp < fromTs || entry.timestamp > toTs) continue;
+        if (topicHash && entry.topic_hash != *topicHash) continue;
+        EventStream::Event event;
+        if (RecordFormat::decode(recordOf(entry), event) == 0) continue;
+        if (topicHash && event.topic != topic) continue;
+        out.push_back(std::move(event));
+        ++count;
+    }
+    return count;
+}
+
+void TailCache::dropIf(const std::function<bool(std::string_view topic, uint64_t timestamp)>& expired) {
+    if (!enabled()) return;
+    std::unique_lock lock(mutex_);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const Entry& entry = entries_[i];
+        if (!entry.live) continue;
+        RecordFormat::RecordKey key;
+        if (RecordFormat::peek(recordOf(entry), key) == 0 || !expired(key.topic, entry.timestamp)) continue;
+        lose(entry.timestamp);
+        forget(first_seq_ + i);
+    }
+}
+
+size_t TailCache::events() const {
+    std::shared_lock lock(mutex_);
+    return live_events_;
+}
+
+size_t TailCache::bytes() const {
+    std::shared_lock lock(mutex_);
+    return live_bytes_;
+}
+
+void TailCache::evictFront() {
+    if (entries_.front().live) {
+        lose(entries_.front().timestamp);
+        forget(first_seq_);
+    }
+    entries_.pop_front();
+    ++first_seq_;
+}
+
+void TailCache::forget(uint64_t seq) {
+    Entry& entry = entries_[seq - first_seq_];
+    if (!entry.live) return;
+    entry.live = false;
+    --live_events_;
+    live_bytes_ -= entry.size;
+    if (auto it = by_id_.find(entry.id); it != by_id_.end() && it->second == seq) by_id_.erase(it);
+}
+
+void TailCache::lose(uint64_t timestamp) {
+    floor_ = floor_ ? std::max(*floor_, timestamp) : timestamp;
+}
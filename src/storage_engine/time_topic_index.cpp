@@ -0,0 +1,207 @@
+#include "storage_engine/time_topic_index.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+TimeTopicIndex::TimeTopicIndex(std::string directory, size_t block_bytes)
+    : directory_(std::move(directory)), block_bytes_(block_bytes) {
+}
+
+std::string TimeTopicIndex::summaryFileName(uint64_t segment) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06llu.sum", static_cast<unsigned long long>(segment));
+    return name;
+}
+
+std::string TimeTopicIndex::pathFor(uint64_t segment, const char* suffix) const {
+    return (fs::path(directory_) / (summaryFileName(segment) + suffix)).string();
+}
+
+bool TimeTopicIndex::loadSealed(uint64_t segment) {
+    std::ifstream in(pathFor(segment, ""), std::ios::binary);
+    if (!in) return false;
+
+    FileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != kMagic || header.version != kVersion) {
+        spdlog::warn("Ignoring malformed summary file for segment {} in {}", segment, directory_);
+        return false;
+    }
+    SegmentSummary summary;
+    summary.segment = segment;
+    summary.min_ts = header.min_ts;
+    summary.max_ts = header.max_ts;
+    summary.records = header.records;
+    summary.topics = header.topics;
+    summary.blocks.resize(header.block_count);
+    if (!in.read(reinterpret_cast<char*>(summary.blocks.data()),
+                 static_cast<std::streamsize>(summary.blocks.size() * sizeof(Block))) ||
+        in.peek() != std::ifstream::traits_type::eof()) {
+        spdlog::warn("Ignoring truncated summary file for segment {} in {}", segment, directory_);
+        return false;
+    }
+    std::unique_lock lock(mutex_);
+    insertSealed(std::move(summary));
+    return true;
+}
+
+void TimeTopicIndex::buildSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    SegmentSummary summary;
+    summary.segment = segment;
+    addTo(summary, records);
+    if (!writeSummaryFile(summary)) {
+        spdlog::error("Failed to write summary for segment {} in {}", segment, directory_);
+    }
+    std::unique_lock lock(mutex_);
+    insertSealed(std::move(summary));
+}
+
+void TimeTopicIndex::dropSealed(uint64_t segment) {
+    {
+        std::unique_lock lock(mutex_);
+        std::erase_if(sealed_, [segment](const SegmentSummary& s) { return s.segment == segment; });
+    }
+    std::error_code ec;
+    fs::remove(pathFor(segment, ""), ec);
+}
+
+void TimeTopicIndex::replaceSealed(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    SegmentSummary summary;
+    summary.segment = segment;
+    addTo(summary, records);
+    if (!writeSummaryFile(summary)) {
+        spdlog::error("Failed to write summary for segment {} in {}", segment, directory_);
+    }
+    std::unique_lock lock(mutex_);
+    std::erase_if(sealed_, [segment](const SegmentSummary& s) { return s.segment == segment; });
+    insertSealed(std::move(summary));
+}
+
+void TimeTopicIndex::discardFile(uint64_t segment) {
+    std::error_code ec;
+    fs::remove(pathFor(segment, ""), ec);
+}
+
+std::vector<TimeTopicIndex::SegmentRange> TimeTopicIndex::sealedRanges() const {
+    std::shared_lock lock(mutex_);
+    std::vector<SegmentRange> ranges;
+    ranges.reserve(sealed_.size());
+    for (const auto& summary : sealed_) {
+        ranges.push_back({summary.segment, summary.min_ts, summary.max_ts, summary.records});
+    }
+    return ranges;
+}
+
+void TimeTopicIndex::loadActive(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    SegmentSummary summary;
+    summary.segment = segment;
+    addTo(summary, records);
+    std::unique_lock lock(mutex_);
+    active_ = std::move(summary);
+}
+
+void TimeTopicIndex::add(uint64_t segment, std::span<const RecordFormat::IndexedRecord> records) {
+    std::unique_lock lock(mutex_);
+    active_.segment = segment;
+    addTo(active_, records);
+}
+
+void TimeTopicIndex::seal(uint64_t segment) {
+    // The active summary keeps answering queries until the sealed copy replaces it
+    SegmentSummary summary;
+    {
+        std::shared_lock lock(mutex_);
+        summary = active_;
+    }
+    summary.segment = segment;
+    if (!writeSummaryFile(summary)) {
+        spdlog::error("Failed to persist summary for segment {} in {}; it will be rebuilt on restart",
+                      segment, directory_);
+    }
+    std::unique_lock lock(mutex_);
+    insertSealed(std::move(summary));
+    active_ = SegmentSummary{};
+    active_.segment = segment + 1;
+}
+
+void TimeTopicIndex::addTo(SegmentSummary& summary, std::span<const RecordFormat::IndexedRecord> records) const {
+    for (const auto& record : records) {
+        uint64_t end = record.offset + record.size;
+        // Cut a new block once the current one holds block_bytes_
+        if (summary.blocks.empty() || summary.blocks.back().end - summary.blocks.back().begin >= block_bytes_) {
+            summary.blocks.push_back(Block{record.offset, end, UINT64_MAX, 0, 0, {}});
+        }
+        Block& block = summary.blocks.back();
+        block.end = end;
+        block.min_ts = std::min(block.min_ts, record.timestamp);
+        block.max_ts = std::max(block.max_ts, record.timestamp);
+        block.records++;
+        block.topics.add(record.topicHash);
+
+        summary.min_ts = std::min(summary.min_ts, record.timestamp);
+        summary.max_ts = std::max(summary.max_ts, record.timestamp);
+        summary.records++;
+        summary.topics.add(record.topicHash);
+    }
+}
+
+bool TimeTopicIndex::writeSummaryFile(const SegmentSummary& summary) const {
+    FileHeader header{kMagic, kVersion, summary.blocks.size(), summary.records,
+                      summary.min_ts, summary.max_ts, summary.topics};
+    std::string tmp = pathFor(summary.segment, ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(summary.blocks.data()),
+                  static_cast<std::streamsize>(summary.blocks.size() * sizeof(Block)));
+        if (!out) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, pathFor(summary.segment, ""), ec);
+    return !ec;
+}
+
+void TimeTopicIndex::insertSealed(SegmentSummary&& summary) {
+    auto at = std::lower_bound(sealed_.begin(), sealed_.end(), summary.segment,
+                               [](const SegmentSummary& s, uint64_t seg) { return s.segment < seg; });
+    sealed_.insert(at, std::move(summary));
+}
+
+void TimeTopicIndex::candidates(std::optional<uint64_t> topicHash, uint64_t fromTs, uint64_t toTs,
+                                std::vector<Candidate>& out, QueryStats* stats) const {
+    QueryStats local;
+    auto scan = [&](const SegmentSummary& summary) {
+        local.segments++;
+        if (summary.records == 0 || toTs < summary.min_ts || fromTs > summary.max_ts ||
+            (topicHash && !summary.topics.mightContain(*topicHash))) {
+            local.segments_skipped++;
+            return;
+        }
+        for (const auto& block : summary.blocks) {
+            local.blocks++;
+            if (toTs < block.min_ts || fromTs > block.max_ts ||
+                (topicHash && !block.topics.mightContain(*topicHash))) {
+                local.blocks_skipped++;
+                continue;
+            }
+            if (!out.empty() && out.back().segment == summary.segment && out.back().end == block.begin) {
+                out.back().end = block.end;
+                out.back().min_ts = std::min(out.back().min_ts, block.min_ts);
+            } else {
+                out.push_back({summary.segment, block.begin, block.end, block.min_ts});
+            }
+        }
+    };
+
+    {
+        std::shared_lock lock(mutex_);
+        for (const auto& summary : sealed_) scan(summary);
+        scan(active_);
+    }
+    if (stats) *stats = local;
+}
@@ -0,0 +1,113 @@
+#include "utils/epoch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// One per thread that has pinned, padded so pinning never shares a line
+struct alignas(64) Record {
+    std::atomic<uint64_t> epoch{0};   // 0 while the thread is not pinned
+    std::atomic<bool> owned{true};
+    Record* next = nullptr;
+};
+
+// Push-only: records outlive their threads and are reused
+std::atomic<Record*> records{nullptr};
+std::atomic<uint64_t> global_epoch{1};
+
+struct Retired {
+    uint64_t epoch;   // readers pinned at or before it may still hold p
+    void* p;
+    void (*deleter)(void*);
+};
+
+struct Retirement {
+    std::mutex mutex;
+    std::vector<Retired> pending;
+};
+
+Retirement& retirement() {
+    // Never destroyed: threads may still retire during exit
+    static auto* instance = new Retirement;
+    return *instance;
+}
+
+Record* claimRecord() {
+    for (Record* r = records.load(std::memory_order_acquire); r; r = r->next) {
+        bool free = false;
+        if (!r->owned.load(std::memory_order_relaxed) &&
+            r->owned.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    auto* r = new Record;
+    Record* head = records.load(std::memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    return r;
+}
+
+struct Local {
+    Record* record = nullptr;
+    unsigned depth = 0;
+    ~Local() {
+        if (record) record->owned.store(false, std::memory_order_release);
+    }
+};
+
+thread_local Local t_local;
+
+} // namespace
+
+Epoch::Guard::Guard() {
+    if (t_local.depth++ > 0) return;
+    if (!t_local.record) t_local.record = claimRecord();
+    // Acquire: having seen a retire's epoch bump, the pointer swap before it
+    // is visible too
+    t_local.record->epoch.store(global_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+    // Either a writer scanning records sees this pin, or this thread's next
+    // loads see what the writer unpublished before scanning
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+Epoch::Guard::~Guard() {
+    if (--t_local.depth == 0) t_local.record->epoch.store(0, std::memory_order_release);
+}
+
+void Epoch::retire(void* p, void (*deleter)(void*)) {
+    uint64_t epoch = global_epoch.fetch_add(1, std::memory_order_acq_rel);
+    {
+        Retirement& r = retirement();
+        std::lock_guard lock(r.mutex);
+        r.pending.push_back({epoch, p, deleter});
+    }
+    reclaim();
+}
+
+size_t Epoch::reclaim() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (Record* r = records.load(std::memory_order_acquire); r; r = r->next) {
+        uint64_t epoch = r->epoch.load(std::memory_order_relaxed);
+        if (epoch != 0) oldest = std::min(oldest, epoch);
+    }
+
+    std::vector<Retired> ready;
+    size_t waiting;
+    {
+        Retirement& r = retirement();
+        std::lock_guard lock(r.mutex);
+        auto split = std::partition(r.pending.begin(), r.pending.end(),
+                                    [oldest](const Retired& item) { return item.epoch >= oldest; });
+        ready.assign(split, r.pending.end());
+        r.pending.erase(split, r.pending.end());
+        waiting = r.pending.size();
+    }
+    // Deleters run outside the lock; they may retire in turn
+    for (const Retired& item : ready) item.deleter(item.p);
+    return waiting;
+}
@@ -4,30 +4,31 @@
 #include "eventprocessor/realtime_processor.hpp"
 #include "storage_engine/storage_engine.hpp"
 #include "utils/thread_pool.hpp"
+#include <filesystem>
 
 TEST(EventProcessor, init) {
     using namespace EventStream;
 
     EventBusMulti eventBus;
-    StorageEngine storageEngine("unittest/test_storage.dat");
+    StorageEngine storageEngine("unittest/test_storage");
     ThreadPool workerPool(2);
     RealtimeProcessor eventProcessor(eventBus, storageEngine, &workerPool);
 
     // RealtimeProcessor initializes in constructor
-    std::remove("unittest/test_storage.dat");
+    std::filesystem::remove_all("unittest/test_storage");
 }
 
 TEST(EventProcessor, startStop) {
     using namespace EventStream;
 
     EventBusMulti eventBus;
-    StorageEngine storageEngine("unittest/test_storage.dat");
+    StorageEngine storageEngine("unittest/test_storage");
     ThreadPool workerPool(2);
     RealtimeProcessor eventProcessor(eventBus, storageEngine, &workerPool);
 
     eventProcessor.start();
     eventProcessor.stop();
-    std::remove("unittest/test_storage.dat");
+    std::filesystem::remove_all("unittest/test_storage");
 }
 
 
@@ -35,7 +36,7 @@ TEST(EventProcessor, processLoop){
     using namespace EventStream;
 
     EventBusMulti eventBus;
-    StorageEngine storageEngine("unittest/test_storage.dat");
+    StorageEngine storageEngine("unittest/test_storage");
     ThreadPool workerPool(2);
     RealtimeProcessor eventProcessor(eventBus, storageEngine, &workerPool);
 
@@ -43,11 +44,11 @@ TEST(EventProcessor, processLoop){
 
     // Create and publish a test event
     std::vector<uint8_t> payload = {0x10, 0x20, 0x30};
-    std::unordered_map<std::string, std::string> metadata = {{"key", "value"}};
+    Metadata metadata = {{"key", "value"}};
     Event event = EventFactory::createEvent(EventSourceType::TCP,EventPriority::MEDIUM, std::move(payload), "test_topic", std::move(metadata));
 
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
     eventProcessor.stop();
-    std::remove("unittest/test_storage.dat");
+    std::filesystem::remove_all("unittest/test_storage");
 }
\ No newline at end of file
@@ -1,20 +1,551 @@
 #include <gtest/gtest.h>
 #include "event/EventFactory.hpp"
+#include "event/Dispatcher.hpp"
+#include "event/Checksum.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
 
 TEST(EventFactory , creatEvent) {
     using namespace EventStream;
     
     std::vector<uint8_t> payload = {0x01, 0x02, 0x03};
-    std::unordered_map<std::string, std::string> metadata = {{"key1", "value1"}, {"key2", "value2"}};
+    Metadata metadata = {{"key1", "value1"}, {"key2", "value2"}};
 
     // include routing_key in metadata; topic is a separate argument
-    metadata["routing_key"] = "route1";
+    metadata.set("routing_key", "route1");
     std::string topic = "topic1";
     Event event = EventFactory::createEvent(EventSourceType::UDP, EventPriority::MEDIUM,
                                              std::move(payload), std::move(topic), std::move(metadata));
     EXPECT_EQ(event.header.sourceType, EventSourceType::UDP);
     EXPECT_EQ(event.body.size(), 3);
     EXPECT_EQ(event.topic, "topic1");
+    EXPECT_EQ(event.metadata.size(), 3u);
+    EXPECT_EQ(event.metadata.find("routing_key"), "route1");
+}
+
+
+TEST(Dispatcher, inboundPushPop) {
+    using namespace EventStream;
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+
+    auto evt = makeEvent();
+    evt->header.id = 42;
+    EXPECT_TRUE(dispatcher.tryPush(evt));
+
+    // Not started: queued events are still handed out, then tryPop returns immediately
+    auto popped = dispatcher.tryPop(std::chrono::milliseconds(10));
+    ASSERT_TRUE(popped.has_value());
+    EXPECT_EQ(popped.value()->header.id, 42u);
+    EXPECT_FALSE(dispatcher.tryPop(std::chrono::milliseconds(10)).has_value());
+}
+
+TEST(EventBusMulti, pushPopBatch) {
+    using namespace EventStream;
+    using QueueId = EventBusMulti::QueueId;
+
+    EventBusMulti bus;
+    std::vector<EventPtr> in;
+    for (uint32_t i = 0; i < 10; ++i) {
+        auto evt = makeEvent();
+        evt->header.id = i;
+        in.push_back(evt);
+    }
+    EXPECT_EQ(bus.pushBatch(QueueId::BATCH, in), 10u);
+    EXPECT_EQ(bus.size(QueueId::BATCH), 10u);
+    EXPECT_EQ(bus.size(QueueId::REALTIME), 0u);
+
+    std::vector<EventPtr> out(4);
+    EXPECT_EQ(bus.popBatch(QueueId::BATCH, out, std::chrono::milliseconds(0)), 4u);
+    EXPECT_EQ(out[0]->header.id, 0u);
+    EXPECT_EQ(out[3]->header.id, 3u);
+
+    auto single = bus.pop(QueueId::BATCH, std::chrono::milliseconds(0));
+    ASSERT_TRUE(single.has_value());
+    EXPECT_EQ(single.value()->header.id, 4u);
+
+    std::vector<EventPtr> rest(16);
+    EXPECT_EQ(bus.popBatch(QueueId::BATCH, rest, std::chrono::milliseconds(0)), 5u);
+    EXPECT_EQ(bus.popBatch(QueueId::BATCH, rest, std::chrono::milliseconds(5)), 0u);
+}
+
+TEST(Dispatcher, shardStrategies) {
+    using namespace EventStream;
+
+    Event a;
+    a.topic = "sensor/1";
+    Event b;
+    b.topic = "sensor/2";
+
+    // hash_modulo is stable per topic so per-topic ordering survives sharding
+    auto hash = Dispatcher::makeShardStrategy("hash_modulo");
+    EXPECT_EQ(hash(a, 4), hash(a, 4));
+    EXPECT_LT(hash(b, 4), 4u);
+
+    auto rr = Dispatcher::makeShardStrategy("round_robin");
+    EXPECT_EQ(rr(a, 3), 0u);
+    EXPECT_EQ(rr(a, 3), 1u);
+    EXPECT_EQ(rr(a, 3), 2u);
+    EXPECT_EQ(rr(a, 3), 0u);
+
+    EXPECT_THROW(Dispatcher::makeShardStrategy("random"), std::invalid_argument);
+}
+
+TEST(Dispatcher, shardedRoutingKeepsTopicOrder) {
+    using namespace EventStream;
+    using QueueId = EventBusMulti::QueueId;
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus, 4, 1024);
+    EXPECT_EQ(dispatcher.shardCount(), 4u);
+    dispatcher.start();
+
+    constexpr uint32_t perTopic = 200;
+    for (uint32_t i = 0; i < perTopic; ++i) {
+        for (const char* topic : {"t/a", "t/b", "t/c"}) {
+            auto evt = makeEvent();
+            evt->topic = topic;
+            evt->header.id = i;
+            evt->header.priority = EventPriority::MEDIUM;
+            ASSERT_TRUE(dispatcher.tryPush(evt));
+        }
+    }
+
+    std::unordered_map<std::string, int64_t> last;
+    size_t received = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received < 3 * perTopic && std::chrono::steady_clock::now() < deadline) {
+        auto evt = bus.pop(QueueId::TRANSACTIONAL, std::chrono::milliseconds(10));
+        if (!evt.has_value()) continue;
+        auto it = last.emplace(evt.value()->topic, -1).first;
+        EXPECT_GT(static_cast<int64_t>(evt.value()->header.id), it->second);
+        it->second = evt.value()->header.id;
+        ++received;
+    }
+    dispatcher.stop();
+    EXPECT_EQ(received, 3 * perTopic);
+}
+
+TEST(EventBusMulti, watermarkHysteresis) {
+    using namespace EventStream;
+    using QueueId = EventBusMulti::QueueId;
+
+    EventBusMulti bus;
+    bus.setWatermarks(0.5, 0.25);
+    int resumed = 0;
+    bus.setResumeHandler([&resumed] { ++resumed; });
+
+    // BATCH lane holds 32768: pause at 16384, resume at 8192
+    auto evt = makeEvent();
+    for (int i = 0; i < 16383; ++i) ASSERT_TRUE(bus.push(QueueId::BATCH, evt));
+    EXPECT_FALSE(bus.isPaused());
+    ASSERT_TRUE(bus.push(QueueId::BATCH, evt));
+    EXPECT_TRUE(bus.isPaused());
+
+    std::vector<EventPtr> out(8191);
+    EXPECT_EQ(bus.popBatch(QueueId::BATCH, out, std::chrono::milliseconds(0)), out.size());
+    EXPECT_TRUE(bus.isPaused());
+    ASSERT_TRUE(bus.pop(QueueId::BATCH, std::chrono::milliseconds(0)).has_value());
+    EXPECT_FALSE(bus.isPaused());
+    EXPECT_EQ(resumed, 1);
+
+    EXPECT_THROW(bus.setWatermarks(0.5, 0.6), std::invalid_argument);
+}
+
+TEST(Dispatcher, fullLaneDoesNotDrop) {
+    using namespace EventStream;
+    using QueueId = EventBusMulti::QueueId;
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+    dispatcher.start();
+
+    // More LOW events than the BATCH lane holds, with nobody consuming yet
+    constexpr size_t total = 32768 + 500;
+    for (size_t i = 0; i < total; ++i) {
+        auto evt = makeEvent();
+        evt->header.priority = EventPriority::LOW;
+        ASSERT_TRUE(dispatcher.pushWithBackpressure(evt, std::chrono::milliseconds(1000)));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!dispatcher.isBackpressured() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(dispatcher.isBackpressured());
+
+    std::vector<EventPtr> out(1024);
+    size_t received = 0;
+    while (received < total && std::chrono::steady_clock::now() < deadline) {
+        received += bus.popBatch(QueueId::BATCH, out, std::chrono::milliseconds(10));
+    }
+    dispatcher.stop();
+    EXPECT_EQ(received, total);
+    EXPECT_FALSE(dispatcher.isBackpressured());
+}
+
+TEST(Dispatcher, waitForCapacityClearsStalePause) {
+    using namespace EventStream;
+    using QueueId = EventBusMulti::QueueId;
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+    dispatcher.start();
+
+    // TRANSACTIONAL holds 131072: pause at 13, resume at 6
+    bus.setWatermarks(0.0001, 0.00005);
+    for (int i = 0; i < 13; ++i) ASSERT_TRUE(bus.push(QueueId::TRANSACTIONAL, makeEvent()));
+    ASSERT_TRUE(bus.isPaused());
+
+    std::atomic<bool> returned{false};
+    std::thread waiter([&] {
+        dispatcher.waitForCapacity(std::chrono::milliseconds(300));
+        returned.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Still flagged paused, but every lane is now under its low watermark;
+    // a push through the dispatcher wakes the waiter to notice
+    bus.setWatermarks(0.8, 0.5);
+    ASSERT_TRUE(dispatcher.tryPush(makeEvent()));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!returned.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(returned.load()) << "waitForCapacity deadlocked on a stale pause";
+    waiter.join();
+    EXPECT_FALSE(bus.isPaused());
+    dispatcher.stop();
+}
+
+TEST(Dispatcher, tryPushBatchStopsAtFullShard) {
+    using namespace EventStream;
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus, 2, 4);  // not started: nothing drains the rings
+    dispatcher.setShardStrategy([](const Event& evt, size_t) { return evt.topic == "b" ? 1 : 0; });
+
+    std::vector<EventPtr> batch;
+    for (const char* topic : {"a", "a", "b", "b", "a", "a", "a", "b"}) {
+        auto evt = makeEvent();
+        evt->topic = topic;
+        batch.push_back(std::move(evt));
+    }
+    // Shard 0 holds 4: the 5th "a" does not fit, so the batch stops there
+    EXPECT_EQ(dispatcher.tryPushBatch(batch), 6u);
+    EXPECT_EQ(batch[6]->topic, "a");
+    EXPECT_EQ(batch[7]->topic, "b");
+}
+
+TEST(EventFactory, reservedIdsAreUniqueAndIncreasePerThread) {
+    using namespace EventStream;
+
+    // Blocks of every size, some larger than a lease, from several threads
+    constexpr int threads = 4;
+    std::vector<std::vector<std::pair<uint64_t, size_t>>> blocks(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&blocks, t] {
+            std::mt19937 rng(t);
+            uint64_t end = 0;
+            for (int i = 0; i < 2000; ++i) {
+                size_t count = i % 500 == 0 ? EventFactory::kIdLeaseSize + 1 : 1 + rng() % 64;
+                uint64_t first = EventFactory::reserveIds(count);
+                EXPECT_GE(first, end);
+                end = first + count;
+                blocks[t].emplace_back(first, count);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    std::vector<std::pair<uint64_t, size_t>> all;
+    for (const auto& own : blocks) all.insert(all.end(), own.begin(), own.end());
+    std::sort(all.begin(), all.end());
+    for (size_t i = 1; i < all.size(); ++i) {
+        EXPECT_GE(all[i].first, all[i - 1].first + all[i - 1].second);
+    }
+}
+
+TEST(EventClock, increasesPerThreadAndTracksWallClock) {
+    using namespace EventStream;
+
+    auto wallNow = [] {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    };
+    auto original = EventClock::source();
+    for (auto source : {EventClock::Source::TSC, EventClock::Source::COARSE, EventClock::Source::SYSTEM}) {
+        auto used = EventClock::setSource(source);
+        EXPECT_TRUE(used == source || (source == EventClock::Source::TSC && !EventClock::tscSupported()));
+        SCOPED_TRACE(EventClock::sourceName(used));
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 3; ++t) {
+            workers.emplace_back([&wallNow] {
+                uint64_t last = 0;
+                for (int i = 0; i < 100000; ++i) {
+                    uint64_t now = EventClock::now();
+                    ASSERT_GT(now, last);
+                    last = now;
+                }
+                // Within a few coarse ticks of the system clock
+                uint64_t wall = wallNow();
+                uint64_t now = EventClock::now();
+                EXPECT_LT(now > wall ? now - wall : wall - now, 50'000'000u);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }
+    EventClock::setSource(original);
+}
+
+TEST(Checksum, knownVectors) {
+    using namespace EventStream;
+    const std::string check = "123456789";
+    std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(check.data()), check.size());
+
+    EXPECT_EQ(Checksum::crc32c(data), 0xE3069283u);
+    EXPECT_EQ(Checksum::crc32c(data.subspan(4), Checksum::crc32c(data.first(4))), 0xE3069283u);
+    EXPECT_EQ(Checksum::crc32(data), 0xCBF43926u);
+    EXPECT_EQ(Checksum::compute(ChecksumAlgorithm::CRC32, data), 0xCBF43926u);
+}
+
+TEST(Checksum, kernelsAgree) {
+    using namespace EventStream;
+    std::mt19937 rng(7);
+    std::vector<uint8_t> buffer(64 * 1024 + 16);
+    for (auto& b : buffer) b = static_cast<uint8_t>(rng());
 
+    // Lengths straddle the 3x256 and 3x4096 interleave blocks; offsets misalign
+    for (size_t len : {0ul, 1ul, 7ul, 8ul, 63ul, 767ul, 768ul, 769ul, 5000ul, 12288ul, 12289ul, 40000ul, 65536ul}) {
+        for (size_t offset : {0ul, 3ul}) {
+            std::span<const uint8_t> data(buffer.data() + offset, len);
+            uint32_t expected = Checksum::crc32cBytewise(data);
+            EXPECT_EQ(Checksum::crc32cSlicingBy8(data), expected) << len;
+            EXPECT_EQ(Checksum::crc32c(data), expected) << len;
+            if (Checksum::sse42Supported()) {
+                EXPECT_EQ(Checksum::crc32cSse42(data), expected) << len;
+            }
+            if (Checksum::sse42Supported() && Checksum::pclmulSupported()) {
+                EXPECT_EQ(Checksum::crc32cSse42Pclmul(data), expected) << len;
+            }
+        }
+    }
 }
 
+TEST(EventFactory, recordsChecksumAlgorithm) {
+    using namespace EventStream;
+    std::vector<uint8_t> payload = {'a', 'b', 'c'};
+    Event event = EventFactory::createEvent(EventSourceType::TCP, EventPriority::LOW,
+                                            std::vector<uint8_t>(payload), "t", {});
+    EXPECT_EQ(event.header.checksumAlgo, ChecksumAlgorithm::CRC32C);
+    EXPECT_EQ(event.header.crc32, Checksum::compute(event.header.checksumAlgo, event.body));
+}
+
+TEST(EventPool, recyclesEventsReleasedOnOtherThreads) {
+    using namespace EventStream;
+
+    // Small bodies stay inside the event, larger ones take a pool block
+    Payload small;
+    small.assign(Payload::kInlineBytes, 7);
+    EXPECT_EQ(small.capacity(), Payload::kInlineBytes);
+    Payload large = small;
+    large.resize(1000);
+    EXPECT_GE(large.capacity(), 1000u);
+    EXPECT_EQ(large[Payload::kInlineBytes - 1], 7);
+    EXPECT_EQ(large[Payload::kInlineBytes], 0);
+    Payload moved = std::move(large);
+    EXPECT_EQ(moved.size(), 1000u);
+    EXPECT_TRUE(large.empty());
+
+    // Events a producer makes and a consumer thread drops go back to the
+    // producer's pool: after the first round no more memory is reserved
+    std::thread producer([] {
+        size_t warm = 0;
+        EventPtr kept;
+        for (int round = 0; round < 200; ++round) {
+            std::vector<EventPtr> events;
+            for (uint32_t i = 0; i < 64; ++i) {
+                auto event = makeEvent();
+                event->header.id = i;
+                event->body.assign(500, static_cast<uint8_t>(i));
+                events.push_back(std::move(event));
+            }
+            if (round == 0) kept = events.front();
+            std::thread consumer([batch = std::move(events)]() mutable { batch.clear(); });
+            consumer.join();
+            if (round == 0) warm = EventPool::reservedBytes();
+        }
+        EXPECT_EQ(EventPool::reservedBytes(), warm);
+        EXPECT_EQ(kept->refCount(), 1u);
+        EXPECT_EQ(kept->body, std::vector<uint8_t>(500, 0));
+    });
+    producer.join();
+}
+
+TEST(TopicRegistry, internsOnceAcrossThreads) {
+    using namespace EventStream;
+    using QueueId = EventBusMulti::QueueId;
+
+    // Every thread gets the same dense id for a name, and the id gives the name back
+    std::vector<uint32_t> ids(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < ids.size(); ++t) {
+        threads.emplace_back([&ids, t] {
+            for (int i = 0; i < 100; ++i) ids[t] = TopicRegistry::intern("registry/" + std::to_string(i % 10));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (uint32_t id : ids) EXPECT_EQ(id, ids[0]);
+    EXPECT_LT(ids[0], TopicRegistry::size());
+    EXPECT_EQ(TopicRegistry::name(ids[0]), "registry/9");
+    EXPECT_EQ(TopicRegistry::hash(ids[0]), TopicRegistry::stableHash("registry/9"));
+
+    Topic topic("registry/9");
+    EXPECT_EQ(topic.id(), ids[0]);
+    EXPECT_EQ(topic, "registry/9");
+    EXPECT_NE(topic, Topic("registry/8"));
+    EXPECT_TRUE(Topic().empty());
+    EXPECT_EQ(Topic(""), Topic());
+    EXPECT_FALSE(TopicRegistry::find("registry/never-seen"));
+
+    // Priorities are looked up by id, and routing counts events per topic
+    auto path = std::filesystem::temp_directory_path() / "topic_registry_test.conf";
+    std::ofstream(path) << "registry/critical: CRITICAL  # comment\n\nregistry/low: LOW\n";
+    auto table = std::make_shared<TopicTable>();
+    ASSERT_TRUE(table->LoadFileConfig(path.string()));
+    std::filesystem::remove(path);
+    EventPriority priority;
+    ASSERT_TRUE(table->FoundTopic(Topic("registry/critical"), priority));
+    EXPECT_EQ(priority, EventPriority::CRITICAL);
+    ASSERT_TRUE(table->FoundTopic(std::string("registry/low"), priority));
+    EXPECT_EQ(priority, EventPriority::LOW);
+    EXPECT_FALSE(table->FoundTopic(topic, priority));
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+    dispatcher.setTopicTable(table);
+    auto evt = makeEvent();
+    evt->topic = "registry/critical";
+    evt->header.priority = EventPriority::CRITICAL;
+    EXPECT_EQ(dispatcher.Route(evt), QueueId::REALTIME);
+    evt->topic = "registry/low";
+    EXPECT_EQ(dispatcher.Route(evt), QueueId::BATCH);
+    EXPECT_EQ(dispatcher.Route(evt), QueueId::BATCH);
+    EXPECT_EQ(dispatcher.routedEvents(Topic("registry/critical")), 1u);
+    EXPECT_EQ(dispatcher.routedEvents(Topic("registry/low")), 2u);
+    EXPECT_EQ(dispatcher.routedEvents(topic), 0u);
+}
+
+TEST(Metadata, keepsSmallEntriesInline) {
+    using namespace EventStream;
+
+    Metadata metadata;
+    EXPECT_TRUE(metadata.empty());
+    EXPECT_FALSE(metadata.find("client_address"));
+    metadata.set("client_address", "127.0.0.1:5000");
+    metadata.set(MetadataKey("tenant"), "acme");
+    metadata.set("client_address", "10.0.0.1:1");           // shorter: rewritten in place
+    metadata.set("tenant", "a-much-longer-tenant-name");    // longer: appended
+    EXPECT_EQ(metadata.size(), 2u);
+    EXPECT_EQ(metadata.find("client_address"), "10.0.0.1:1");
+    EXPECT_EQ(metadata.find(MetadataKey("tenant")), "a-much-longer-tenant-name");
+    EXPECT_FALSE(metadata.find("metadata/never-seen"));
+    EXPECT_FALSE(MetadataKey::find("metadata/never-seen"));
+
+    // Past the inline capacity entries and values spill to the pool and
+    // survive copies and moves
+    for (int i = 0; i < 20; ++i) metadata.set("key" + std::to_string(i), std::string(i * 10, 'x'));
+    EXPECT_EQ(metadata.size(), 22u);
+    Metadata copy = metadata;
+    Metadata moved = std::move(metadata);
+    EXPECT_TRUE(metadata.empty());
+    for (const Metadata* m : {&copy, &moved}) {
+        EXPECT_EQ(m->find("key19"), std::string(190, 'x'));
+        EXPECT_EQ(m->find("client_address"), "10.0.0.1:1");
+    }
+    std::vector<std::string> keys;
+    copy.forEach([&keys](std::string_view key, std::string_view) { keys.emplace_back(key); });
+    ASSERT_EQ(keys.size(), 22u);
+    EXPECT_EQ(keys[0], "client_address");
+    EXPECT_EQ(keys[21], "key19");
+
+    metadata = copy;
+    EXPECT_EQ(metadata.find("key0"), "");
+    metadata.clear();
+    EXPECT_TRUE(metadata.empty());
+    metadata.set("tenant", "b");
+    EXPECT_EQ(metadata.find("tenant"), "b");
+    EXPECT_THROW(metadata.set("tenant", std::string(Metadata::kMaxValueBytes + 1, 'x')), std::length_error);
+}
+
+TEST(TopicTable, reloadsWatchedFileAndKeepsTableOnBadEdit) {
+    using namespace EventStream;
+
+    auto dir = std::filesystem::temp_directory_path() / "topic_table_watch_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto path = dir / "topics.conf";
+    std::ofstream(path) << "reload/a: HIGH\n";
+
+    TopicTable table;
+    ASSERT_TRUE(table.LoadFileConfig(path.string()));
+    ASSERT_EQ(table.Version(), 1u);
+
+    // Lookups keep running on other threads while tables are swapped
+    std::atomic<bool> reading{true};
+    std::atomic<size_t> lookups{0};
+    std::thread reader([&] {
+        Topic a("reload/a");
+        while (reading.load(std::memory_order_relaxed)) {
+            EventPriority priority;
+            if (table.FoundTopic(a, priority)) {
+                EXPECT_TRUE(priority == EventPriority::HIGH || priority == EventPriority::LOW);
+            }
+            lookups.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    auto waitForVersion = [&table](uint64_t version) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (table.Version() < version && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return table.Version() >= version;
+    };
+
+    ASSERT_TRUE(table.WatchFile(path.string()));
+    // Rewritten in place
+    std::ofstream(path) << "reload/a: LOW\nreload/b: CRITICAL\n";
+    ASSERT_TRUE(waitForVersion(2));
+    EventPriority priority;
+    ASSERT_TRUE(table.FoundTopic(Topic("reload/b"), priority));
+    EXPECT_EQ(priority, EventPriority::CRITICAL);
+
+    // Replaced by rename; reload/b is gone from the new table
+    std::ofstream(dir / "topics.conf.tmp") << "reload/a: HIGH\n";
+    std::filesystem::rename(dir / "topics.conf.tmp", path);
+    ASSERT_TRUE(waitForVersion(3));
+    EXPECT_FALSE(table.FoundTopic(Topic("reload/b"), priority));
+
+    // A bad line leaves the current table in place
+    EXPECT_FALSE(table.LoadFileConfig((dir / "missing.conf").string()));
+    std::ofstream(dir / "bad.conf") << "reload/a: LOW\nreload/b: URGENT\n";
+    EXPECT_FALSE(table.LoadFileConfig((dir / "bad.conf").string()));
+    EXPECT_EQ(table.Version(), 3u);
+    ASSERT_TRUE(table.FoundTopic(Topic("reload/a"), priority));
+    EXPECT_EQ(priority, EventPriority::HIGH);
+
+    table.StopWatching();
+    reading.store(false);
+    reader.join();
+    EXPECT_GT(lookups.load(), 0u);
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include "replay/replay_engine.hpp"
+#include "storage_engine/storage_engine.hpp"
+#include <filesystem>
+#include <set>
+
+using namespace EventStream;
+
+// count events on topics "a"/"b", HIGH priority, timestamps step_ns apart
+static void writeLog(const std::string& dir, uint32_t count, uint64_t step_ns) {
+    std::filesystem::remove_all(dir);
+    SegmentedLog::Options options;
+    options.segment_bytes = 4096;   // several sealed segments with summaries
+    StorageEngine storage(dir, options);
+    std::vector<EventPtr> batch;
+    for (uint32_t i = 0; i < count; ++i) {
+        auto event = makeEvent();
+        event->header.id = i;
+        event->header.sourceType = EventSourceType::TCP;
+        event->header.priority = EventPriority::HIGH;
+        event->header.timestamp = 1000000 + i * step_ns;
+        event->topic = i % 2 ? "b" : "a";
+        event->body.assign(16, static_cast<uint8_t>(i));
+        batch.push_back(event);
+        if (batch.size() == 20 || i + 1 == count) {
+            storage.appendBatch(batch).get();
+            batch.clear();
+        }
+    }
+}
+
+static std::vector<EventPtr> drain(EventBusMulti& bus, EventBusMulti::QueueId lane) {
+    std::vector<EventPtr> events;
+    while (auto event = bus.pop(lane, std::chrono::milliseconds(50))) events.push_back(*event);
+    return events;
+}
+
+TEST(ReplayEngine, replaysWindowAsInternalEvents) {
+    const std::string dir = "temp_replay_window";
+    writeLog(dir, 600, 1000);
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus, 2);
+    dispatcher.start();
+
+    ReplayEngine::Options options;
+    options.from_ts = 1000000 + 100 * 1000;
+    options.to_ts = 1000000 + 399 * 1000;
+    options.topic = "a";
+    options.readers = 3;
+    ReplayEngine replay(dir, dispatcher, bus, options);
+    replay.start();
+    replay.wait();
+    EXPECT_TRUE(replay.finished());
+    EXPECT_EQ(replay.stats().replayed, 150u);
+    // The summaries kept most of the log from being read at all
+    EXPECT_LT(replay.stats().scanned, 600u);
+
+    // HIGH is capped to MEDIUM, so nothing lands in the REALTIME lane
+    EXPECT_TRUE(drain(bus, EventBusMulti::QueueId::REALTIME).empty());
+    auto events = drain(bus, EventBusMulti::QueueId::TRANSACTIONAL);
+    dispatcher.stop();
+
+    ASSERT_EQ(events.size(), 150u);
+    std::set<uint32_t> ids;
+    for (const auto& event : events) {
+        EXPECT_EQ(event->header.sourceType, EventSourceType::INTERNAL);
+        EXPECT_EQ(event->topic, "a");
+        EXPECT_EQ(event->header.timestamp, 1000000 + event->header.id * 1000ULL);
+        EXPECT_EQ(event->body, std::vector<uint8_t>(16, static_cast<uint8_t>(event->header.id)));
+        ids.insert(event->header.id);
+    }
+    EXPECT_EQ(*ids.begin(), 100u);
+    EXPECT_EQ(*ids.rbegin(), 398u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ReplayEngine, scaledPaceFollowsOriginalSpacing) {
+    const std::string dir = "temp_replay_paced";
+    writeLog(dir, 21, 10'000'000);   // 200ms of original traffic
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+    dispatcher.start();
+
+    ReplayEngine::Options options;
+    options.pace = ReplayEngine::Pace::Scaled;
+    options.speed = 2.0;
+    options.readers = 1;
+    ReplayEngine replay(dir, dispatcher, bus, options);
+    auto start = std::chrono::steady_clock::now();
+    replay.start();
+    replay.wait();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    dispatcher.stop();
+
+    EXPECT_EQ(replay.stats().replayed, 21u);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(95));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ReplayEngine, pacedReplayInterleavesPartitions) {
+    const std::string dir = "temp_replay_partitions";
+    std::filesystem::remove_all(dir);
+    constexpr uint64_t step = 10'000'000;
+    {
+        // "a" and "b" land in different partitions, a few records per segment
+        SegmentedLog::Options options;
+        options.segment_bytes = 1024;
+        StorageEngine storage(dir, options, 2);
+        for (uint32_t i = 0; i < 60; ++i) {
+            auto event = makeEvent();
+            event->header.id = i;
+            event->header.priority = EventPriority::HIGH;
+            event->header.timestamp = 1000000 + i * step;
+            event->topic = i % 2 ? "b" : "a";
+            event->body.assign(200, static_cast<uint8_t>(i));
+            storage.appendEvent(*event).get();
+        }
+        ASSERT_NE(storage.partitionOf("a"), storage.partitionOf("b"));
+    }
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+    dispatcher.start();
+
+    ReplayEngine::Options options;
+    options.pace = ReplayEngine::Pace::Scaled;
+    options.speed = 3.0;
+    options.readers = 2;
+    ReplayEngine replay(dir, dispatcher, bus, options);
+    replay.start();
+    replay.wait();
+    auto events = drain(bus, EventBusMulti::QueueId::TRANSACTIONAL);
+    dispatcher.stop();
+
+    // Out of order by at most one step of jitter, not by whole partitions
+    ASSERT_EQ(events.size(), 60u);
+    uint64_t newest = 0;
+    for (const auto& event : events) {
+        EXPECT_GE(event->header.timestamp + step, newest) << event->header.id;
+        newest = std::max(newest, event->header.timestamp);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ReplayEngine, yieldsWhileRealtimeLaneIsBackedUp) {
+    const std::string dir = "temp_replay_yield";
+    writeLog(dir, 100, 1000);
+
+    EventBusMulti bus;
+    Dispatcher dispatcher(bus);
+    dispatcher.start();
+
+    // Live REALTIME traffic nobody has consumed yet
+    for (int i = 0; i < 20; ++i) {
+        auto live = makeEvent();
+        live->topic = "live";
+        bus.push(EventBusMulti::QueueId::REALTIME, live);
+    }
+
+    ReplayEngine::Options options;
+    options.realtime_backlog_limit = 10;
+    ReplayEngine replay(dir, dispatcher, bus, options);
+    replay.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(replay.stats().replayed, 0u);
+    EXPECT_FALSE(replay.finished());
+
+    EXPECT_EQ(drain(bus, EventBusMulti::QueueId::REALTIME).size(), 20u);
+    replay.wait();
+    EXPECT_EQ(replay.stats().replayed, 100u);
+    dispatcher.stop();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ReplayEngine, parsePace) {
+    EXPECT_EQ(ReplayEngine::parsePace("max"), ReplayEngine::Pace::MaxSpeed);
+    EXPECT_EQ(ReplayEngine::parsePace("realtime"), ReplayEngine::Pace::RealTime);
+    EXPECT_EQ(ReplayEngine::parsePace("scaled"), ReplayEngine::Pace::Scaled);
+    EXPECT_THROW(ReplayEngine::parsePace("fast"), std::invalid_argument);
+}
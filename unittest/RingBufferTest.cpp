@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "utils/mpsc_ring.hpp"
+#include <thread>
+#include <vector>
+
+TEST(MpscRingBuffer, fifoAndCapacity) {
+    MpscRingBuffer<int> ring(4);
+    EXPECT_TRUE(ring.tryPush(1));
+    EXPECT_TRUE(ring.tryPush(2));
+    EXPECT_TRUE(ring.tryPush(3));
+    EXPECT_TRUE(ring.tryPush(4));
+    EXPECT_FALSE(ring.tryPush(5));
+    EXPECT_EQ(ring.size(), 4u);
+
+    int v = 0;
+    EXPECT_TRUE(ring.tryPop(v));
+    EXPECT_EQ(v, 1);
+    EXPECT_TRUE(ring.tryPush(5));
+    for (int expected : {2, 3, 4, 5}) {
+        ASSERT_TRUE(ring.tryPop(v));
+        EXPECT_EQ(v, expected);
+    }
+    EXPECT_FALSE(ring.tryPop(v));
+    EXPECT_THROW(MpscRingBuffer<int>(6), std::invalid_argument);
+}
+
+TEST(MpscRingBuffer, multiProducerNoLoss) {
+    constexpr int producers = 8;
+    constexpr int perProducer = 20000;
+    MpscRingBuffer<int> ring(1024);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (int i = 0; i < perProducer; ++i) {
+                while (!ring.tryPush(p * perProducer + i)) std::this_thread::yield();
+            }
+        });
+    }
+
+    // Per-producer FIFO must hold even when producers interleave
+    std::vector<int> lastSeen(producers, -1);
+    int received = 0;
+    while (received < producers * perProducer) {
+        int v;
+        if (!ring.tryPop(v)) continue;
+        int p = v / perProducer;
+        EXPECT_GT(v, lastSeen[p]);
+        lastSeen[p] = v;
+        ++received;
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_TRUE(ring.empty());
+}
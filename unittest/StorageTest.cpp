@@ -1,24 +1,1045 @@
 #include <gtest/gtest.h>
 #include "storage_engine/storage_engine.hpp"
+#include "storage_engine/record_format.hpp"
+#include "storage_engine/storage_reader.hpp"
+#include "storage_engine/block_codec.hpp"
 #include "event/EventFactory.hpp"
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <thread>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+// Reads every record of every segment, in segment order
+static std::vector<EventStream::Event> readAllRecords(const std::string& dir) {
+    std::vector<EventStream::Event> events;
+    std::vector<std::filesystem::path> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() == ".log") segments.push_back(entry.path());
+    }
+    std::sort(segments.begin(), segments.end());
+    for (const auto& path : segments) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::span<const uint8_t> rest(bytes);
+        while (!rest.empty()) {
+            EventStream::Event event;
+            size_t used = RecordFormat::decode(rest, event);
+            if (used == 0) break;
+            events.push_back(std::move(event));
+            rest = rest.subspan(used);
+        }
+    }
+    return events;
+}
 
 TEST(StorageEngine , storeEvent) {
     using namespace EventStream;
 
-    // Create a temporary storage file
-    std::string tempStoragePath = "temp_storage.bin";
+    // Create a temporary storage directory
+    std::string tempStoragePath = "temp_storage";
     {
         StorageEngine storageEngine(tempStoragePath);
 
         // Create a sample event
         std::vector<uint8_t> payload = {0x10, 0x20, 0x30, 0x40};
-        std::unordered_map<std::string, std::string> metadata = {{"meta1", "data1"}};
+        Metadata metadata = {{"meta1", "data1"}};
         Event event = EventFactory::createEvent(EventSourceType::TCP,EventPriority::MEDIUM, std::move(payload), "test_topic", std::move(metadata));
 
         // Store the event
         storageEngine.storeEvent(event);
     }
 
-    // Clean up temporary storage file
-    std::remove(tempStoragePath.c_str());
-}
\ No newline at end of file
+    auto stored = readAllRecords(tempStoragePath);
+    ASSERT_EQ(stored.size(), 1u);
+    EXPECT_EQ(stored[0].topic, "test_topic");
+    EXPECT_EQ(stored[0].body, (std::vector<uint8_t>{0x10, 0x20, 0x30, 0x40}));
+    EXPECT_EQ(stored[0].header.crc32, Checksum::compute(stored[0].header.checksumAlgo, stored[0].body));
+
+    // Clean up temporary storage directory
+    std::filesystem::remove_all(tempStoragePath);
+}
+
+TEST(SegmentedLog, groupCommitFromManyProducers) {
+    using namespace EventStream;
+    const std::string dir = "temp_segmented_log";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 4096;   // force several segment rolls
+    options.sync_policy = SegmentedLog::SyncPolicy::Bytes;
+    options.sync_bytes = 16 * 1024;
+    constexpr int producers = 8;
+    constexpr int perProducer = 200;
+    {
+        StorageEngine storage(dir, options);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&storage, p] {
+                std::vector<std::future<void>> done;
+                for (int i = 0; i < perProducer; ++i) {
+                    Event event;
+                    event.header.id = static_cast<uint32_t>(p * perProducer + i);
+                    event.topic = "p" + std::to_string(p);
+                    event.body.assign(16, static_cast<uint8_t>(i));
+                    done.push_back(storage.appendEvent(event));
+                }
+                for (auto& f : done) f.get();
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+
+    auto stored = readAllRecords(dir);
+    ASSERT_EQ(stored.size(), static_cast<size_t>(producers * perProducer));
+    std::set<uint32_t> ids;
+    std::vector<int> lastPerProducer(producers, -1);
+    for (const auto& event : stored) {
+        ids.insert(event.header.id);
+        // Appends from one producer keep their order
+        int p = std::stoi(std::string(event.topic.name().substr(1)));
+        int i = static_cast<int>(event.header.id) - p * perProducer;
+        EXPECT_GT(i, lastPerProducer[p]);
+        lastPerProducer[p] = i;
+    }
+    EXPECT_EQ(ids.size(), stored.size());
+    size_t segments = std::count_if(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator{},
+                                    [](const auto& entry) { return entry.path().extension() == ".log"; });
+    EXPECT_GT(segments, 1u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(SegmentedLog, appendAfterCloseFails) {
+    const std::string dir = "temp_segmented_log_closed";
+    SegmentedLog log(dir, SegmentedLog::Options{});
+    log.append({1, 2, 3}).get();
+    log.close();
+    EXPECT_THROW(log.append({4}).get(), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(SegmentedLog, directIoWritesTheSameSegmentsAsBuffered) {
+    using namespace EventStream;
+    namespace fs = std::filesystem;
+    const std::string buffered = "temp_segmented_log_buffered";
+    const std::string direct = "temp_segmented_log_direct";
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 16 * 1024;
+    SegmentedLog::Options directOptions = options;
+    directOptions.direct_io = true;
+    directOptions.direct_buffers = 3;
+    directOptions.direct_buffer_bytes = 8192;   // appends straddle buffers, one exceeds a whole buffer
+
+    auto write = [](const std::string& dir, const SegmentedLog::Options& opts, uint32_t first, uint32_t last) {
+        StorageEngine storage(dir, opts);
+        std::vector<std::future<void>> done;
+        for (uint32_t id = first; id < last; ++id) {
+            Event event;
+            event.header.id = id;
+            event.topic = "direct";
+            event.body.assign(id == 77 ? 10000 : id * 37 % 300, static_cast<uint8_t>(id));
+            done.push_back(storage.appendEvent(event));
+        }
+        for (auto& f : done) f.get();
+        // Complete futures mean written and visible
+        Event event;
+        EXPECT_TRUE(storage.retrieveEvent(last - 1, event));
+        EXPECT_EQ(event.body.size(), (last - 1) * 37 % 300);
+    };
+    auto segments = [](const std::string& dir) {
+        std::map<std::string, std::vector<uint8_t>> files;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.path().extension() != ".log") continue;
+            std::ifstream in(entry.path(), std::ios::binary);
+            files[entry.path().filename().string()].assign(std::istreambuf_iterator<char>(in),
+                                                           std::istreambuf_iterator<char>());
+        }
+        return files;
+    };
+
+    for (const auto& dir : {buffered, direct}) fs::remove_all(dir);
+    write(buffered, options, 0, 400);
+    write(direct, directOptions, 0, 400);
+    {
+        SegmentedLog probe(direct + "/probe", directOptions);
+        if (!probe.directIo()) GTEST_SKIP() << "filesystem refuses O_DIRECT";
+    }
+    fs::remove_all(direct + "/probe");
+    EXPECT_GT(segments(direct).size(), 2u);
+    EXPECT_EQ(segments(direct), segments(buffered));
+
+    // Reopened on an unaligned tail, the partial block is carried over
+    write(buffered, options, 400, 450);
+    write(direct, directOptions, 400, 450);
+    EXPECT_EQ(segments(direct), segments(buffered));
+    for (const auto& dir : {buffered, direct}) fs::remove_all(dir);
+}
+
+TEST(StorageEngine, retrieveByIdAcrossSegmentsAndRestart) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_index";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 2048;   // many sealed segments with .idx files
+    constexpr uint32_t count = 400;
+
+    // Ids arrive out of order, as they do from concurrent producers
+    std::vector<uint32_t> ids(count);
+    std::iota(ids.begin(), ids.end(), 1000);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(7));
+
+    auto check = [&](StorageEngine& storage) {
+        for (uint32_t id : ids) {
+            Event event;
+            ASSERT_TRUE(storage.retrieveEvent(id, event)) << id;
+            EXPECT_EQ(event.header.id, id);
+            EXPECT_EQ(event.topic, "t" + std::to_string(id % 7));
+            EXPECT_EQ(event.body.size(), id % 64);
+        }
+        Event missing;
+        EXPECT_FALSE(storage.retrieveEvent(999, missing));
+        EXPECT_FALSE(storage.retrieveEvent(1000 + count, missing));
+
+        std::vector<Event> range;
+        EXPECT_EQ(storage.retrieveRange(1100, 1149, range), 50u);
+        for (size_t i = 0; i < range.size(); ++i) EXPECT_EQ(range[i].header.id, 1100 + i);
+    };
+
+    {
+        StorageEngine storage(dir, options);
+        for (size_t i = 0; i < ids.size(); i += 8) {
+            std::vector<EventPtr> batch;
+            for (size_t k = i; k < std::min(ids.size(), i + 8); ++k) {
+                auto event = EventStream::makeEvent();
+                event->header.id = ids[k];
+                event->topic = "t" + std::to_string(ids[k] % 7);
+                event->body.assign(ids[k] % 64, static_cast<uint8_t>(k));
+                batch.push_back(event);
+            }
+            storage.appendBatch(batch).get();
+        }
+        check(storage);
+    }
+
+    size_t indexFiles = std::count_if(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator{},
+                                      [](const auto& entry) { return entry.path().extension() == ".idx"; });
+    EXPECT_GT(indexFiles, 1u);
+
+    // Reopen: sealed segments come back from their index files, the active one
+    // is rescanned, and a deleted index is rebuilt
+    std::filesystem::remove(std::filesystem::path(dir) / OffsetIndex::indexFileName(0));
+    {
+        StorageEngine storage(dir, options);
+        check(storage);
+    }
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(dir) / OffsetIndex::indexFileName(0)));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageEngine, recoveryTruncatesTornTailAndSkipsCorruptRecords) {
+    using namespace EventStream;
+    namespace fs = std::filesystem;
+    const std::string dir = "temp_storage_recovery";
+    fs::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 4096;
+    options.recovery_threads = 2;
+    auto makeEvent = [](uint32_t id) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1000 + id;
+        event->topic = "recovery";
+        event->body.assign(20 + id % 16, static_cast<uint8_t>(id));
+        return event;
+    };
+    auto append = [&](StorageEngine& storage, uint32_t first, uint32_t last) {
+        for (uint32_t id = first; id < last; id += 10) {
+            std::vector<EventPtr> batch;
+            for (uint32_t k = id; k < std::min(last, id + 10); ++k) batch.push_back(makeEvent(k));
+            storage.appendBatch(batch).get();
+        }
+    };
+    {
+        StorageEngine storage(dir, options);
+        append(storage, 0, 300);
+    }
+
+    // Flip a payload byte of the second record of a sealed segment and drop
+    // its indexes, so the background rebuild has to validate it
+    auto segments = SegmentedLog::listSegments(dir);
+    ASSERT_GT(segments.size(), 2u);
+    fs::path sealed = fs::path(dir) / SegmentedLog::segmentFileName(0);
+    std::vector<uint8_t> bytes;
+    {
+        std::ifstream in(sealed, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    size_t first = RecordFormat::requiredSize(bytes);
+    size_t second = RecordFormat::requiredSize(std::span<const uint8_t>(bytes).subspan(first));
+    bytes[first + second - 1] ^= 0xff;
+    std::ofstream(sealed, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(bytes.data()),
+                                                                     static_cast<std::streamsize>(bytes.size()));
+    fs::remove(fs::path(dir) / OffsetIndex::indexFileName(0));
+    fs::remove(fs::path(dir) / TimeTopicIndex::summaryFileName(0));
+
+    // Half of a record at the end of the active segment, as a crash mid-write leaves it
+    fs::path active = fs::path(dir) / SegmentedLog::segmentFileName(segments.back());
+    size_t intact = fs::file_size(active);
+    std::vector<uint8_t> torn;
+    RecordFormat::encode(*makeEvent(9999), torn);
+    std::ofstream(active, std::ios::binary | std::ios::app).write(reinterpret_cast<const char*>(torn.data()),
+                                                                   static_cast<std::streamsize>(torn.size() / 2));
+
+    {
+        StorageEngine storage(dir, options);
+        EXPECT_EQ(fs::file_size(active), intact);
+        Event event;
+        EXPECT_FALSE(storage.retrieveEvent(1, event));
+        for (uint32_t id : {0u, 2u, 150u, 299u}) EXPECT_TRUE(storage.retrieveEvent(id, event)) << id;
+        append(storage, 300, 320);
+    }
+    // What was appended after the truncation is readable after another restart
+    {
+        StorageEngine storage(dir, options);
+        std::vector<Event> range;
+        EXPECT_EQ(storage.retrieveRange(0, 400, range), 319u);
+        EXPECT_EQ(range.back().header.id, 319u);
+    }
+    EXPECT_TRUE(fs::exists(fs::path(dir) / OffsetIndex::indexFileName(0)));
+    fs::remove_all(dir);
+}
+
+TEST(StorageEngine, queryRangeSkipsSegmentsAndBlocks) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_query";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 32 * 1024;
+    options.summary_block_bytes = 2048;
+    constexpr uint32_t count = 3000;
+    const std::vector<std::string> topics = {"db/error", "db/info", "http/access", "auth/login"};
+
+    auto expected = [&](const std::string& topic, uint64_t from, uint64_t to) {
+        std::vector<uint32_t> ids;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t ts = 1000 + i * 10ULL;
+            if (ts >= from && ts <= to && (topic.empty() || topics[i % topics.size()] == topic)) ids.push_back(i);
+        }
+        return ids;
+    };
+    auto check = [&](StorageEngine& storage, const std::string& topic, uint64_t from, uint64_t to) {
+        std::vector<Event> out;
+        TimeTopicIndex::QueryStats stats;
+        storage.queryRange(topic, from, to, out, &stats);
+        std::vector<uint32_t> ids;
+        for (const auto& event : out) ids.push_back(event.header.id);
+        EXPECT_EQ(ids, expected(topic, from, to)) << topic << " [" << from << ", " << to << "]";
+        return stats;
+    };
+
+    {
+        StorageEngine storage(dir, options);
+        for (uint32_t i = 0; i < count; i += 50) {
+            std::vector<EventPtr> batch;
+            for (uint32_t k = i; k < i + 50; ++k) {
+                auto event = EventStream::makeEvent();
+                event->header.id = k;
+                event->header.timestamp = 1000 + k * 10ULL;
+                event->topic = topics[k % topics.size()];
+                event->body.assign(20, static_cast<uint8_t>(k));
+                batch.push_back(event);
+            }
+            storage.appendBatch(batch).get();
+        }
+
+        // A window of ~6KB of records reads a handful of 2KB blocks
+        auto stats = check(storage, "db/error", 15000, 16000);
+        EXPECT_GT(stats.segments_skipped, 0u);
+        EXPECT_GT(stats.blocks, 0u);
+        EXPECT_LE(stats.blocks - stats.blocks_skipped, 5u);
+        check(storage, "", 0, UINT64_MAX);
+        check(storage, "db/info", 1000, 1000);
+        // An unknown topic is ruled out by the bloom filters almost everywhere
+        auto none = check(storage, "no/such/topic", 0, UINT64_MAX);
+        EXPECT_GT(none.segments_skipped, none.segments / 2);
+    }
+
+    // Reopen with one summary deleted so it is rebuilt from its segment
+    std::filesystem::remove(std::filesystem::path(dir) / TimeTopicIndex::summaryFileName(1));
+    {
+        StorageEngine storage(dir, options);
+        check(storage, "db/error", 15000, 16000);
+        check(storage, "http/access", 20000, 29000);
+    }
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(dir) / TimeTopicIndex::summaryFileName(1)));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageEngine, partitionsByTopicKeepPerTopicOrder) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_partitions";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 4096;
+    constexpr uint32_t writers = 8;
+    constexpr uint32_t perWriter = 300;
+
+    {
+        StorageEngine storage(dir, options, 4);
+        EXPECT_EQ(storage.partitionCount(), 4u);
+        std::vector<std::thread> threads;
+        for (uint32_t w = 0; w < writers; ++w) {
+            threads.emplace_back([&, w] {
+                for (uint32_t i = 0; i < perWriter; i += 10) {
+                    std::vector<EventPtr> batch;
+                    for (uint32_t k = i; k < i + 10; ++k) {
+                        auto event = EventStream::makeEvent();
+                        event->header.id = w * perWriter + k;
+                        event->header.timestamp = k;
+                        event->topic = "topic-" + std::to_string(w);
+                        batch.push_back(event);
+                    }
+                    storage.appendBatch(batch).get();
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        Event event;
+        ASSERT_TRUE(storage.retrieveEvent(5 * perWriter + 17, event));
+        EXPECT_EQ(event.topic, "topic-5");
+        std::vector<Event> range;
+        EXPECT_EQ(storage.retrieveRange(250, 349, range), 100u);
+        for (size_t i = 0; i < range.size(); ++i) EXPECT_EQ(range[i].header.id, 250 + i);
+
+        std::vector<Event> matches;
+        EXPECT_EQ(storage.queryRange("topic-3", 100, 199, matches), 100u);
+        std::vector<Event> all;
+        EXPECT_EQ(storage.queryRange("", 0, UINT64_MAX, all), writers * perWriter);
+    }
+
+    // Every topic lives in exactly one partition, in the order it was written
+    auto directories = StorageEngine::partitionDirectories(dir);
+    ASSERT_EQ(directories.size(), 4u);
+    std::unordered_map<EventStream::Topic, size_t> owner;
+    std::unordered_map<EventStream::Topic, uint64_t> last;
+    for (size_t p = 0; p < directories.size(); ++p) {
+        for (const auto& event : readAllRecords(directories[p])) {
+            auto [it, inserted] = owner.emplace(event.topic, p);
+            EXPECT_EQ(it->second, p) << event.topic;
+            if (!inserted) {
+                EXPECT_GT(event.header.timestamp, last[event.topic]);
+            }
+            last[event.topic] = event.header.timestamp;
+        }
+    }
+    EXPECT_EQ(owner.size(), writers);
+
+    // The layout on disk wins over the requested count
+    {
+        StorageEngine storage(dir, options, 1);
+        EXPECT_EQ(storage.partitionCount(), 4u);
+        Event event;
+        EXPECT_TRUE(storage.retrieveEvent(0, event));
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageReader, iteratesViewsAcrossSegmentsAndFollowsTail) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_reader";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 4096;
+    auto makeEvent = [](uint32_t id) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = id * 7ULL;
+        event->header.priority = EventPriority::HIGH;
+        event->topic = "topic-" + std::to_string(id % 3);
+        event->body.assign(id % 100, static_cast<uint8_t>(id));
+        return event;
+    };
+    auto expectView = [](const RecordFormat::RecordView& view, uint32_t id) {
+        EXPECT_EQ(view.id, id);
+        EXPECT_EQ(view.timestamp, id * 7ULL);
+        EXPECT_EQ(view.priority, EventPriority::HIGH);
+        EXPECT_EQ(view.topic, "topic-" + std::to_string(id % 3));
+        ASSERT_EQ(view.payload.size(), id % 100);
+        for (uint8_t b : view.payload) EXPECT_EQ(b, static_cast<uint8_t>(id));
+    };
+
+    StorageEngine storage(dir, options);
+    for (uint32_t id = 0; id < 300; ++id) storage.appendEvent(*makeEvent(id)).get();
+
+    StorageReader reader(dir);
+    RecordFormat::RecordView view;
+    uint32_t expected = 0;
+    while (reader.next(view)) expectView(view, expected++);
+    EXPECT_EQ(expected, 300u);
+    EXPECT_GT(reader.position().segment, 2u);
+
+    // Nothing new yet; then the reader picks up appends in the same and new segments
+    EXPECT_FALSE(reader.next(view));
+    for (uint32_t id = 300; id < 400; ++id) storage.appendEvent(*makeEvent(id)).get();
+    while (reader.next(view)) expectView(view, expected++);
+    EXPECT_EQ(expected, 400u);
+
+    // Resuming from a saved position
+    StorageReader resumed(dir, {1, 0});
+    ASSERT_TRUE(resumed.next(view));
+    EXPECT_GT(view.id, 0u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(BlockCodec, roundTripsRepetitiveAndRandomData) {
+    std::mt19937 rng(11);
+    std::vector<std::vector<uint8_t>> inputs;
+    inputs.push_back({});
+    inputs.push_back({1, 2, 3});
+    inputs.push_back(std::vector<uint8_t>(100000, 'a'));   // overlapping matches
+    std::vector<uint8_t> text;
+    for (int i = 0; i < 5000; ++i) {
+        std::string line = "{\"sensor\":" + std::to_string(i % 40) + ",\"temp\":" + std::to_string(rng() % 300) + "}";
+        text.insert(text.end(), line.begin(), line.end());
+    }
+    inputs.push_back(text);
+    std::vector<uint8_t> noise(70000);
+    for (auto& b : noise) b = static_cast<uint8_t>(rng());
+    inputs.push_back(noise);
+
+    for (const auto& input : inputs) {
+        std::vector<uint8_t> packed;
+        size_t size = BlockCodec::compress(input, packed);
+        EXPECT_EQ(size, packed.size());
+        EXPECT_LE(size, BlockCodec::maxCompressedSize(input.size()));
+        std::vector<uint8_t> output(input.size());
+        ASSERT_TRUE(BlockCodec::decompress(packed, output));
+        EXPECT_EQ(output, input);
+        if (!input.empty()) {
+            std::vector<uint8_t> wrong(input.size() + 1);
+            EXPECT_FALSE(BlockCodec::decompress(packed, wrong));
+        }
+    }
+    std::vector<uint8_t> packed;
+    EXPECT_LT(BlockCodec::compress(text, packed), text.size() / 2);
+}
+
+TEST(StorageEngine, compactedSegmentsReadTransparently) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_compaction";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 16 * 1024;
+    options.summary_block_bytes = 2048;
+    ColumnarSegment::CompactionOptions compaction;
+    compaction.hot_segments = 1;
+    compaction.block_bytes = 4096;
+    constexpr uint32_t count = 2000;
+
+    auto makeEvent = [](uint32_t id) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1'000'000'000ULL + id * 1000ULL + id % 3;
+        event->header.sourceType = EventSourceType::UDP;
+        event->header.priority = static_cast<EventPriority>(id % 4);
+        event->header.crc32 = id * 2654435761u;
+        event->topic = "sensors/" + std::to_string(id % 5);
+        std::string payload = "{\"sensor\":" + std::to_string(id % 5) + ",\"value\":" + std::to_string(id % 17) + "}";
+        event->body.assign(payload.begin(), payload.end());
+        return event;
+    };
+    auto storedBytes = [&] {
+        size_t bytes = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            auto extension = entry.path().extension();
+            if (extension == ".log" || extension == ".col") bytes += entry.file_size();
+        }
+        return bytes;
+    };
+    auto readAll = [&] {
+        std::vector<std::vector<uint8_t>> records;
+        StorageReader reader(dir);
+        RecordFormat::RecordView view;
+        while (reader.next(view)) {
+            records.emplace_back();
+            RecordFormat::encode(view, records.back());
+        }
+        return records;
+    };
+
+    auto check = [&](StorageEngine& storage, const std::vector<std::vector<uint8_t>>& records,
+                     const std::vector<Event>& queried) {
+        // The same bytes come back through every read path
+        EXPECT_EQ(readAll(), records);
+        for (uint32_t id = 0; id < count; id += 7) {
+            Event event;
+            ASSERT_TRUE(storage.retrieveEvent(id, event)) << id;
+            auto expected = makeEvent(id);
+            EXPECT_EQ(event.header.timestamp, expected->header.timestamp);
+            EXPECT_EQ(event.header.priority, expected->header.priority);
+            EXPECT_EQ(event.header.crc32, expected->header.crc32);
+            EXPECT_EQ(event.topic, expected->topic);
+            EXPECT_EQ(event.body, expected->body);
+        }
+        std::vector<Event> matches;
+        storage.queryRange("sensors/2", 1'000'500'000ULL, 1'001'200'000ULL, matches);
+        ASSERT_EQ(matches.size(), queried.size());
+        for (size_t i = 0; i < matches.size(); ++i) EXPECT_EQ(matches[i].header.id, queried[i].header.id);
+    };
+
+    std::vector<std::vector<uint8_t>> records;
+    std::vector<Event> queried;
+    {
+        StorageEngine storage(dir, options, 1, compaction);
+        for (uint32_t id = 0; id < count; id += 20) {
+            std::vector<EventPtr> batch;
+            for (uint32_t k = id; k < id + 20; ++k) batch.push_back(makeEvent(k));
+            storage.appendBatch(batch).get();
+        }
+        records = readAll();
+        EXPECT_GT(storage.queryRange("sensors/2", 1'000'500'000ULL, 1'001'200'000ULL, queried), 0u);
+        size_t bytesBefore = storedBytes();
+
+        EXPECT_GT(storage.compact(), 5u);
+        EXPECT_EQ(storage.compact(), 0u);
+        EXPECT_LT(storedBytes() * 2, bytesBefore);
+        check(storage, records, queried);
+    }
+
+    // Compacted segments survive a restart, and a lost index is rebuilt from one
+    std::filesystem::remove(std::filesystem::path(dir) / OffsetIndex::indexFileName(0));
+    {
+        StorageEngine storage(dir, options, 1, compaction);
+        check(storage, records, queried);
+    }
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(dir) / OffsetIndex::indexFileName(0)));
+    EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(dir) / SegmentedLog::segmentFileName(0)));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageEngine, compactionKeepsCorruptRecordsAsTheyAre) {
+    using namespace EventStream;
+    namespace fs = std::filesystem;
+    const std::string dir = "temp_storage_compaction_corrupt";
+    fs::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 4096;
+    ColumnarSegment::CompactionOptions compaction;
+    compaction.hot_segments = 1;
+    compaction.block_bytes = 1024;
+    auto makeEvent = [](uint32_t id) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1000 + id;
+        event->topic = "compaction";
+        event->body.assign(20 + id % 16, static_cast<uint8_t>(id));
+        return event;
+    };
+    {
+        StorageEngine storage(dir, options, 1);
+        for (uint32_t id = 0; id < 300; ++id) storage.appendEvent(*makeEvent(id)).get();
+    }
+
+    // Flip a payload byte of the second record of segment 0, behind its indexes' back
+    fs::path sealed = fs::path(dir) / SegmentedLog::segmentFileName(0);
+    std::vector<uint8_t> bytes;
+    {
+        std::ifstream in(sealed, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    size_t first = RecordFormat::requiredSize(bytes);
+    size_t second = RecordFormat::requiredSize(std::span<const uint8_t>(bytes).subspan(first));
+    bytes[first + second - 1] ^= 0xff;
+    std::ofstream(sealed, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(bytes.data()),
+                                                                     static_cast<std::streamsize>(bytes.size()));
+
+    // The indexes still count the record the compacted copy leaves out
+    {
+        StorageEngine storage(dir, options, 1, compaction);
+        EXPECT_GT(storage.compact(), 0u);
+        EXPECT_TRUE(fs::exists(sealed));
+        EXPECT_FALSE(fs::exists(fs::path(dir) / ColumnarSegment::fileName(0)));
+    }
+
+    // Reindexed without it, the segment compacts and decodes back to the same bytes
+    fs::remove(fs::path(dir) / OffsetIndex::indexFileName(0));
+    fs::remove(fs::path(dir) / TimeTopicIndex::summaryFileName(0));
+    {
+        StorageEngine storage(dir, options, 1, compaction);
+        EXPECT_EQ(storage.compact(), 1u);
+        EXPECT_FALSE(fs::exists(sealed));
+        auto columnar = ColumnarSegment::open((fs::path(dir) / ColumnarSegment::fileName(0)).string());
+        ASSERT_TRUE(columnar);
+        std::vector<uint8_t> rows;
+        ASSERT_TRUE(columnar->read(0, columnar->logicalSize(), rows));
+        EXPECT_EQ(rows, bytes);
+    }
+
+    fs::remove(fs::path(dir) / OffsetIndex::indexFileName(0));
+    fs::remove(fs::path(dir) / TimeTopicIndex::summaryFileName(0));
+    {
+        StorageEngine storage(dir, options, 1, compaction);
+        Event event;
+        EXPECT_FALSE(storage.retrieveEvent(1, event));
+        for (uint32_t id : {0u, 2u, 20u, 299u}) {
+            ASSERT_TRUE(storage.retrieveEvent(id, event)) << id;
+            EXPECT_EQ(event.body, makeEvent(id)->body);
+        }
+    }
+    fs::remove_all(dir);
+}
+
+TEST(StorageEngine, retentionDropsExpiredRecordsAndCapsSize) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_retention";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 8 * 1024;
+    options.summary_block_bytes = 1024;
+    ColumnarSegment::CompactionOptions compaction;
+    compaction.hot_segments = 4;
+    compaction.block_bytes = 2048;
+    RetentionPolicy::Options retention;
+    retention.max_age = std::chrono::seconds(2);
+    retention.topic_max_age["short"] = std::chrono::seconds(1);
+    retention.delete_batch = 2;
+    retention.batch_pause = std::chrono::milliseconds(0);
+
+    // One event per millisecond, alternating topics
+    constexpr uint64_t base = 1'000'000'000'000ULL;
+    constexpr uint32_t count = 3000;
+    auto makeEvent = [](uint32_t id) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = base + id * 1'000'000ULL;
+        event->topic = id % 2 ? "short" : "long";
+        std::string payload = "{\"value\":" + std::to_string(id) + "}";
+        event->body.assign(payload.begin(), payload.end());
+        return event;
+    };
+    // At base + 3.5s: "long" keeps the last 2s, "short" the last 1s
+    constexpr uint64_t now = base + 3'500'000'000ULL;
+    auto kept = [](uint32_t id) { return id % 2 ? id >= 2500 : id >= 1500; };
+    auto storedBytes = [&] {
+        size_t bytes = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            auto extension = entry.path().extension();
+            if (extension == ".log" || extension == ".col") bytes += entry.file_size();
+        }
+        return bytes;
+    };
+    auto check = [&](StorageEngine& storage) {
+        for (uint32_t id = 0; id < count; ++id) {
+            Event event;
+            ASSERT_EQ(storage.retrieveEvent(id, event), kept(id)) << id;
+            if (kept(id)) {
+                EXPECT_EQ(event.header.timestamp, makeEvent(id)->header.timestamp);
+            }
+        }
+        std::vector<Event> matches;
+        storage.queryRange("short", 0, UINT64_MAX, matches);
+        ASSERT_EQ(matches.size(), (count - 2500) / 2);
+        for (size_t i = 0; i < matches.size(); ++i) EXPECT_EQ(matches[i].header.id, 2501 + 2 * i);
+        std::vector<Event> range;
+        EXPECT_EQ(storage.retrieveRange(0, count, range), (count - 1500) / 2 + (count - 2500) / 2);
+    };
+
+    {
+        StorageEngine storage(dir, options, 1, compaction, retention);
+        for (uint32_t id = 0; id < count; id += 10) {
+            std::vector<EventPtr> batch;
+            for (uint32_t k = id; k < id + 10; ++k) batch.push_back(makeEvent(k));
+            storage.appendBatch(batch).get();
+        }
+        // Some of the segments retention filters are columnar, some still rows
+        EXPECT_GT(storage.compact(), 0u);
+
+        auto stats = storage.enforceRetention(now);
+        EXPECT_GT(stats.segments_deleted, 0u);
+        EXPECT_GT(stats.segments_rewritten, 0u);
+        EXPECT_EQ(stats.records_dropped, 1500u / 2 + 2500u / 2);
+        EXPECT_GT(stats.bytes_freed, 0u);
+        check(storage);
+
+        // Nothing else expires until the next record does
+        stats = storage.enforceRetention(now);
+        EXPECT_EQ(stats.segments_deleted + stats.segments_rewritten, 0u);
+    }
+
+    // The rewritten segments and their indexes survive a restart
+    {
+        StorageEngine storage(dir, options, 1, compaction, retention);
+        check(storage);
+    }
+
+    // Over max_bytes the oldest sealed segments go, newest records stay
+    size_t before = storedBytes();
+    retention = RetentionPolicy::Options{};
+    retention.max_bytes = before / 2;
+    retention.batch_pause = std::chrono::milliseconds(0);
+    {
+        StorageEngine storage(dir, options, 1, compaction, retention);
+        auto stats = storage.enforceRetention(now);
+        EXPECT_GT(stats.segments_deleted, 0u);
+        EXPECT_LE(storedBytes(), before / 2);
+        EXPECT_EQ(storedBytes() + stats.bytes_freed, before);
+        Event event;
+        EXPECT_FALSE(storage.retrieveEvent(1500, event));
+        EXPECT_TRUE(storage.retrieveEvent(count - 1, event));
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageEngine, tailCacheServesRecentLookupsAndFollowsRetention) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_tail_cache";
+    std::filesystem::remove_all(dir);
+
+    SegmentedLog::Options options;
+    options.segment_bytes = 8 * 1024;
+    options.summary_block_bytes = 1024;
+    constexpr size_t cacheBytes = 32 * 1024;
+    auto makeEvent = [](uint32_t id) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1000 + id;
+        event->topic = id % 2 ? "odd" : "even";
+        event->body.assign(40, static_cast<uint8_t>(id));
+        return event;
+    };
+    auto append = [&](StorageEngine& storage, uint32_t from, uint32_t to) {
+        for (uint32_t id = from; id < to; id += 10) {
+            std::vector<EventPtr> batch;
+            for (uint32_t k = id; k < id + 10; ++k) batch.push_back(makeEvent(k));
+            storage.appendBatch(batch).get();
+        }
+    };
+    auto ids = [](const std::vector<Event>& events) {
+        std::vector<uint32_t> out;
+        for (const auto& event : events) out.push_back(event.header.id);
+        return out;
+    };
+    auto span = [](uint32_t from, uint32_t to, uint32_t step = 1) {
+        std::vector<uint32_t> out;
+        for (uint32_t id = from; id <= to; id += step) out.push_back(id);
+        return out;
+    };
+
+    // Records written before the cache existed are only on disk
+    {
+        StorageEngine storage(dir, options);
+        append(storage, 0, 100);
+    }
+
+    StorageEngine storage(dir, options, 1, {}, {}, cacheBytes);
+    append(storage, 100, 2000);
+    auto stats = storage.tailCacheStats();
+    EXPECT_GT(stats.events, 100u);
+    EXPECT_LT(stats.events, 1900u);
+    EXPECT_LE(stats.bytes, cacheBytes);
+
+    Event event;
+    ASSERT_TRUE(storage.retrieveEvent(1999, event));
+    EXPECT_EQ(event.body, makeEvent(1999)->body);
+    ASSERT_TRUE(storage.retrieveEvent(150, event));   // evicted
+    ASSERT_TRUE(storage.retrieveEvent(50, event));    // never cached
+    EXPECT_FALSE(storage.retrieveEvent(5000, event));
+    stats = storage.tailCacheStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 3u);
+
+    // Only a window above everything evicted is answered from memory
+    std::vector<Event> out;
+    EXPECT_EQ(storage.queryRange("odd", 1000 + 1950, 1000 + 1999, out), 25u);
+    EXPECT_EQ(ids(out), span(1951, 1999, 2));
+    out.clear();
+    EXPECT_EQ(storage.queryRange("", 1000 + 50, 1000 + 1999, out), 1950u);
+    EXPECT_EQ(ids(out), span(50, 1999));
+    stats = storage.tailCacheStats();
+    EXPECT_EQ(stats.range_hits, 1u);
+    EXPECT_EQ(stats.range_misses, 1u);
+
+    // Retention removes expired records from the cache as well as the log
+    RetentionPolicy::Options retention;
+    retention.max_age = std::chrono::seconds(1);
+    retention.batch_pause = std::chrono::milliseconds(0);
+    StorageEngine::TailCacheStats before;
+    {
+        StorageEngine retained(dir + "_retained", options, 1, {}, retention, cacheBytes);
+        append(retained, 0, 2000);
+        before = retained.tailCacheStats();
+        auto dropped = retained.enforceRetention(1000 + 1900 + 1'000'000'000ULL);
+        EXPECT_GT(dropped.records_dropped, 0u);
+        EXPECT_FALSE(retained.retrieveEvent(1850, event));
+        EXPECT_TRUE(retained.retrieveEvent(1900, event));
+        EXPECT_LT(retained.tailCacheStats().events, before.events);
+        out.clear();
+        retained.queryRange("", 0, UINT64_MAX, out);
+        EXPECT_EQ(out.front().header.id, 1900u);
+        out.clear();
+        EXPECT_EQ(retained.queryRange("even", 1000 + 1900, 1000 + 1999, out), 50u);
+        EXPECT_EQ(ids(out), span(1900, 1998, 2));
+        EXPECT_EQ(retained.tailCacheStats().range_hits, 1u);
+    }
+    std::filesystem::remove_all(dir + "_retained");
+    std::filesystem::remove_all(dir);
+}
+
+#ifdef __linux__
+// Caps the size of files this process writes; writes past it fail with EFBIG
+class FileSizeLimit {
+public:
+    explicit FileSizeLimit(rlim_t bytes) : handler_(std::signal(SIGXFSZ, SIG_IGN)) {
+        getrlimit(RLIMIT_FSIZE, &previous_);
+        rlimit limit = previous_;
+        limit.rlim_cur = bytes;
+        setrlimit(RLIMIT_FSIZE, &limit);
+    }
+    ~FileSizeLimit() {
+        setrlimit(RLIMIT_FSIZE, &previous_);
+        std::signal(SIGXFSZ, handler_);
+    }
+
+private:
+    rlimit previous_{};
+    void (*handler_)(int);
+};
+
+TEST(StorageEngine, tailCacheSkipsFailedAppends) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_tail_cache_failed";
+    std::filesystem::remove_all(dir);
+    auto makeEvent = [](uint32_t id, size_t bytes) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1000 + id;
+        event->topic = "failing";
+        event->body.assign(bytes, static_cast<uint8_t>(id));
+        return event;
+    };
+
+    StorageEngine storage(dir, {}, 1, {}, {}, 64 * 1024);
+    std::vector<EventPtr> batch{makeEvent(1, 100)};
+    storage.appendBatch(batch).get();
+    {
+        FileSizeLimit limit(4096);
+        batch = {makeEvent(2, 8192), makeEvent(3, 100)};
+        EXPECT_ANY_THROW(storage.appendBatch(batch).get());
+        EXPECT_ANY_THROW(storage.appendEvent(*makeEvent(4, 8192)).get());
+    }
+
+    Event event;
+    EXPECT_TRUE(storage.retrieveEvent(1, event));
+    for (uint64_t id : {2, 3, 4}) EXPECT_FALSE(storage.retrieveEvent(id, event)) << id;
+    std::vector<Event> out;
+    EXPECT_EQ(storage.queryRange("failing", 0, UINT64_MAX, out), 1u);
+    auto stats = storage.tailCacheStats();
+    EXPECT_EQ(stats.events, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageEngine, failedWriteLeavesNoPartialBatch) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_failed_write";
+    std::filesystem::remove_all(dir);
+    auto makeEvent = [](uint32_t id, size_t bytes) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1000 + id;
+        event->topic = "failing";
+        event->body.assign(bytes, static_cast<uint8_t>(id));
+        return event;
+    };
+
+    {
+        StorageEngine storage(dir);
+        storage.appendEvent(*makeEvent(1, 100)).get();
+        {
+            // The batch gets partly written before the limit stops it
+            FileSizeLimit limit(4096);
+            std::vector<EventPtr> batch{makeEvent(2, 2000), makeEvent(3, 8192)};
+            EXPECT_ANY_THROW(storage.appendBatch(batch).get());
+        }
+        storage.appendEvent(*makeEvent(4, 100)).get();
+
+        Event event;
+        ASSERT_TRUE(storage.retrieveEvent(4, event));
+        EXPECT_EQ(event.body, makeEvent(4, 100)->body);
+    }
+
+    // Recovery finds both acknowledged records and nothing of the failed batch
+    auto stored = readAllRecords(dir);
+    ASSERT_EQ(stored.size(), 2u);
+    EXPECT_EQ(stored[0].header.id, 1u);
+    EXPECT_EQ(stored[1].header.id, 4u);
+    StorageEngine reopened(dir);
+    Event event;
+    EXPECT_TRUE(reopened.retrieveEvent(4, event));
+    EXPECT_FALSE(reopened.retrieveEvent(2, event));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageEngine, failedDirectWriteLeavesNoPartialBatch) {
+    using namespace EventStream;
+    const std::string dir = "temp_storage_failed_direct_write";
+    std::filesystem::remove_all(dir);
+    auto makeEvent = [](uint32_t id, size_t bytes) {
+        auto event = EventStream::makeEvent();
+        event->header.id = id;
+        event->header.timestamp = 1000 + id;
+        event->topic = "failing";
+        event->body.assign(bytes, static_cast<uint8_t>(id));
+        return event;
+    };
+
+    SegmentedLog::Options options;
+    options.direct_io = true;
+    options.direct_buffer_bytes = 4096;   // the batch spans three buffers, the last one fails
+    {
+        SegmentedLog probe(dir + "/probe", options);
+        if (!probe.directIo()) GTEST_SKIP() << "filesystem refuses O_DIRECT";
+    }
+    std::filesystem::remove_all(dir);
+
+    {
+        StorageEngine storage(dir, options);
+        storage.appendEvent(*makeEvent(1, 100)).get();
+        {
+            FileSizeLimit limit(8192);
+            std::vector<EventPtr> batch{makeEvent(2, 3000), makeEvent(3, 8192)};
+            EXPECT_ANY_THROW(storage.appendBatch(batch).get());
+        }
+        // Lands right after id 1, not behind the bytes of the failed batch
+        storage.appendEvent(*makeEvent(4, 100)).get();
+
+        Event event;
+        ASSERT_TRUE(storage.retrieveEvent(4, event));
+        EXPECT_EQ(event.body, makeEvent(4, 100)->body);
+        EXPECT_FALSE(storage.retrieveEvent(2, event));
+    }
+
+    auto stored = readAllRecords(dir);
+    ASSERT_EQ(stored.size(), 2u);
+    EXPECT_EQ(stored[0].header.id, 1u);
+    EXPECT_EQ(stored[1].header.id, 4u);
+    std::filesystem::remove_all(dir);
+}
+#endif